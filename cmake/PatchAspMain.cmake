@@ -0,0 +1,103 @@
+# Applies SSSV's edits to the RSPRecomp output for aspMain (rsp/aspMain.cpp, generated from
+# aspMain.toml), writing the result to OUTPUT:
+# - direct-threaded command dispatch (see sssv_aspmain.h), and
+# - the DMA observer audio capture uses (sssv::aspmain::dma_observer).
+# rsp/aspMain.cpp itself stays exactly as generated, so it can be regenerated at any time.
+# Every edit is anchored on generated code; if an anchor is missing or not unique the build
+# fails here instead of silently producing a ucode without the edit.
+#
+# Usage: cmake -DINPUT=rsp/aspMain.cpp -DOUTPUT=<patched file> -P PatchAspMain.cmake
+
+if(NOT DEFINED INPUT OR NOT DEFINED OUTPUT)
+  message(FATAL_ERROR "PatchAspMain.cmake needs -DINPUT and -DOUTPUT")
+endif()
+
+file(READ "${INPUT}" source)
+
+# Inserts text before or after the one occurrence of anchor.
+function(aspmain_insert where anchor text)
+  string(FIND "${source}" "${anchor}" first)
+  string(FIND "${source}" "${anchor}" last REVERSE)
+  if(first EQUAL -1)
+    message(FATAL_ERROR "aspMain patch: anchor not found in ${INPUT}:\n${anchor}\nRegenerated ucode changed; update cmake/PatchAspMain.cmake.")
+  endif()
+  if(NOT first EQUAL last)
+    message(FATAL_ERROR "aspMain patch: anchor not unique in ${INPUT}:\n${anchor}")
+  endif()
+  if(where STREQUAL "AFTER")
+    string(LENGTH "${anchor}" anchor_length)
+    math(EXPR first "${first} + ${anchor_length}")
+  endif()
+  string(SUBSTRING "${source}" 0 ${first} head)
+  string(SUBSTRING "${source}" ${first} -1 tail)
+  set(source "${head}${text}${tail}" PARENT_SCOPE)
+endfunction()
+
+# The command handlers, in opcode order (sssv::aspmain::command_targets).
+set(command_labels 1118 1470 11DC 1B38 1214 187C 1254 12D0 12EC 1328 140C 1294 1E24 138C 170C 144C)
+foreach(label IN LISTS command_labels)
+  string(FIND "${source}" "\nL_${label}:\n" found)
+  if(found EQUAL -1)
+    message(FATAL_ERROR "aspMain patch: command handler label L_${label} missing from ${INPUT}")
+  endif()
+endforeach()
+
+aspmain_insert(AFTER [==[#include "librecomp/rsp_vu_impl.hpp"
+]==] [==[#include "sssv_aspmain.h"
+
+// Command dispatch. With labels-as-values (GCC/Clang) each command fetch jumps straight to
+// its handler through a table indexed by opcode, as long as the task's DMEM jump table entry
+// is the stock one; every other indirect jump (subroutine returns, or a patched jump table)
+// goes through the switch at do_indirect_jump. Define ASPMAIN_SWITCH_DISPATCH to force the
+// switch for everything (tools/aspmain_dispatch_bench compares the two).
+#if !defined(ASPMAIN_SWITCH_DISPATCH) && (defined(__GNUC__) || defined(__clang__))
+#define ASPMAIN_THREADED_DISPATCH 1
+#else
+#define ASPMAIN_THREADED_DISPATCH 0
+#endif
+
+]==])
+
+aspmain_insert(AFTER [==[RspExitReason aspMain(uint8_t* rdram, [[maybe_unused]] uint32_t ucode_addr) {
+]==] [==[#if ASPMAIN_THREADED_DISPATCH
+    // Same order as sssv::aspmain::command_targets.
+    static void* const command_handlers[sssv::aspmain::kCommandCount] = {
+        &&L_1118, &&L_1470, &&L_11DC, &&L_1B38, &&L_1214, &&L_187C, &&L_1254, &&L_12D0,
+        &&L_12EC, &&L_1328, &&L_140C, &&L_1294, &&L_1E24, &&L_138C, &&L_170C, &&L_144C,
+    };
+#endif
+]==])
+
+# The command fetch: the handler address comes from the jump table at DMEM 0x10.
+aspmain_insert(BEFORE [==[    goto do_indirect_jump;
+    // nop
+
+    // break       0]==] [==[#if ASPMAIN_THREADED_DISPATCH
+    // $1 is the opcode * 2.
+    if ((r1 >> 1) < sssv::aspmain::kCommandCount &&
+        sssv::aspmain::imem_target(jump_target) == sssv::aspmain::command_targets[r1 >> 1]) {
+        goto *command_handlers[r1 >> 1];
+    }
+#endif
+]==])
+
+aspmain_insert(BEFORE [==[    DO_DMA_READ(r3);
+]==] [==[    if (sssv::aspmain::dma_observer != nullptr) {
+        sssv::aspmain::dma_observer(rdram, false, r2, r3);
+    }
+]==])
+
+aspmain_insert(BEFORE [==[    DO_DMA_WRITE(r3);
+]==] [==[    if (sssv::aspmain::dma_observer != nullptr) {
+        sssv::aspmain::dma_observer(rdram, true, r2, r3);
+    }
+]==])
+
+# Only touch the output when it changes, so an unchanged ucode is not rebuilt.
+set(previous "")
+if(EXISTS "${OUTPUT}")
+  file(READ "${OUTPUT}" previous)
+endif()
+if(NOT previous STREQUAL source)
+  file(WRITE "${OUTPUT}" "${source}")
+endif()
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Facts about the aspMain audio microcode shared by the recompiled ucode (rsp/aspMain.cpp,
+// with cmake/PatchAspMain.cmake's edits applied at build time), the audio HLE and the
+// dispatch benchmark.
+//
+// aspMain fetches each command, indexes a halfword jump table at DMEM 0x10 with the opcode
+// (w1 >> 24, 7 bits) and jumps there. The table comes in with the task's ucode data;
+// command_targets holds what SSSV's ucode data puts there, which is also the list of
+// extra_indirect_branch_targets in aspMain.toml.
+
+namespace sssv::aspmain {
+
+constexpr uint32_t kJumpTableAddr = 0x010;
+constexpr size_t kCommandCount = 16;
+
+constexpr uint16_t command_targets[kCommandCount] = {
+	0x1118, // A_SPNOOP
+	0x1470, // A_ADPCM
+	0x11DC, // A_CLEARBUFF
+	0x1B38, // A_ENVMIXER
+	0x1214, // A_LOADBUFF
+	0x187C, // A_RESAMPLE
+	0x1254, // A_SAVEBUFF
+	0x12D0, // A_SEGMENT
+	0x12EC, // A_SETBUFF
+	0x1328, // A_SETVOL
+	0x140C, // A_DMEMMOVE
+	0x1294, // A_LOADADPCM
+	0x1E24, // A_MIXER
+	0x138C, // A_INTERLEAVE
+	0x170C, // A_POLEF
+	0x144C, // A_SETLOOP
+};
+
+// Called by aspMain before each RDRAM DMA it issues, with the DMA registers as the ucode set
+// them (RDRAM address before masking, length minus one). Audio capture installs one for the
+// length of a dry run to find what a task reads and writes; null otherwise. Not thread safe:
+// only the thread running audio tasks may set it.
+using DmaObserver = void (*)(const uint8_t* rdram, bool write, uint32_t dram_addr, uint32_t length_minus_one);
+inline DmaObserver dma_observer = nullptr;
+
+// Jump addresses are compared the way the recompiled ucode's dispatch does, as IMEM addresses.
+constexpr uint32_t imem_target(uint32_t jump_target) {
+	return (jump_target | 0x1000) & 0x1FFF;
+}
+
+} // namespace sssv::aspmain
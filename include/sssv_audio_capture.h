@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Audio task capture and replay.
+//
+// While capture is on, every M_AUDTASK is recorded before it runs: DMEM as the ucode receives
+// it (ucode data and the OSTask at 0xFC0), the RDRAM it reads (command list, samples, codebooks
+// and saved voice state), the RDRAM ranges it writes, and a hash of those ranges after the
+// task has run. The read and write ranges are the DMAs of a dry run of aspMain itself
+// (sssv::aspmain::dma_observer), so tasks the HLE hands back to the ucode are captured too.
+// tools/audio_replay runs a capture
+// back through aspMain and the HLE and checks their output against the recorded hash.
+//
+// File layout: CaptureHeader, then per task a TaskHeader, the DMEM image, input_count
+// Range headers each followed by its bytes, and output_count Range headers. All values and
+// memory images are host-endian, in the word-swapped layout RDRAM and DMEM use in memory.
+
+namespace sssv::audio_hle::capture {
+
+constexpr uint32_t kMagic = 0x50434153u; // "SACP"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kDmemBytes = 0x1000;
+
+struct CaptureHeader {
+	uint32_t magic = kMagic;
+	uint32_t version = kVersion;
+};
+
+struct TaskHeader {
+	uint32_t input_count = 0;
+	uint32_t output_count = 0;
+	uint64_t output_hash = 0;
+};
+
+// Host RDRAM byte offset and length, both multiples of 4.
+struct Range {
+	uint32_t addr = 0;
+	uint32_t size = 0;
+};
+
+static_assert(sizeof(TaskHeader) == 16, "Unexpected TaskHeader size");
+static_assert(sizeof(Range) == 8, "Unexpected Range size");
+
+struct TaskRecord {
+	std::array<uint8_t, kDmemBytes> dmem{};
+	std::vector<Range> inputs;
+	std::vector<uint8_t> input_bytes; // all input ranges back to back
+	std::vector<Range> outputs;
+	uint64_t output_hash = 0;
+};
+
+// FNV-1a over the output ranges of rdram.
+uint64_t hash_outputs(const uint8_t* rdram, const std::vector<Range>& outputs);
+
+// ── Writer (game side) ──────────────────────────────────────────────────
+
+extern std::atomic<bool> g_enabled;
+inline bool enabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+// Starts writing a new capture to path, replacing any existing file.
+bool start(const std::filesystem::path& path);
+void stop();
+
+void write_task(const TaskRecord& task);
+
+// ── Reader (tool side) ──────────────────────────────────────────────────
+
+bool load(const std::filesystem::path& path, std::vector<TaskRecord>& out);
+
+// Copies the task's inputs into rdram and its DMEM image into dmem.
+void apply_task(uint8_t* rdram, uint8_t* dmem_out, const TaskRecord& task);
+
+} // namespace sssv::audio_hle::capture
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "librecomp/rsp.hpp"
+#include "sssv_audio_capture.h"
+
+// High-level emulation of the aspMain audio microcode.
+//
+// aspMain is an ABI1-style audio ucode: an audio task is a list of 64-bit commands that load
+// ADPCM data into DMEM, decode it, resample it, mix it with volume envelopes and interleave
+// the result for the AI. The HLE engine walks that list natively instead of running the
+// recompiled RSP code in rsp/aspMain.cpp. Each command reproduces the RSP's fixed-point
+// arithmetic (VMULF rounding, saturation, the 48-bit accumulator) and reads the ucode's
+// constants from DMEM, so the output is meant to match the LLE sample for sample, including
+// the state it saves to RDRAM and what it leaves in the DMEM buffers.
+//
+// A task is checked before it runs. Anything the engine does not reproduce exactly (POLEF,
+// unknown commands, vector buffers that are not 16-byte aligned, a jump table that differs
+// from the one the engine was written against) runs the whole task through aspMain.
+//
+// Verify mode runs every HLE-capable task both ways on the same input, keeps the LLE result,
+// and logs any RDRAM or DMEM buffer byte that differs together with the time each path took.
+//
+// While audio capture is on (sssv_audio_capture.h), run_task also records each capturable task
+// in every mode, including LLE.
+
+namespace sssv::audio_hle {
+
+enum class Mode {
+	Lle,    // always run rsp/aspMain.cpp
+	Hle,    // HLE, falling back to the LLE per task
+	Verify, // HLE, then LLE on the same input; the LLE output is kept
+};
+
+void set_enabled(bool enabled);
+void set_verify(bool verify);
+Mode mode();
+
+// RspUcodeFunc for M_AUDTASK.
+RspExitReason run_task(uint8_t* rdram, uint32_t ucode_addr);
+
+// The RDRAM the audio task loaded in DMEM will read and write, found from its command list
+// without running it: the command list itself, then every range the commands DMA (samples,
+// codebooks, saved voice state, output), rounded out to whole doublewords. Returns false,
+// listing nothing, for a bad task size or commands the scan does not account for (POLEF and
+// unknown commands).
+bool task_dma_ranges(const uint8_t* rdram, std::vector<capture::Range>& reads, std::vector<capture::Range>& writes);
+
+} // namespace sssv::audio_hle
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+#include "librecomp/rsp.hpp"
+
+// Asynchronous audio task execution.
+//
+// Normally an M_AUDTASK runs to completion inside the RSP task submission, and only then is the
+// SP interrupt raised. With the worker enabled the task is handed to a dedicated thread and the
+// submission returns at once, so completion reaches the game through the same SP interrupt and
+// message path while the ucode is still running. The game gets on with building the next audio
+// frame in parallel.
+//
+// Because the game sees the task as finished, it is free to rebuild the command list, refill
+// sample buffers and update voices while the ucode runs. So before returning, submission copies
+// every range the task reads (sssv::audio_hle::task_dma_ranges: the command list, samples,
+// codebooks and saved voice state) into a private RDRAM image, and the task runs against that.
+// Tasks the scan cannot account for run synchronously in the submission instead.
+//
+// What still reaches the game's RDRAM late is the task's writes: the AI output buffer and the
+// saved ADPCM, resample and envelope state, copied back when the task ends. Those bytes hold
+// their submission-time values until then, including the unwritten parts of the doublewords the
+// ranges are rounded out to. Two points wait for the copy:
+// - submitting the next audio task (it is the only reader of the saved voice state, and
+//   librecomp loads it into DMEM right after get_rsp_microcode returns), and
+// - queue_samples, before the AI buffer is read.
+// Tasks therefore still finish in order, and every sample reaches the audio device exactly
+// when it did before.
+
+namespace sssv::audio_worker {
+
+void set_enabled(bool enabled);
+bool enabled();
+
+// RspUcodeFunc for M_AUDTASK when enabled: snapshots the task's inputs, queues it (run through
+// sssv::audio_hle::run_task) and returns RspExitReason::Broke without waiting.
+RspExitReason submit_task(uint8_t* rdram, uint32_t ucode_addr);
+
+// Blocks until no audio task is queued or running. Cheap when idle.
+void wait_idle();
+
+// Finishes the pending task and joins the worker thread.
+void shutdown();
+
+} // namespace sssv::audio_worker
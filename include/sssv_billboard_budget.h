@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "sssv_billboard_telemetry.h"
+
+// Adaptive LOD / billboard budget.
+//
+// Instead of the all-or-nothing "Disable LOD" switch, the controller keeps the game at its
+// natural frame cadence by sizing two per-frame budgets:
+//   - LOD budget: how many LOD visibility checks per frame get the full-detail override,
+//     nearest to the camera first (the rest keep the game's own distance LOD and billboard
+//     fallback);
+//   - rewrite budget: how many billboards per category take the ortho rewrite path (the
+//     rest use the game's original draw).
+// Frame cost is the interval between display list submissions. The target is the shortest
+// cadence the game has recently held, in whole VI periods. Both budgets grow additively
+// while frames meet the target and are halved when frames run long (AIMD).
+
+namespace sssv::billboard::budget {
+
+constexpr int kLodBudgetMin = 0;
+constexpr int kLodBudgetMax = 512;
+constexpr int kRewriteBudgetMin = 32;
+constexpr int kRewriteBudgetMax = 4096;
+// LOD checks per frame whose distance is kept for the next frame's cutoff.
+constexpr size_t kMaxLodChecks = 4096;
+
+extern std::atomic<bool> g_enabled;
+inline bool enabled() { return g_enabled; }
+
+// Turning the controller on starts both budgets at their maximum.
+void set_enabled(bool enabled);
+
+// Renderer side: call once per display list handed to the renderer.
+void on_display_list_submitted();
+
+// Game side. begin_frame updates the budgets the first time it sees a new frame_key.
+void begin_frame(uint32_t frame_key);
+// Returns true and consumes one unit if this frame's budget still has room. take_lod also
+// needs the check's camera distance: the previous frame's checks set a cutoff so the budget
+// goes to the nearest objects (the cutoff lags by a frame, which keeps it stable).
+bool take_lod(float distance);
+bool take_rewrite(telemetry::Hook hook);
+
+int lod_budget();
+int rewrite_budget();
+// Target frame interval in VI periods, 0 until enough frames have been measured.
+int target_vis();
+
+} // namespace sssv::billboard::budget
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Billboard hook capture and replay.
+//
+// While capture is on, every billboard hook call is appended to a binary trace: the call's
+// registers, stack arguments and display list pointers, preceded by a frame record whenever
+// the game state the rewrite reads (view-projection matrix, screen size, FOV, prim-depth
+// bias) changes. tools/billboard_replay feeds such a trace back through the rewrite against
+// a synthetic RDRAM buffer.
+//
+// File layout: CaptureHeader, then a sequence of FrameRecord / CallRecord, each starting with
+// its RecordType. All values are host-endian.
+
+namespace sssv::billboard::capture {
+
+constexpr uint32_t kMagic = 0x50434253u; // "SBCP"
+constexpr uint32_t kVersion = 1;
+
+struct CaptureHeader {
+	uint32_t magic = kMagic;
+	uint32_t version = kVersion;
+};
+
+enum class RecordType : uint32_t {
+	Frame = 1,
+	Call = 2,
+};
+
+struct FrameRecord {
+	RecordType type = RecordType::Frame;
+	uint32_t dl_state = 0;
+	float vp_mtx[16] = {};
+	int16_t screen_w = 0;
+	int16_t screen_h = 0;
+	float fov_y = 0.0f;
+	int16_t prim_depth_bias = 0;
+	int16_t pad = 0;
+};
+
+struct CallRecord {
+	RecordType type = RecordType::Call;
+	uint32_t hook = 0;            // sssv::billboard::telemetry::Hook
+	uint32_t r4 = 0;              // Gfx** the hook writes through
+	uint32_t r5 = 0;              // world x (16.16)
+	uint32_t r6 = 0;              // world y (16.16)
+	uint32_t r7 = 0;              // world z (16.16)
+	uint32_t r29 = 0;
+	uint32_t stack[6] = {};       // r29 + 0x10 .. r29 + 0x24
+	uint32_t gfx_before = 0;      // *r4 before the rewrite ran
+	uint32_t gfx_after = 0;       // *r4 after the rewrite ran
+};
+
+static_assert(sizeof(FrameRecord) == 84, "Unexpected FrameRecord size");
+static_assert(sizeof(CallRecord) == 60, "Unexpected CallRecord size");
+
+// ── Writer (game side) ──────────────────────────────────────────────────
+
+extern std::atomic<bool> g_enabled;
+inline bool enabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+// Starts writing a new trace to path, replacing any existing file.
+bool start(const std::filesystem::path& path);
+void stop();
+
+// Appends a frame record if it differs from the last one written.
+void write_frame(const FrameRecord& frame);
+void write_call(const CallRecord& call);
+
+// ── Reader / replay (tool side) ─────────────────────────────────────────
+
+struct CaptureFile {
+	std::vector<FrameRecord> frames;
+	std::vector<CallRecord> calls;
+	std::vector<uint32_t> call_frame; // index into frames for each call
+};
+
+bool load(const std::filesystem::path& path, CaptureFile& out);
+
+struct ReplayResult {
+	int outcome = 0;              // RewriteOutcome index, 0 = emitted
+	uint32_t gfx_bytes = 0;       // display list bytes the rewrite wrote
+};
+
+// Implemented next to the rewrite, so the RDRAM layout stays in one place.
+// Writes a frame's game state into rdram at the addresses the rewrite reads from.
+void apply_frame(uint8_t* rdram, const FrameRecord& frame);
+// Re-issues one captured call through the rewrite. gfx_start is the display list write
+// pointer to use instead of the captured one.
+ReplayResult replay_call(uint8_t* rdram, const CallRecord& call, uint32_t gfx_start);
+int outcome_count();
+const char* outcome_name(int outcome);
+
+} // namespace sssv::billboard::capture
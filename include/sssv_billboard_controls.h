@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace sssv::billboard {
 
 void set_disable_6fa3a4_render(bool enabled);
@@ -51,4 +53,28 @@ bool get_rewrite_740820_suppress_original();
 void set_log_73f17c_ortho(bool enabled);
 bool get_log_73f17c_ortho();
 
+// Share one ortho/identity state block across consecutive billboard quads.
+void set_batch_emit(bool enabled);
+bool get_batch_emit();
+
+// Queue billboards and project them four at a time at a flush point.
+void set_deferred_projection(bool enabled);
+bool get_deferred_projection();
+
+// Key billboard interpolation by the drawing object instead of a position hash.
+void set_owner_identity(bool enabled);
+bool get_owner_identity();
+
+// Draw billboards as texture-grouped runs, called from after the last billboard of the display list.
+void set_texture_sort(bool enabled);
+bool get_texture_sort();
+
+// Installs the billboard and LOD hook handlers the current settings need (sssv_hooks.h).
+// The setters above call it; the LOD budget's does too.
+void refresh_hooks();
+
+// Projects any queued billboards and splices texture-sorted ones into the display list
+// starting at dl_addr (0 if unknown). Call before a display list is handed to the renderer.
+void on_display_list_submit(uint8_t* rdram, uint32_t dl_addr);
+
 } // namespace sssv::billboard
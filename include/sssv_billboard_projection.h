@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE4_1__)
+	#include <smmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#include <arm_neon.h>
+#endif
+
+// Billboard projection kernel, shared by the billboard rewrite and
+// tools/billboard_projection, which checks the SIMD path against the scalar one.
+//
+// Projects 16.16 world positions through the game's view-projection matrix into the values
+// the rewrite needs: camera-space Z, the clip_w depth proxy and the 4x-scaled screen center.
+// project_billboard_scalar is the reference implementation. project_billboards_x4 handles
+// four sprites per instruction and performs the same single-precision operations in the
+// same order on every lane (separate mul and add, no FMA), so its results are bit-identical
+// to the scalar path. Every file that includes this one must be built with FP contraction
+// off (-ffp-contract=off on GCC; the pragma below covers Clang).
+
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#endif
+
+namespace sssv::billboard {
+
+struct BillboardProjection {
+	float cam_z = 0.0f;
+	float clip_w = 0.0f;
+	float center_x = 0.0f;
+	float center_y = 0.0f;
+};
+
+constexpr int kProjectLanes = 4;
+
+// Kernel inputs for one batch, SoA. screen_off_* is the screen size * 2, i.e. the screen
+// center in the 4x-scaled coordinate space.
+struct BillboardProjectInputX4 {
+	alignas(16) int32_t world_x[kProjectLanes] = {};
+	alignas(16) int32_t world_y[kProjectLanes] = {};
+	alignas(16) int32_t world_z[kProjectLanes] = {};
+	alignas(16) float screen_off_x[kProjectLanes] = {};
+	alignas(16) float screen_off_y[kProjectLanes] = {};
+};
+
+struct BillboardProjectionX4 {
+	alignas(16) float cam_z[kProjectLanes] = {};
+	alignas(16) float clip_w[kProjectLanes] = {};
+	alignas(16) float center_x[kProjectLanes] = {};
+	alignas(16) float center_y[kProjectLanes] = {};
+};
+
+// Only cam_z and clip_w, which is all the depth-based rejects need; the values are the
+// ones project_billboard_scalar returns.
+inline BillboardProjection project_billboard_depth(const float* vp, int32_t world_x, int32_t world_y, int32_t world_z) {
+	auto m = [vp](int r, int c) -> float {
+		return vp[r * 4 + c];
+	};
+
+	// World coords are 16.16 fixed-point.
+	const float x = static_cast<float>(world_x) / 65536.0f;
+	const float y = static_cast<float>(world_y) / 65536.0f;
+	const float z = static_cast<float>(world_z) / 65536.0f;
+
+	BillboardProjection out;
+	out.cam_z = m(2, 3) + (m(2, 2) * z) + (m(2, 1) * y) + (m(2, 0) * x);
+
+	// Depth proxy used to derive prim-depth (keeps ordering close to original texrect path).
+	out.clip_w = ((m(3, 2) * out.cam_z) + m(3, 3)) / -out.cam_z;
+	return out;
+}
+
+inline BillboardProjection project_billboard_scalar(const float* vp, int32_t world_x, int32_t world_y, int32_t world_z, float screen_off_x, float screen_off_y) {
+	auto m = [vp](int r, int c) -> float {
+		return vp[r * 4 + c];
+	};
+
+	BillboardProjection out = project_billboard_depth(vp, world_x, world_y, world_z);
+
+	const float x = static_cast<float>(world_x) / 65536.0f;
+	const float y = static_cast<float>(world_y) / 65536.0f;
+	const float z = static_cast<float>(world_z) / 65536.0f;
+	const float proj_x = m(0, 3) + (m(0, 2) * z) + (m(0, 1) * y) + (m(0, 0) * x);
+	const float proj_y = m(1, 3) + (m(1, 2) * z) + (m(1, 1) * y) + (m(1, 0) * x);
+
+	// Screen coordinates are in a 4x scaled space (consistent with original path).
+	out.center_x = ((m(3, 0) * proj_x) / out.cam_z) + screen_off_x;
+	out.center_y = ((m(3, 1) * proj_y) / out.cam_z) + screen_off_y;
+	return out;
+}
+
+#if defined(__SSE4_1__)
+
+// SSE path (x64 builds target nehalem, so SSE4.1 is the baseline).
+inline void project_billboards_x4(const float* vp, const BillboardProjectInputX4& in, BillboardProjectionX4& out) {
+	auto m = [vp](int r, int c) -> __m128 {
+		return _mm_set1_ps(vp[r * 4 + c]);
+	};
+	auto load_fixed = [](const int32_t* v) -> __m128 {
+		const __m128 as_float = _mm_cvtepi32_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(v)));
+		return _mm_div_ps(as_float, _mm_set1_ps(65536.0f));
+	};
+
+	const __m128 x = load_fixed(in.world_x);
+	const __m128 y = load_fixed(in.world_y);
+	const __m128 z = load_fixed(in.world_z);
+
+	auto row = [&](int r) -> __m128 {
+		__m128 acc = _mm_add_ps(m(r, 3), _mm_mul_ps(m(r, 2), z));
+		acc = _mm_add_ps(acc, _mm_mul_ps(m(r, 1), y));
+		return _mm_add_ps(acc, _mm_mul_ps(m(r, 0), x));
+	};
+
+	const __m128 cam_z = row(2);
+	const __m128 neg_cam_z = _mm_xor_ps(cam_z, _mm_set1_ps(-0.0f));
+	const __m128 clip_w = _mm_div_ps(_mm_add_ps(_mm_mul_ps(m(3, 2), cam_z), m(3, 3)), neg_cam_z);
+
+	const __m128 proj_x = row(0);
+	const __m128 proj_y = row(1);
+	const __m128 center_x = _mm_add_ps(_mm_div_ps(_mm_mul_ps(m(3, 0), proj_x), cam_z), _mm_load_ps(in.screen_off_x));
+	const __m128 center_y = _mm_add_ps(_mm_div_ps(_mm_mul_ps(m(3, 1), proj_y), cam_z), _mm_load_ps(in.screen_off_y));
+
+	_mm_store_ps(out.cam_z, cam_z);
+	_mm_store_ps(out.clip_w, clip_w);
+	_mm_store_ps(out.center_x, center_x);
+	_mm_store_ps(out.center_y, center_y);
+}
+
+#elif defined(__aarch64__) || defined(_M_ARM64)
+
+// NEON path (AArch64 has IEEE vector division, so no reciprocal estimates are needed).
+inline void project_billboards_x4(const float* vp, const BillboardProjectInputX4& in, BillboardProjectionX4& out) {
+	auto m = [vp](int r, int c) -> float32x4_t {
+		return vdupq_n_f32(vp[r * 4 + c]);
+	};
+	auto load_fixed = [](const int32_t* v) -> float32x4_t {
+		return vdivq_f32(vcvtq_f32_s32(vld1q_s32(v)), vdupq_n_f32(65536.0f));
+	};
+
+	const float32x4_t x = load_fixed(in.world_x);
+	const float32x4_t y = load_fixed(in.world_y);
+	const float32x4_t z = load_fixed(in.world_z);
+
+	auto row = [&](int r) -> float32x4_t {
+		float32x4_t acc = vaddq_f32(m(r, 3), vmulq_f32(m(r, 2), z));
+		acc = vaddq_f32(acc, vmulq_f32(m(r, 1), y));
+		return vaddq_f32(acc, vmulq_f32(m(r, 0), x));
+	};
+
+	const float32x4_t cam_z = row(2);
+	const float32x4_t clip_w = vdivq_f32(vaddq_f32(vmulq_f32(m(3, 2), cam_z), m(3, 3)), vnegq_f32(cam_z));
+
+	const float32x4_t proj_x = row(0);
+	const float32x4_t proj_y = row(1);
+	const float32x4_t center_x = vaddq_f32(vdivq_f32(vmulq_f32(m(3, 0), proj_x), cam_z), vld1q_f32(in.screen_off_x));
+	const float32x4_t center_y = vaddq_f32(vdivq_f32(vmulq_f32(m(3, 1), proj_y), cam_z), vld1q_f32(in.screen_off_y));
+
+	vst1q_f32(out.cam_z, cam_z);
+	vst1q_f32(out.clip_w, clip_w);
+	vst1q_f32(out.center_x, center_x);
+	vst1q_f32(out.center_y, center_y);
+}
+
+#else
+
+inline void project_billboards_x4(const float* vp, const BillboardProjectInputX4& in, BillboardProjectionX4& out) {
+	for (int i = 0; i < kProjectLanes; i++) {
+		const BillboardProjection p = project_billboard_scalar(
+			vp, in.world_x[i], in.world_y[i], in.world_z[i], in.screen_off_x[i], in.screen_off_y[i]);
+		out.cam_z[i] = p.cam_z;
+		out.clip_w[i] = p.clip_w;
+		out.center_x[i] = p.center_x;
+		out.center_y[i] = p.center_y;
+	}
+}
+
+#endif
+
+// NaNs only need to match as NaNs; their payloads are not part of the contract.
+inline bool same_float_bits(float a, float b) {
+	if (std::isnan(a) && std::isnan(b)) {
+		return true;
+	}
+	uint32_t ua, ub;
+	std::memcpy(&ua, &a, sizeof(ua));
+	std::memcpy(&ub, &b, sizeof(ub));
+	return ua == ub;
+}
+
+} // namespace sssv::billboard
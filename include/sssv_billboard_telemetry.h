@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Billboard rewrite telemetry: per-hook counters, per-frame rewrite timing histograms and
+// pool high-water marks, kept in a fixed ring of recent frames.
+// Build with SSSV_BILLBOARD_TELEMETRY=0 to compile the probes out entirely. When compiled
+// in but switched off at runtime, each probe site costs a single flag test.
+#ifndef SSSV_BILLBOARD_TELEMETRY
+	#define SSSV_BILLBOARD_TELEMETRY 1
+#endif
+
+namespace sssv::billboard::telemetry {
+
+enum class Hook : uint8_t {
+	Stars6C5E44 = 0,
+	EnergyItems73F17C,
+	Flowers73F800,
+	Collectibles740094,
+	Trees740820,
+	Count
+};
+
+constexpr int kHookCount = static_cast<int>(Hook::Count);
+
+// Per-call rewrite time buckets in microseconds: [0,1) [1,2) [2,4) ... [32,64) [64,inf).
+constexpr int kTimeBuckets = 8;
+
+// Number of frames kept in the ring (~17 seconds at 60 FPS).
+constexpr size_t kRingFrames = 1024;
+
+struct HookCounters {
+	uint32_t calls = 0;
+	uint32_t emits = 0;
+	uint32_t fails = 0;
+};
+
+struct FrameRecord {
+	uint64_t frame = 0;
+	HookCounters hooks[kHookCount] = {};
+	uint32_t time_hist[kTimeBuckets] = {};
+	uint64_t rewrite_ns = 0;      // total time spent in the rewrite this frame
+	uint32_t max_call_ns = 0;     // slowest single rewrite call this frame
+	int32_t pool_high_water = 0;  // peak billboard pool slots in use
+};
+
+#if SSSV_BILLBOARD_TELEMETRY
+extern std::atomic<bool> g_enabled;
+inline bool enabled() { return g_enabled.load(std::memory_order_relaxed); }
+#else
+constexpr bool enabled() { return false; }
+#endif
+
+// Turning telemetry on clears the ring on the next recorded frame.
+void set_enabled(bool enabled);
+
+// Hot-path probe. Call only when enabled(), from the game thread.
+uint64_t now_ns();
+void record_call(Hook hook, bool emitted, uint64_t elapsed_ns, int32_t pool_used_slots, uint64_t frame);
+
+// Copies up to max_frames of the most recent completed frames, oldest first.
+size_t snapshot(FrameRecord* out, size_t max_frames);
+
+// Writes the ring as CSV (one row per frame). Returns false if nothing was recorded or
+// the file could not be written.
+bool dump_csv(const std::filesystem::path& path);
+
+} // namespace sssv::billboard::telemetry
@@ -15,6 +15,33 @@ namespace sssv {
     // Register all overlays
     void register_overlays();
 
+    // Host code of every recompiled function at one of the given ROM addresses (sorted): from
+    // its entry point to the next recompiled function's. ROM rather than vram, since overlays
+    // that share a vram range would otherwise all match. Used to prefault hot code at startup.
+    struct HostCodeRange {
+        const void* begin;
+        size_t size;
+    };
+    std::vector<HostCodeRange> find_function_host_code(std::span<const uint32_t> sorted_roms);
+
+    // Stops the thread that reads newly loaded overlays' host code ahead.
+    void shutdown_code_prefetch();
+
+    // Every recompiled function, for mapping host code addresses back to the game.
+    struct RecompiledFunction {
+        const void* host;
+        uint32_t vram;
+        uint32_t rom;
+        uint32_t section_rom;
+    };
+    std::vector<RecompiledFunction> get_recompiled_functions();
+
+    // Registers the functions mods can import from "*" (recomp_api.cpp).
+    void register_mod_exports();
+
+    // Installs the trophy collision guard in the patch hook table (sssv_hooks.h).
+    void register_trophy_collision_patch();
+
     // Get thread name for debugging
     std::string get_game_thread_name(const OSThread* t);
 }
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "recomp.h"
+
+// Runtime table for the patch hooks in sssv.us.toml.
+//
+// The functions the recompiled code calls (sssv_hook_lod_visibility and friends) only dispatch
+// through this table. The module behind each hook installs the handler its current settings
+// need whenever a setting changes, or none when the hook has nothing to do, so a disabled hook
+// costs one load and one call to an empty function. Most settings are only read on the config
+// thread, when the handler is chosen. The billboard rewrite handlers also read their ortho and
+// suppress-original settings (atomics) on the game thread each call, since those can change
+// while the handler stays the same.
+//
+// Host code and mods may install an override for any hook; it replaces the built-in handler
+// until removed. Host overrides get the hooked function's live ctx, and can chain to the
+// built-in handler with get_builtin().
+//
+// Mods go through the sssv_set_hook_override export (recomp_api.cpp). Their override is
+// recompiled MIPS that freely clobbers the argument and caller-saved registers, while the hook
+// runs at the hooked function's entry, before it reads its arguments. So a mod override runs
+// on a copy of ctx, and only a0-a3 (r4-r7) are copied back: like the built-in handlers, a mod
+// may change the hooked function's register arguments, and its stack arguments and any other
+// memory through rdram. Every other register, FPRs included, is as if the hook had not run.
+
+namespace sssv::hooks {
+
+using Handler = void (*)(uint8_t* rdram, recomp_context* ctx);
+
+enum class Hook : uint32_t {
+	TrophyCollisionGuard,
+	LodVisibility,
+	Billboard6C5E44,
+	Billboard6FA3A4,
+	Billboard73F17C,
+	Billboard73F800,
+	Billboard740094,
+	Billboard740820,
+	Count
+};
+
+constexpr size_t kHookCount = static_cast<size_t>(Hook::Count);
+
+void noop(uint8_t* rdram, recomp_context* ctx);
+
+extern std::array<std::atomic<Handler>, kHookCount> g_active;
+
+inline void dispatch(Hook hook, uint8_t* rdram, recomp_context* ctx) {
+	g_active[static_cast<size_t>(hook)].load(std::memory_order_acquire)(rdram, ctx);
+}
+
+// nullptr means the hook has nothing to do.
+void set_builtin(Hook hook, Handler handler);
+Handler get_builtin(Hook hook);
+// nullptr removes the override.
+void set_override(Hook hook, Handler handler);
+// Installs a recompiled mod function as the override, under the contract above; nullptr
+// removes the override.
+void set_mod_override(Hook hook, recomp_func_t* func);
+
+// Names are the toml hook functions without the sssv_ prefix, e.g. "hook_billboard_6c5e44".
+bool find(std::string_view name, Hook& out);
+
+} // namespace sssv::hooks
+
+// Installs handler as the override for a hook by name (nullptr removes it). Returns false if
+// no hook has that name. Mods reach it through the export in recomp_api.cpp.
+extern "C" bool sssv_set_hook_override(const char* name, sssv::hooks::Handler handler);
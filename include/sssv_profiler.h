@@ -0,0 +1,26 @@
+#pragma once
+
+#include <filesystem>
+
+// Sampling profiler for the recompiled game code.
+//
+// While running, a timer thread interrupts every game thread about once a millisecond and
+// reads its host instruction pointer. Samples that land in a recompiled function are mapped
+// back to that function's VRAM address and overlay section through the generated section
+// table; the rest count as time outside game code (native patches, librecomp, waits).
+//
+// stop() writes, to the given folder:
+//   profile.folded  "section;function count" lines for flamegraph.pl / speedscope
+//   hot_funcs.txt   the hottest functions' ROM addresses, read by the executable preload
+// and logs the hottest functions and sections. Function names come from sssv.us.syms.toml
+// when it is found in one of the given folders, else func_XXXXXXXX.
+
+namespace sssv::profiler {
+
+// Called on each game thread as it starts, so the sampler knows which threads to interrupt.
+void register_current_thread();
+
+void start();
+void stop(const std::filesystem::path& output_folder, const std::filesystem::path& symbols_folder);
+
+} // namespace sssv::profiler
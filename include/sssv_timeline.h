@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// Frame timeline tracer.
+//
+// While tracing is on, each Span records its name, start and end on the thread it runs on.
+// Every thread writes to a ring buffer of its own, so the hot path takes no lock: a disabled
+// Span is one relaxed load, an enabled one two clock reads and a store. stop() writes the spans
+// recorded since start() as Chrome trace JSON (chrome://tracing, ui.perfetto.dev), one track
+// per thread, which shows game, render and audio work side by side frame by frame.
+
+namespace sssv::timeline {
+
+extern std::atomic<bool> g_enabled;
+inline bool enabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+inline uint64_t now_ns() {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// name must outlive the trace; string literals in practice.
+void record(const char* name, uint64_t begin_ns, uint64_t end_ns);
+
+class Span {
+public:
+	explicit Span(const char* name) : name_(enabled() ? name : nullptr), begin_ns_(name_ != nullptr ? now_ns() : 0) {}
+	~Span() {
+		if (name_ != nullptr) {
+			record(name_, begin_ns_, now_ns());
+		}
+	}
+	Span(const Span&) = delete;
+	Span& operator=(const Span&) = delete;
+
+private:
+	const char* name_;
+	uint64_t begin_ns_;
+};
+
+// Labels the calling thread's track. Cheap, and fine to call before tracing starts.
+void name_current_thread(const std::string& name);
+
+void start();
+// Writes the trace and returns false if the file could not be written.
+bool stop(const std::filesystem::path& path);
+
+} // namespace sssv::timeline
@@ -3,24 +3,27 @@
 #include <algorithm>
 #include <cstdint>
 #include <cstring>
-#include <fstream>
+#include <utility>
 #include <vector>
 
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
 namespace csdk::launcher_music {
 namespace {
-struct State {
-    Config config{};
-    Callbacks callbacks{};
-    std::vector<float> pcm;
-    size_t cursor_frames = 0;
-    uint32_t pcm_channels = 0;
-    bool enabled = false;
-    bool loaded = false;
-    bool load_attempted = false;
-    bool playing = false;
-};
-
-State state;
+constexpr uint32_t max_channels = 2;
 
 uint16_t read_u16_le(const uint8_t* data) {
     return static_cast<uint16_t>(data[0] | (data[1] << 8));
@@ -30,21 +33,91 @@ uint32_t read_u32_le(const uint8_t* data) {
     return static_cast<uint32_t>(data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24));
 }
 
-bool read_file_bytes(const std::filesystem::path& path, std::vector<uint8_t>& out) {
-    std::ifstream stream(path, std::ios::binary);
-    if (!stream) {
-        return false;
+// Read-only view of a whole file. Pages are faulted in as the decoder reaches them and can be
+// dropped again by the OS, so only the part around the play cursor stays resident.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
     }
-    stream.seekg(0, std::ios::end);
-    std::streamoff size = stream.tellg();
-    if (size <= 0) {
-        return false;
+    ~MappedFile() { close(); }
+
+    bool open(const std::filesystem::path& path) {
+        close();
+#if defined(_WIN32)
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+            CloseHandle(file);
+            return false;
+        }
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr) {
+            return false;
+        }
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (view == nullptr) {
+            return false;
+        }
+        data_ = static_cast<const uint8_t*>(view);
+        size_ = static_cast<size_t>(size.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (view == MAP_FAILED) {
+            return false;
+        }
+        madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+        data_ = static_cast<const uint8_t*>(view);
+        size_ = static_cast<size_t>(st.st_size);
+#endif
+        return true;
     }
-    stream.seekg(0, std::ios::beg);
-    out.resize(static_cast<size_t>(size));
-    stream.read(reinterpret_cast<char*>(out.data()), size);
-    return stream.good();
-}
+
+    void close() {
+        if (data_ == nullptr) {
+            return;
+        }
+#if defined(_WIN32)
+        UnmapViewOfFile(data_);
+#else
+        munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
 
 struct WavInfo {
     uint16_t format = 0;
@@ -55,14 +128,14 @@ struct WavInfo {
     size_t data_size = 0;
 };
 
-bool parse_wav(const std::vector<uint8_t>& bytes, WavInfo& info) {
-    if (bytes.size() < 12) {
+bool parse_wav(const uint8_t* bytes, size_t size, WavInfo& info) {
+    if (size < 12) {
         return false;
     }
-    if (std::memcmp(bytes.data(), "RIFF", 4) != 0) {
+    if (std::memcmp(bytes, "RIFF", 4) != 0) {
         return false;
     }
-    if (std::memcmp(bytes.data() + 8, "WAVE", 4) != 0) {
+    if (std::memcmp(bytes + 8, "WAVE", 4) != 0) {
         return false;
     }
 
@@ -70,12 +143,12 @@ bool parse_wav(const std::vector<uint8_t>& bytes, WavInfo& info) {
     bool got_fmt = false;
     bool got_data = false;
 
-    while (offset + 8 <= bytes.size()) {
-        const uint8_t* chunk = bytes.data() + offset;
+    while (offset + 8 <= size) {
+        const uint8_t* chunk = bytes + offset;
         uint32_t chunk_size = read_u32_le(chunk + 4);
         offset += 8;
 
-        if (offset + chunk_size > bytes.size()) {
+        if (offset + chunk_size > size) {
             break;
         }
 
@@ -83,13 +156,13 @@ bool parse_wav(const std::vector<uint8_t>& bytes, WavInfo& info) {
             if (chunk_size < 16) {
                 return false;
             }
-            info.format = read_u16_le(bytes.data() + offset + 0);
-            info.channels = read_u16_le(bytes.data() + offset + 2);
-            info.sample_rate = read_u32_le(bytes.data() + offset + 4);
-            info.bits_per_sample = read_u16_le(bytes.data() + offset + 14);
+            info.format = read_u16_le(bytes + offset + 0);
+            info.channels = read_u16_le(bytes + offset + 2);
+            info.sample_rate = read_u32_le(bytes + offset + 4);
+            info.bits_per_sample = read_u16_le(bytes + offset + 14);
             got_fmt = true;
         } else if (std::memcmp(chunk, "data", 4) == 0) {
-            info.data = bytes.data() + offset;
+            info.data = bytes + offset;
             info.data_size = chunk_size;
             got_data = true;
         }
@@ -103,153 +176,137 @@ bool parse_wav(const std::vector<uint8_t>& bytes, WavInfo& info) {
     return got_fmt && got_data;
 }
 
-bool decode_wav_to_float(const WavInfo& info, std::vector<float>& out, uint32_t& out_channels, uint32_t& out_sample_rate) {
+// Playback cursor over the mapped WAV data. current and next are source frames frame and
+// frame + 1 (wrapping), already converted to the output channel count; position is the
+// fraction between them in 0.32 fixed point.
+struct Stream {
+    MappedFile file;
+    WavInfo info{};
+    size_t frame_count = 0;
+    uint32_t out_channels = 0;
+    uint64_t step = 0;
+    size_t frame = 0;
+    uint64_t position = 0;
+    float current[max_channels] = {};
+    float next[max_channels] = {};
+};
+
+struct State {
+    Config config{};
+    Callbacks callbacks{};
+    Stream stream;
+    std::vector<float> chunk;
+    bool enabled = false;
+    bool loaded = false;
+    bool load_attempted = false;
+    bool playing = false;
+};
+
+State state;
+
+bool is_supported(const WavInfo& info, uint32_t out_channels) {
     if (info.data == nullptr || info.data_size == 0) {
         return false;
     }
     if (info.channels == 0 || info.sample_rate == 0) {
         return false;
     }
-
-    if (info.format == 1 && info.bits_per_sample == 16) {
-        size_t bytes_per_frame = info.channels * 2;
-        size_t frame_count = info.data_size / bytes_per_frame;
-        if (frame_count == 0) {
-            return false;
-        }
-        out.resize(frame_count * info.channels);
-        const int16_t* samples = reinterpret_cast<const int16_t*>(info.data);
-        for (size_t i = 0; i < frame_count * info.channels; ++i) {
-            out[i] = static_cast<float>(samples[i]) / 32768.0f;
-        }
-    } else if (info.format == 3 && info.bits_per_sample == 32) {
-        size_t bytes_per_frame = info.channels * 4;
-        size_t frame_count = info.data_size / bytes_per_frame;
-        if (frame_count == 0) {
-            return false;
-        }
-        out.resize(frame_count * info.channels);
-        const float* samples = reinterpret_cast<const float*>(info.data);
-        std::copy(samples, samples + out.size(), out.begin());
-    } else {
+    if (!(info.format == 1 && info.bits_per_sample == 16) && !(info.format == 3 && info.bits_per_sample == 32)) {
         return false;
     }
-
-    out_channels = info.channels;
-    out_sample_rate = info.sample_rate;
-    return true;
-}
-
-std::vector<float> resample_linear(const std::vector<float>& in, uint32_t in_rate, uint32_t out_rate, uint32_t channels) {
-    if (in.empty() || in_rate == 0 || out_rate == 0 || channels == 0) {
-        return {};
-    }
-    if (in_rate == out_rate) {
-        return in;
+    if (out_channels == 0 || out_channels > max_channels) {
+        return false;
     }
+    return info.channels == out_channels
+        || (info.channels == 1 && out_channels == 2)
+        || (info.channels == 2 && out_channels == 1);
+}
 
-    const size_t in_frames = in.size() / channels;
-    if (in_frames == 0) {
-        return {};
+float read_sample(const WavInfo& info, size_t index) {
+    if (info.format == 1) {
+        int16_t sample;
+        std::memcpy(&sample, info.data + index * 2, sizeof(sample));
+        return static_cast<float>(sample) / 32768.0f;
     }
-    const size_t out_frames = static_cast<size_t>((static_cast<double>(in_frames) * out_rate) / in_rate);
-    if (out_frames == 0) {
-        return {};
-    }
-
-    std::vector<float> out(out_frames * channels);
-    const double rate_ratio = static_cast<double>(in_rate) / static_cast<double>(out_rate);
-
-    for (size_t i = 0; i < out_frames; ++i) {
-        double src_pos = static_cast<double>(i) * rate_ratio;
-        size_t idx = static_cast<size_t>(src_pos);
-        double frac = src_pos - static_cast<double>(idx);
-
-        if (idx >= in_frames - 1) {
-            idx = in_frames - 1;
-            frac = 0.0;
-        }
+    float sample;
+    std::memcpy(&sample, info.data + index * 4, sizeof(sample));
+    return sample;
+}
 
-        size_t idx_next = (idx + 1 < in_frames) ? (idx + 1) : idx;
-        for (uint32_t ch = 0; ch < channels; ++ch) {
-            float a = in[idx * channels + ch];
-            float b = in[idx_next * channels + ch];
-            out[i * channels + ch] = static_cast<float>(a * (1.0 - frac) + b * frac);
+// Decodes one source frame straight into the output channel layout.
+void decode_frame(const Stream& stream, size_t frame, float* out) {
+    const WavInfo& info = stream.info;
+    const size_t first = frame * info.channels;
+    if (info.channels == stream.out_channels) {
+        for (uint32_t ch = 0; ch < stream.out_channels; ++ch) {
+            out[ch] = read_sample(info, first + ch);
         }
+    } else if (info.channels == 1) {
+        out[0] = out[1] = read_sample(info, first);
+    } else {
+        out[0] = 0.5f * (read_sample(info, first + 0) + read_sample(info, first + 1));
     }
-
-    return out;
 }
 
-std::vector<float> convert_channels(const std::vector<float>& in, uint32_t in_channels, uint32_t out_channels) {
-    if (in_channels == out_channels) {
-        return in;
-    }
-    if (in_channels == 0 || out_channels == 0) {
-        return {};
-    }
-
-    const size_t in_frames = in.size() / in_channels;
-    std::vector<float> out(in_frames * out_channels);
+void rewind(Stream& stream) {
+    stream.frame = 0;
+    stream.position = 0;
+    decode_frame(stream, 0, stream.current);
+    decode_frame(stream, stream.frame_count > 1 ? 1 : 0, stream.next);
+}
 
-    if (in_channels == 1 && out_channels == 2) {
-        for (size_t i = 0; i < in_frames; ++i) {
-            float s = in[i];
-            out[i * 2 + 0] = s;
-            out[i * 2 + 1] = s;
+// Produces frames output frames into out, resampling linearly between the two decoded source
+// frames around the cursor and wrapping to the start at the end of the track.
+void render(Stream& stream, float* out, size_t frames, float volume) {
+    const uint32_t channels = stream.out_channels;
+    for (size_t i = 0; i < frames; ++i) {
+        const float frac = static_cast<float>(stream.position) * (1.0f / 4294967296.0f);
+        for (uint32_t ch = 0; ch < channels; ++ch) {
+            const float a = stream.current[ch];
+            const float b = stream.next[ch];
+            out[i * channels + ch] = (a + (b - a) * frac) * volume;
         }
-        return out;
-    }
 
-    if (in_channels == 2 && out_channels == 1) {
-        for (size_t i = 0; i < in_frames; ++i) {
-            float l = in[i * 2 + 0];
-            float r = in[i * 2 + 1];
-            out[i] = 0.5f * (l + r);
+        stream.position += stream.step;
+        while (stream.position >= (uint64_t(1) << 32)) {
+            stream.position -= uint64_t(1) << 32;
+            stream.frame = (stream.frame + 1 < stream.frame_count) ? stream.frame + 1 : 0;
+            const size_t next = (stream.frame + 1 < stream.frame_count) ? stream.frame + 1 : 0;
+            std::copy(stream.next, stream.next + channels, stream.current);
+            decode_frame(stream, next, stream.next);
         }
-        return out;
     }
-
-    return {};
 }
 
 bool load_wav() {
     if (state.loaded) {
         return true;
     }
-    if (state.config.wav_path.empty()) {
+    if (state.config.wav_path.empty() || state.config.output_sample_rate == 0) {
         return false;
     }
 
-    std::vector<uint8_t> bytes;
-    if (!read_file_bytes(state.config.wav_path, bytes)) {
+    Stream& stream = state.stream;
+    if (!stream.file.open(state.config.wav_path)) {
         return false;
     }
 
-    WavInfo info{};
-    if (!parse_wav(bytes, info)) {
+    if (!parse_wav(stream.file.data(), stream.file.size(), stream.info)
+        || !is_supported(stream.info, state.config.output_channels)) {
+        stream.file.close();
         return false;
     }
 
-    std::vector<float> decoded;
-    uint32_t decoded_channels = 0;
-    uint32_t decoded_rate = 0;
-    if (!decode_wav_to_float(info, decoded, decoded_channels, decoded_rate)) {
+    stream.frame_count = stream.info.data_size / (stream.info.channels * (stream.info.bits_per_sample / 8));
+    if (stream.frame_count == 0) {
+        stream.file.close();
         return false;
     }
+    stream.out_channels = state.config.output_channels;
+    stream.step = (uint64_t(stream.info.sample_rate) << 32) / state.config.output_sample_rate;
+    rewind(stream);
 
-    std::vector<float> resampled = resample_linear(decoded, decoded_rate, state.config.output_sample_rate, decoded_channels);
-    if (resampled.empty()) {
-        return false;
-    }
-
-    std::vector<float> converted = convert_channels(resampled, decoded_channels, state.config.output_channels);
-    if (converted.empty()) {
-        return false;
-    }
-
-    state.pcm = std::move(converted);
-    state.pcm_channels = state.config.output_channels;
+    state.chunk.assign(static_cast<size_t>(std::max<uint32_t>(state.config.chunk_frames, 1)) * stream.out_channels, 0.0f);
     state.loaded = true;
     return true;
 }
@@ -303,17 +360,16 @@ void update(float volume) {
         if (!state.callbacks.start_playback()) {
             return;
         }
-        state.cursor_frames = 0;
+        rewind(state.stream);
         state.playing = true;
     }
 
-    if (state.pcm.empty() || state.pcm_channels == 0) {
-        return;
-    }
-
     volume = std::clamp(volume, 0.0f, 1.0f);
+    if (volume >= 0.999f) {
+        volume = 1.0f;
+    }
 
-    static std::vector<float> temp;
+    const size_t chunk_frames = state.chunk.size() / state.stream.out_channels;
     uint32_t queued_ms = state.callbacks.get_queued_ms();
     size_t safety = 0;
 
@@ -322,35 +378,11 @@ void update(float volume) {
             break;
         }
 
-        const size_t total_frames = state.pcm.size() / state.pcm_channels;
-        size_t frames_available = total_frames - state.cursor_frames;
-        size_t frames_to_copy = std::min<size_t>(state.config.chunk_frames, frames_available);
-
-        if (frames_to_copy == 0) {
-            state.cursor_frames = 0;
-            continue;
-        }
-
-        temp.resize(frames_to_copy * state.pcm_channels);
-        const float* src = state.pcm.data() + state.cursor_frames * state.pcm_channels;
-
-        if (volume >= 0.999f) {
-            std::copy(src, src + temp.size(), temp.begin());
-        } else {
-            for (size_t i = 0; i < temp.size(); ++i) {
-                temp[i] = src[i] * volume;
-            }
-        }
-
-        if (!state.callbacks.queue_audio(temp.data(), frames_to_copy)) {
+        render(state.stream, state.chunk.data(), chunk_frames, volume);
+        if (!state.callbacks.queue_audio(state.chunk.data(), chunk_frames)) {
             break;
         }
 
-        state.cursor_frames += frames_to_copy;
-        if (state.cursor_frames >= total_frames) {
-            state.cursor_frames = 0;
-        }
-
         queued_ms = state.callbacks.get_queued_ms();
     }
 }
@@ -1,6 +1,16 @@
 #include "sssv_config.h"
 #include "sssv_game.h"
+#include "audio_output.h"
+#include "audio_stats.h"
+#include "sssv_audio_capture.h"
+#include "sssv_audio_hle.h"
+#include "sssv_audio_worker.h"
+#include "sssv_billboard_budget.h"
+#include "sssv_billboard_capture.h"
 #include "sssv_billboard_controls.h"
+#include "sssv_billboard_telemetry.h"
+#include "sssv_profiler.h"
+#include "sssv_timeline.h"
 #include "recompui/recompui.h"
 #include "recompui/config.h"
 #include "recompinput/recompinput.h"
@@ -95,6 +105,36 @@ void init_config() {
             "Rewrite 740094 (collectibles 2D) TexRects to interpolated ortho quads.", true);
         debug_config.add_bool_option("rewrite_740820_ortho", "740820 Ortho Quads",
             "Rewrite 740820 (tree tops) TexRects to interpolated ortho quads.", true);
+        debug_config.add_bool_option("billboard_batch_emit", "Batch Billboard State",
+            "Share one ortho state block across consecutive billboard quads instead of emitting it per sprite.", true);
+        debug_config.add_bool_option("billboard_deferred_projection", "Deferred Billboard Projection",
+            "Queue billboards and project them four at a time with SIMD before the display list is submitted.", false);
+        debug_config.add_bool_option("billboard_adaptive_budget", "Adaptive LOD Budget",
+            "Scale full-detail LOD overrides and billboard rewrites per frame to hold the game's frame rate. Overrides Disable LOD.", false);
+        debug_config.add_bool_option("billboard_owner_identity", "Billboard Owner Identity",
+            "Match billboards across frames by the object drawing them instead of by position, so pulsating items interpolate smoothly.", false);
+        debug_config.add_bool_option("billboard_texture_sort", "Texture-Sorted Billboards",
+            "Draw billboards grouped by texture in one list, called after the last billboard. Overrides deferred projection; switches itself off if the display list cannot be patched.", false);
+        debug_config.add_bool_option("billboard_telemetry", "Billboard Telemetry",
+            "Record per-frame billboard counters, rewrite timings and pool usage. Turning it off writes billboard_telemetry.csv to the app folder.", false);
+        debug_config.add_bool_option("billboard_capture", "Billboard Capture",
+            "Record every billboard hook call to billboard_capture.bin in the app folder, for replay with BillboardReplayBench.", false);
+        debug_config.add_bool_option("audio_hle", "Audio HLE",
+            "Run audio tasks natively instead of through the recompiled aspMain microcode. Tasks it cannot reproduce exactly still use the microcode.", false);
+        debug_config.add_bool_option("audio_hle_verify", "Verify Audio HLE",
+            "Run every audio task through both the HLE and the microcode, keep the microcode's output and log any difference and the time each took.", false);
+        debug_config.add_bool_option("audio_async", "Asynchronous Audio Tasks",
+            "Run audio tasks on a worker thread so the game builds the next audio frame while the current one is processed.", false);
+        debug_config.add_bool_option("audio_rate_control", "Audio Rate Control",
+            "Hold the audio queue at the target latency (40 ms, or --audio-latency-ms) by adjusting the resampling rate slightly instead of skipping samples.", false);
+        debug_config.add_bool_option("audio_stats_log", "Audio Stats Log",
+            "Every 5 seconds, log audio underruns, overruns, skipped samples, a queued latency histogram, the time between audio buffers and the time spent converting them.", false);
+        debug_config.add_bool_option("audio_capture", "Audio Capture",
+            "Record every audio task to audio_capture.bin in the app folder, for replay with AudioReplayBench.", false);
+        debug_config.add_bool_option("profiler", "Sampling Profiler",
+            "Sample the game threads 1000 times a second. Turning it off writes profile.folded and hot_funcs.txt to the app folder.", false);
+        debug_config.add_bool_option("timeline_trace", "Timeline Trace",
+            "Record game, render and audio spans. Turning it off writes timeline.json to the app folder, for chrome://tracing or ui.perfetto.dev.", false);
 
 #if defined(NDEBUG)
         debug_config.add_bool_option("rewrite_6c5e44_suppress_original", "6C5E44 Hide Original",
@@ -242,6 +282,129 @@ void init_config() {
                     sssv::billboard::set_rewrite_740820_suppress_original(*v);
                 }
             });
+
+        debug_config.add_option_change_callback("billboard_batch_emit",
+            [](ConfigValueVariant cur, ConfigValueVariant, OptionChangeContext) {
+                if (auto v = std::get_if<bool>(&cur)) {
+                    sssv::billboard::set_batch_emit(*v);
+                }
+            });
+
+        debug_config.add_option_change_callback("billboard_deferred_projection",
+            [](ConfigValueVariant cur, ConfigValueVariant, OptionChangeContext) {
+                if (auto v = std::get_if<bool>(&cur)) {
+                    sssv::billboard::set_deferred_projection(*v);
+                }
+            });
+
+        debug_config.add_option_change_callback("billboard_adaptive_budget",
+            [](ConfigValueVariant cur, ConfigValueVariant, OptionChangeContext) {
+                if (auto v = std::get_if<bool>(&cur)) {
+                    sssv::billboard::budget::set_enabled(*v);
+                }
+            });
+
+        debug_config.add_option_change_callback("billboard_owner_identity",
+            [](ConfigValueVariant cur, ConfigValueVariant, OptionChangeContext) {
+                if (auto v = std::get_if<bool>(&cur)) {
+                    sssv::billboard::set_owner_identity(*v);
+                }
+            });
+
+        debug_config.add_option_change_callback("billboard_texture_sort",
+            [](ConfigValueVariant cur, ConfigValueVariant, OptionChangeContext) {
+                if (auto v = std::get_if<bool>(&cur)) {
+                    sssv::billboard::set_texture_sort(*v);
+                }
+            });
+
+        debug_config.add_option_change_callback("billboard_telemetry",
+            [](ConfigValueVariant cur, ConfigValueVariant, OptionChangeContext) {
+                if (auto v = std::get_if<bool>(&cur)) {
+                    const bool was_enabled = sssv::billboard::telemetry::enabled();
+                    sssv::billboard::telemetry::set_enabled(*v);
+                    if (was_enabled && !*v) {
+                        sssv::billboard::telemetry::dump_csv(recompui::file::get_app_folder_path() / "billboard_telemetry.csv");
+                    }
+                }
+            });
+
+        debug_config.add_option_change_callback("billboard_capture",
+            [](ConfigValueVariant cur, ConfigValueVariant, OptionChangeContext) {
+                if (auto v = std::get_if<bool>(&cur)) {
+                    if (*v) {
+                        sssv::billboard::capture::start(recompui::file::get_app_folder_path() / "billboard_capture.bin");
+                    } else {
+                        sssv::billboard::capture::stop();
+                    }
+                }
+            });
+
+        debug_config.add_option_change_callback("audio_hle",
+            [](ConfigValueVariant cur, ConfigValueVariant, OptionChangeContext) {
+                if (auto v = std::get_if<bool>(&cur)) {
+                    sssv::audio_hle::set_enabled(*v);
+                }
+            });
+
+        debug_config.add_option_change_callback("audio_hle_verify",
+            [](ConfigValueVariant cur, ConfigValueVariant, OptionChangeContext) {
+                if (auto v = std::get_if<bool>(&cur)) {
+                    sssv::audio_hle::set_verify(*v);
+                }
+            });
+
+        debug_config.add_option_change_callback("audio_async",
+            [](ConfigValueVariant cur, ConfigValueVariant, OptionChangeContext) {
+                if (auto v = std::get_if<bool>(&cur)) {
+                    sssv::audio_worker::set_enabled(*v);
+                }
+            });
+
+        debug_config.add_option_change_callback("audio_rate_control",
+            [](ConfigValueVariant cur, ConfigValueVariant, OptionChangeContext) {
+                if (auto v = std::get_if<bool>(&cur)) {
+                    sssv::audio_output::set_rate_control(*v);
+                }
+            });
+
+        debug_config.add_option_change_callback("audio_stats_log",
+            [](ConfigValueVariant cur, ConfigValueVariant, OptionChangeContext) {
+                if (auto v = std::get_if<bool>(&cur)) {
+                    sssv::audio_stats::set_logging(*v);
+                }
+            });
+
+        debug_config.add_option_change_callback("audio_capture",
+            [](ConfigValueVariant cur, ConfigValueVariant, OptionChangeContext) {
+                if (auto v = std::get_if<bool>(&cur)) {
+                    if (*v) {
+                        sssv::audio_hle::capture::start(recompui::file::get_app_folder_path() / "audio_capture.bin");
+                    } else {
+                        sssv::audio_hle::capture::stop();
+                    }
+                }
+            });
+        debug_config.add_option_change_callback("profiler",
+            [](ConfigValueVariant cur, ConfigValueVariant, OptionChangeContext) {
+                if (auto v = std::get_if<bool>(&cur)) {
+                    if (*v) {
+                        sssv::profiler::start();
+                    } else {
+                        sssv::profiler::stop(recompui::file::get_app_folder_path(), recompui::file::get_program_path());
+                    }
+                }
+            });
+        debug_config.add_option_change_callback("timeline_trace",
+            [](ConfigValueVariant cur, ConfigValueVariant, OptionChangeContext) {
+                if (auto v = std::get_if<bool>(&cur)) {
+                    if (*v) {
+                        sssv::timeline::start();
+                    } else {
+                        sssv::timeline::stop(recompui::file::get_app_folder_path() / "timeline.json");
+                    }
+                }
+            });
     }
 
 #if defined(NDEBUG)
@@ -260,6 +423,9 @@ void on_init(uint8_t* rdram, recomp_context* ctx) {
 }
 
 std::string get_game_thread_name(const OSThread* t) {
+    // ultramodern calls this on the new thread itself, before the game entrypoint.
+    sssv::profiler::register_current_thread();
+
     std::string name = "[Game] ";
 
     // SSSV thread naming based on thread ID/priority
@@ -300,6 +466,7 @@ std::string get_game_thread_name(const OSThread* t) {
             break;
     }
 
+    sssv::timeline::name_current_thread(name);
     return name;
 }
 
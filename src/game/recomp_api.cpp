@@ -4,12 +4,16 @@
 #include <algorithm>
 #include <chrono>
 #include <cstring>
+#include <string>
 
 #include "recomp.h"
+#include "librecomp/overlays.hpp"
 #include "recompui/recompui.h"
 #include "ultramodern/ultramodern.hpp"
 #include "ultramodern/config.hpp"
 #include "rt64_extended_gbi.h"
+#include "sssv_game.h"
+#include "sssv_hooks.h"
 
 // Enable RT64 extended GBI features
 // Must be called early in display list construction
@@ -39,6 +43,40 @@ extern "C" void sssv_enable_extended_gbi(uint8_t* rdram, recomp_context* ctx) {
     MEM_W(0, gdl_ptr_ptr) = static_cast<int32_t>(gdl);
 }
 
+// Mod export: bool sssv_set_hook_override(const char* name, void (*handler)(void)), imported
+// from "*". Installs a mod function as the override for a patch hook (sssv_hooks.h), or
+// removes the override when handler is NULL. The override sees the hook's arguments and may
+// change them, under the contract in sssv_hooks.h. Returns false if no hook has that name.
+extern "C" void sssv_set_hook_override_export(uint8_t* rdram, recomp_context* ctx) {
+    constexpr size_t max_name_length = 64;
+    const gpr name_ptr = ctx->r4;
+    const int32_t handler_vram = static_cast<int32_t>(ctx->r5);
+    ctx->r2 = 0;
+    if (name_ptr == 0) {
+        return;
+    }
+
+    std::string name;
+    for (gpr addr = name_ptr; name.size() < max_name_length; addr++) {
+        const char c = static_cast<char>(MEM_B(0, addr));
+        if (c == '\0') {
+            break;
+        }
+        name.push_back(c);
+    }
+
+    sssv::hooks::Hook hook;
+    if (!sssv::hooks::find(name, hook)) {
+        return;
+    }
+    sssv::hooks::set_mod_override(hook, (handler_vram != 0) ? get_function(handler_vram) : nullptr);
+    ctx->r2 = 1;
+}
+
+void sssv::register_mod_exports() {
+    recomp::overlays::register_base_export("sssv_set_hook_override", sssv_set_hook_override_export);
+}
+
 
 // ============================================================================
 // Required Runtime Functions
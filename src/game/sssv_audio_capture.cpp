@@ -0,0 +1,136 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+#include "sssv_audio_capture.h"
+
+namespace sssv::audio_hle::capture {
+
+std::atomic<bool> g_enabled{ false };
+
+namespace {
+
+constexpr size_t kWriteBufferBytes = 1 << 20;
+
+std::mutex s_mutex;
+std::FILE* s_file = nullptr;
+uint64_t s_tasks_written = 0;
+
+} // namespace
+
+uint64_t hash_outputs(const uint8_t* rdram, const std::vector<Range>& outputs) {
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (const Range& range : outputs) {
+		for (uint32_t i = 0; i < range.size; i++) {
+			hash = (hash ^ rdram[range.addr + i]) * 0x100000001B3ull;
+		}
+	}
+	return hash;
+}
+
+bool start(const std::filesystem::path& path) {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	if (s_file != nullptr) {
+		return true;
+	}
+
+	s_file = std::fopen(path.string().c_str(), "wb");
+	if (s_file == nullptr) {
+		std::printf("[AUDIO CAPTURE] failed to open %s\n", path.string().c_str());
+		return false;
+	}
+	std::setvbuf(s_file, nullptr, _IOFBF, kWriteBufferBytes);
+
+	const CaptureHeader header{};
+	std::fwrite(&header, sizeof(header), 1, s_file);
+	s_tasks_written = 0;
+	g_enabled = true;
+
+	std::printf("[AUDIO CAPTURE] recording to %s\n", path.string().c_str());
+	std::fflush(stdout);
+	return true;
+}
+
+void stop() {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	g_enabled = false;
+	if (s_file == nullptr) {
+		return;
+	}
+	std::fclose(s_file);
+	s_file = nullptr;
+
+	std::printf("[AUDIO CAPTURE] stopped after %llu tasks\n", (unsigned long long)s_tasks_written);
+	std::fflush(stdout);
+}
+
+void write_task(const TaskRecord& task) {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	if (s_file == nullptr) {
+		return;
+	}
+	TaskHeader header;
+	header.input_count = static_cast<uint32_t>(task.inputs.size());
+	header.output_count = static_cast<uint32_t>(task.outputs.size());
+	header.output_hash = task.output_hash;
+	std::fwrite(&header, sizeof(header), 1, s_file);
+	std::fwrite(task.dmem.data(), task.dmem.size(), 1, s_file);
+	size_t offset = 0;
+	for (const Range& range : task.inputs) {
+		std::fwrite(&range, sizeof(range), 1, s_file);
+		std::fwrite(task.input_bytes.data() + offset, range.size, 1, s_file);
+		offset += range.size;
+	}
+	std::fwrite(task.outputs.data(), sizeof(Range), task.outputs.size(), s_file);
+	s_tasks_written++;
+}
+
+bool load(const std::filesystem::path& path, std::vector<TaskRecord>& out) {
+	std::ifstream in(path, std::ios::binary);
+	if (!in.is_open()) {
+		return false;
+	}
+
+	CaptureHeader header;
+	if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || (header.magic != kMagic) || (header.version != kVersion)) {
+		return false;
+	}
+
+	out.clear();
+	TaskHeader task_header;
+	while (in.read(reinterpret_cast<char*>(&task_header), sizeof(task_header))) {
+		TaskRecord& task = out.emplace_back();
+		task.output_hash = task_header.output_hash;
+		if (!in.read(reinterpret_cast<char*>(task.dmem.data()), task.dmem.size())) {
+			return false;
+		}
+		task.inputs.resize(task_header.input_count);
+		for (Range& range : task.inputs) {
+			if (!in.read(reinterpret_cast<char*>(&range), sizeof(range))) {
+				return false;
+			}
+			const size_t offset = task.input_bytes.size();
+			task.input_bytes.resize(offset + range.size);
+			if (!in.read(reinterpret_cast<char*>(task.input_bytes.data() + offset), range.size)) {
+				return false;
+			}
+		}
+		task.outputs.resize(task_header.output_count);
+		if (!in.read(reinterpret_cast<char*>(task.outputs.data()), task.outputs.size() * sizeof(Range))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void apply_task(uint8_t* rdram, uint8_t* dmem_out, const TaskRecord& task) {
+	size_t offset = 0;
+	for (const Range& range : task.inputs) {
+		std::memcpy(rdram + range.addr, task.input_bytes.data() + offset, range.size);
+		offset += range.size;
+	}
+	std::memcpy(dmem_out, task.dmem.data(), task.dmem.size());
+}
+
+} // namespace sssv::audio_hle::capture
@@ -0,0 +1,1261 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE4_1__)
+	#include <smmintrin.h>
+#elif defined(__ARM_NEON)
+	#include <arm_neon.h>
+#endif
+
+#include "sssv_aspmain.h"
+#include "sssv_audio_capture.h"
+#include "sssv_audio_hle.h"
+#include "sssv_timeline.h"
+
+// Recompiled LLE ucode (rsp/aspMain.cpp).
+extern RspUcodeFunc aspMain;
+
+namespace sssv::audio_hle {
+
+namespace {
+
+std::atomic<bool> g_enabled{ false };
+std::atomic<bool> g_verify{ false };
+
+// ── aspMain DMEM layout ─────────────────────────────────────────────────
+// DMEM holds big-endian data word-swapped in host memory: byte address a lives at a ^ 3,
+// halfword address a at a ^ 2. Addresses wrap at 4 KB like the RSP's.
+
+constexpr uint32_t kDmemSize = 0x1000;
+constexpr uint32_t kDmemMask = kDmemSize - 1;
+
+constexpr uint32_t kUcodeConsts = 0x000;   // VMULF/VMACF "keep" factor at +0xC, ADPCM scales at +0x8/+0xA
+constexpr uint32_t kAdpcmNibbles = 0x030;  // nibble masks, then nibble multipliers
+constexpr uint32_t kResampleConsts = 0x040;
+constexpr uint32_t kEnvRampConsts = 0x0B0;
+constexpr uint32_t kSegmentTable = 0x320;
+constexpr uint32_t kAudioState = 0x360;    // buffers, volumes and loop address set by commands
+constexpr uint32_t kAdpcmBook = 0x4C0;
+constexpr uint32_t kBufferBase = 0x5C0;    // command buffer offsets are relative to this
+constexpr uint32_t kStateStage = 0xF90;    // per-command state staged for DMA
+constexpr uint32_t kTaskDataPtr = 0xFC0 + 0x30;
+constexpr uint32_t kTaskDataSize = 0xFC0 + 0x34;
+
+// Offsets into kAudioState. The envelope parameters SETVOL writes start where SETLOOP stores
+// its address, as in the ucode.
+constexpr uint32_t kIn = 0x00;
+constexpr uint32_t kOut = 0x02;
+constexpr uint32_t kCount = 0x04;
+constexpr uint32_t kVolLeft = 0x06;
+constexpr uint32_t kVolRight = 0x08;
+constexpr uint32_t kDryRight = 0x0A;
+constexpr uint32_t kWetLeft = 0x0C;
+constexpr uint32_t kWetRight = 0x0E;
+constexpr uint32_t kLoop = 0x10;
+constexpr uint32_t kEnvParams = 0x10;      // target L, rate L (hi, lo), target R, rate R (hi, lo), dry, wet
+
+enum Command : uint32_t {
+	A_SPNOOP = 0,
+	A_ADPCM,
+	A_CLEARBUFF,
+	A_ENVMIXER,
+	A_LOADBUFF,
+	A_RESAMPLE,
+	A_SAVEBUFF,
+	A_SEGMENT,
+	A_SETBUFF,
+	A_SETVOL,
+	A_DMEMMOVE,
+	A_LOADADPCM,
+	A_MIXER,
+	A_INTERLEAVE,
+	A_POLEF,
+	A_SETLOOP,
+	kCommandCount
+};
+static_assert(kCommandCount == aspmain::kCommandCount);
+
+// Command flags (w1 >> 16).
+constexpr uint32_t kFlagInit = 0x01;
+constexpr uint32_t kFlagLoop = 0x02;
+constexpr uint32_t kFlagLeft = 0x02;
+constexpr uint32_t kFlagVol = 0x04;
+constexpr uint32_t kFlagAux = 0x08;
+
+constexpr uint32_t kMaxTaskBytes = 0x10000;
+
+inline uint8_t dmem_u8(uint32_t addr) {
+	return dmem[(addr ^ 3) & kDmemMask];
+}
+
+inline void dmem_store_u8(uint32_t addr, uint8_t value) {
+	dmem[(addr ^ 3) & kDmemMask] = value;
+}
+
+inline int16_t dmem_s16(uint32_t addr) {
+	if ((addr & 1) == 0) {
+		return *reinterpret_cast<int16_t*>(dmem + ((addr ^ 2) & kDmemMask));
+	}
+	return static_cast<int16_t>((dmem_u8(addr) << 8) | dmem_u8(addr + 1));
+}
+
+inline uint16_t dmem_u16(uint32_t addr) {
+	return static_cast<uint16_t>(dmem_s16(addr));
+}
+
+inline void dmem_store_s16(uint32_t addr, int16_t value) {
+	if ((addr & 1) == 0) {
+		*reinterpret_cast<int16_t*>(dmem + ((addr ^ 2) & kDmemMask)) = value;
+		return;
+	}
+	dmem_store_u8(addr, static_cast<uint8_t>(static_cast<uint16_t>(value) >> 8));
+	dmem_store_u8(addr + 1, static_cast<uint8_t>(value));
+}
+
+// Word accesses are always 4-byte aligned in aspMain.
+inline uint32_t dmem_u32(uint32_t addr) {
+	return *reinterpret_cast<uint32_t*>(dmem + (addr & kDmemMask & ~3u));
+}
+
+inline void dmem_store_u32(uint32_t addr, uint32_t value) {
+	*reinterpret_cast<uint32_t*>(dmem + (addr & kDmemMask & ~3u)) = value;
+}
+
+// Byte copy with LDV/SDV semantics: the chunk is read in full before it is written.
+inline void dmem_copy(uint32_t dst, uint32_t src, uint32_t length) {
+	uint8_t chunk[16];
+	for (uint32_t i = 0; i < length; i++) {
+		chunk[i] = dmem_u8(src + i);
+	}
+	for (uint32_t i = 0; i < length; i++) {
+		dmem_store_u8(dst + i, chunk[i]);
+	}
+}
+
+// Eight 16-bit lanes in RSP element order (LQV/SQV of a 16-byte aligned address).
+using Vec = std::array<int16_t, 8>;
+
+inline Vec dmem_vec(uint32_t addr) {
+	Vec v;
+	for (int i = 0; i < 8; i++) {
+		v[i] = dmem_s16(addr + 2 * i);
+	}
+	return v;
+}
+
+inline void dmem_store_vec(uint32_t addr, const Vec& v) {
+	for (int i = 0; i < 8; i++) {
+		dmem_store_s16(addr + 2 * i, v[i]);
+	}
+}
+
+// ── RSP vector arithmetic ───────────────────────────────────────────────
+// The multiply(-accumulate) ops keep a 48-bit accumulator per lane. Results are read back
+// saturated from its middle 16 bits (VMUDM/VMUDH/VMADM/VMADH/VMULF/VMACF) or its low 16 bits
+// (VMUDL/VMUDN/VMADL/VMADN).
+
+inline int64_t acc48(int64_t value) {
+	return static_cast<int64_t>(static_cast<uint64_t>(value) << 16) >> 16;
+}
+
+inline int16_t acc_mid(int64_t acc) {
+	if (acc < INT32_MIN) {
+		return INT16_MIN;
+	}
+	if (acc > INT32_MAX) {
+		return INT16_MAX;
+	}
+	return static_cast<int16_t>(acc >> 16);
+}
+
+inline int16_t acc_low(int64_t acc) {
+	if (acc < INT32_MIN) {
+		return 0;
+	}
+	if (acc > INT32_MAX) {
+		return static_cast<int16_t>(0xFFFF);
+	}
+	return static_cast<int16_t>(acc);
+}
+
+inline int16_t sat16(int32_t value) {
+	return static_cast<int16_t>(value < INT16_MIN ? INT16_MIN : (value > INT16_MAX ? INT16_MAX : value));
+}
+
+inline int16_t vmulf(int16_t a, int16_t b) {
+	return acc_mid(int64_t(a) * b * 2 + 0x8000);
+}
+
+inline int64_t u16(int16_t value) {
+	return static_cast<uint16_t>(value);
+}
+
+// ── Mixing kernel ───────────────────────────────────────────────────────
+// MIXER and the envelope mixer blend a buffer into another with VMULF out, keep followed by
+// VMACF in, gain: out = sat16((2 * out * keep + 0x8000 + 2 * in * gain) >> 16).
+// Blocks are 16 aligned DMEM bytes in host order (RSP lane i is lanes[i ^ 1]); the kernel is
+// lane-wise, so it only needs the gains swizzled the same way.
+
+struct Block {
+	int16_t lanes[8];
+};
+
+inline Block load_block(uint32_t addr) {
+	Block b;
+	std::memcpy(b.lanes, dmem + (addr & kDmemMask), sizeof(b.lanes));
+	return b;
+}
+
+inline void store_block(uint32_t addr, const Block& b) {
+	std::memcpy(dmem + (addr & kDmemMask), b.lanes, sizeof(b.lanes));
+}
+
+inline Block broadcast_block(int16_t value) {
+	Block b;
+	for (int16_t& lane : b.lanes) {
+		lane = value;
+	}
+	return b;
+}
+
+inline int16_t mix_sample(int16_t out, int16_t in, int16_t keep, int16_t gain) {
+	return acc_mid(int64_t(out) * keep * 2 + 0x8000 + int64_t(in) * gain * 2);
+}
+
+Block mix_block(const Block& out, const Block& in, int16_t keep, const Block& gains) {
+	Block result;
+	// out * keep + in * gain only overflows 32 bits when keep and a gain are both -32768.
+	// (2 * sum + 0x8000) >> 16 == (sum + 0x4000) >> 15, which keeps the rounding in range.
+#if defined(__SSE4_1__)
+	if (keep != INT16_MIN) {
+		const __m128i o = _mm_loadu_si128(reinterpret_cast<const __m128i*>(out.lanes));
+		const __m128i i = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in.lanes));
+		const __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(gains.lanes));
+		const __m128i k = _mm_set1_epi16(keep);
+		const __m128i round = _mm_set1_epi32(0x4000);
+		const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(o, i), _mm_unpacklo_epi16(k, g));
+		const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(o, i), _mm_unpackhi_epi16(k, g));
+		const __m128i packed = _mm_packs_epi32(
+			_mm_srai_epi32(_mm_add_epi32(lo, round), 15),
+			_mm_srai_epi32(_mm_add_epi32(hi, round), 15));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(result.lanes), packed);
+		return result;
+	}
+#elif defined(__ARM_NEON)
+	if (keep != INT16_MIN) {
+		const int16x8_t o = vld1q_s16(out.lanes);
+		const int16x8_t i = vld1q_s16(in.lanes);
+		const int16x8_t g = vld1q_s16(gains.lanes);
+		const int32x4_t lo = vmlal_s16(vmull_n_s16(vget_low_s16(o), keep), vget_low_s16(i), vget_low_s16(g));
+		const int32x4_t hi = vmlal_s16(vmull_n_s16(vget_high_s16(o), keep), vget_high_s16(i), vget_high_s16(g));
+		vst1q_s16(result.lanes, vcombine_s16(vqrshrn_n_s32(lo, 15), vqrshrn_n_s32(hi, 15)));
+		return result;
+	}
+#endif
+	for (int n = 0; n < 8; n++) {
+		result.lanes[n] = mix_sample(out.lanes[n], in.lanes[n], keep, gains.lanes[n]);
+	}
+	return result;
+}
+
+// ── DMA ─────────────────────────────────────────────────────────────────
+// Same rules as librecomp's RSP DMA: the RDRAM address is 8-byte aligned and the length
+// register holds the byte count minus one.
+
+struct RdramWrite {
+	uint32_t begin = 0; // host byte range, whole words
+	uint32_t end = 0;
+	std::vector<uint8_t> before;
+	std::vector<uint8_t> after;
+};
+
+bool s_log_writes = false;
+std::vector<RdramWrite> s_writes;
+
+void dma_read(const uint8_t* rdram, uint32_t dmem_addr, uint32_t dram_addr, uint32_t length_minus_one) {
+	const uint32_t length = length_minus_one + 1;
+	dram_addr &= 0xFFFFF8;
+	if (((dmem_addr & 3) == 0) && ((length & 3) == 0) && ((dmem_addr & kDmemMask) + length <= kDmemSize)) {
+		std::memcpy(dmem + (dmem_addr & kDmemMask), rdram + dram_addr, length);
+		return;
+	}
+	for (uint32_t i = 0; i < length; i++) {
+		dmem_store_u8(dmem_addr + i, rdram[(dram_addr + i) ^ 3]);
+	}
+}
+
+void dma_write(uint8_t* rdram, uint32_t dmem_addr, uint32_t dram_addr, uint32_t length_minus_one) {
+	const uint32_t length = length_minus_one + 1;
+	dram_addr &= 0xFFFFF8;
+	if (length == 0) {
+		return;
+	}
+	if (s_log_writes) {
+		RdramWrite& write = s_writes.emplace_back();
+		write.begin = dram_addr;
+		write.end = (dram_addr + length + 3) & ~3u;
+		write.before.assign(rdram + write.begin, rdram + write.end);
+	}
+	if (((dmem_addr & 3) == 0) && ((length & 3) == 0) && ((dmem_addr & kDmemMask) + length <= kDmemSize)) {
+		std::memcpy(rdram + dram_addr, dmem + (dmem_addr & kDmemMask), length);
+		return;
+	}
+	for (uint32_t i = 0; i < length; i++) {
+		rdram[(dram_addr + i) ^ 3] = dmem_u8(dmem_addr + i);
+	}
+}
+
+inline uint32_t segment_address(uint32_t w2) {
+	return (w2 & 0xFFFFFF) + dmem_u32(kSegmentTable + ((w2 >> 24) << 2));
+}
+
+// ── Commands ────────────────────────────────────────────────────────────
+// Each handler follows its aspMain routine step for step where the order of DMEM reads and
+// writes is observable (overlapping buffers), and in closed form everywhere else.
+
+void cmd_clearbuff(uint32_t w1, uint32_t w2) {
+	const int32_t count = static_cast<int32_t>(w2 & 0xFFFF);
+	uint32_t dst = (w1 & 0xFFFF) + kBufferBase;
+	for (int32_t left = count; left > 0; left -= 16, dst += 16) {
+		for (uint32_t i = 0; i < 16; i++) {
+			dmem_store_u8(dst + i, 0);
+		}
+	}
+}
+
+void cmd_loadbuff(const uint8_t* rdram, uint32_t w2) {
+	const uint32_t count = dmem_u16(kAudioState + kCount);
+	if (count != 0) {
+		dma_read(rdram, dmem_u16(kAudioState + kIn), segment_address(w2), count - 1);
+	}
+}
+
+void cmd_savebuff(uint8_t* rdram, uint32_t w2) {
+	const uint32_t count = dmem_u16(kAudioState + kCount);
+	if (count != 0) {
+		dma_write(rdram, dmem_u16(kAudioState + kOut), segment_address(w2), count - 1);
+	}
+}
+
+void cmd_segment(uint32_t w2) {
+	dmem_store_u32(kSegmentTable + ((w2 >> 24) << 2), w2 & 0xFFFFFF);
+}
+
+void cmd_setbuff(uint32_t w1, uint32_t w2) {
+	if (((w1 >> 16) & kFlagAux) != 0) {
+		dmem_store_s16(kAudioState + kWetRight, static_cast<int16_t>(w2 + kBufferBase));
+		dmem_store_s16(kAudioState + kDryRight, static_cast<int16_t>(w1 + kBufferBase));
+		dmem_store_s16(kAudioState + kWetLeft, static_cast<int16_t>((w2 >> 16) + kBufferBase));
+	} else {
+		dmem_store_s16(kAudioState + kIn, static_cast<int16_t>(w1 + kBufferBase));
+		dmem_store_s16(kAudioState + kOut, static_cast<int16_t>((w2 >> 16) + kBufferBase));
+		dmem_store_s16(kAudioState + kCount, static_cast<int16_t>(w2));
+	}
+}
+
+void cmd_setvol(uint32_t w1, uint32_t w2) {
+	const uint32_t flags = w1 >> 16;
+	if ((flags & kFlagAux) != 0) {
+		dmem_store_s16(kAudioState + kEnvParams + 0xC, static_cast<int16_t>(w1));
+		dmem_store_s16(kAudioState + kEnvParams + 0xE, static_cast<int16_t>(w2));
+	} else if ((flags & kFlagVol) != 0) {
+		dmem_store_s16(kAudioState + (((flags & kFlagLeft) != 0) ? kVolLeft : kVolRight), static_cast<int16_t>(w1));
+	} else {
+		const uint32_t params = kAudioState + kEnvParams + (((flags & kFlagLeft) != 0) ? 0x0 : 0x6);
+		dmem_store_s16(params + 0, static_cast<int16_t>(w1));
+		dmem_store_s16(params + 2, static_cast<int16_t>(w2 >> 16));
+		dmem_store_s16(params + 4, static_cast<int16_t>(w2));
+	}
+}
+
+void cmd_dmemmove(uint32_t w1, uint32_t w2) {
+	const int32_t count = static_cast<int32_t>(w2 & 0xFFFF);
+	uint32_t src = (w1 & 0xFFFF) + kBufferBase;
+	uint32_t dst = (w2 >> 16) + kBufferBase;
+	for (int32_t left = count; left > 0; left -= 16, src += 16, dst += 16) {
+		// Two LDVs, then two SDVs.
+		dmem_copy(dst, src, 16);
+	}
+}
+
+void cmd_loadadpcm(const uint8_t* rdram, uint32_t w1, uint32_t w2) {
+	dma_read(rdram, kAdpcmBook, segment_address(w2), (w1 & 0xFFFF) - 1);
+}
+
+void cmd_setloop(uint32_t w2) {
+	dmem_store_u32(kAudioState + kLoop, segment_address(w2));
+}
+
+void cmd_interleave(uint32_t w2) {
+	const int32_t count = dmem_u16(kAudioState + kCount);
+	uint32_t out = dmem_u16(kAudioState + kOut);
+	uint32_t left = (w2 >> 16) + kBufferBase;
+	uint32_t right = (w2 & 0xFFFF) + kBufferBase;
+	for (int32_t remaining = count; remaining > 0; remaining -= 16, left += 16, right += 16, out += 32) {
+		const Vec l = dmem_vec(left);
+		const Vec r = dmem_vec(right);
+		for (int i = 0; i < 8; i++) {
+			dmem_store_s16(out + 4 * i, l[i]);
+			dmem_store_s16(out + 4 * i + 2, r[i]);
+		}
+	}
+}
+
+void cmd_mixer(uint32_t w1, uint32_t w2) {
+	const int32_t count = dmem_u16(kAudioState + kCount);
+	if (count == 0) {
+		return;
+	}
+	const int16_t keep = dmem_s16(kUcodeConsts + 0xC);
+	const Block gains = broadcast_block(static_cast<int16_t>(w1));
+	uint32_t out = (w2 & 0xFFFF) + kBufferBase;
+	uint32_t in = (w2 >> 16) + kBufferBase;
+
+	Block out0 = load_block(out);
+	Block in0 = load_block(in);
+	Block out1 = load_block(out + 0x10);
+	Block in1 = load_block(in + 0x10);
+	for (int32_t remaining = count; remaining > 0; remaining -= 0x20) {
+		// The next input is loaded between the two stores, the next output after both.
+		store_block(out, mix_block(out0, in0, keep, gains));
+		const Block mixed1 = mix_block(out1, in1, keep, gains);
+		in += 0x20;
+		in0 = load_block(in);
+		in1 = load_block(in + 0x10);
+		store_block(out + 0x10, mixed1);
+		out += 0x20;
+		out0 = load_block(out);
+		out1 = load_block(out + 0x10);
+	}
+}
+
+// ADPCM: 9-byte frames (scale/predictor header + 16 nibbles) decoded against an 8-tap
+// two-vector codebook. The first 32 output bytes hold the previous frame, as the ucode
+// leaves them.
+
+struct AdpcmConsts {
+	uint16_t mask[4];
+	int16_t mul[4];
+	int16_t in_scale;   // weight of the residual, VMADH by v31[5]
+	int16_t out_scale;  // final shift, VMADH by v31[4]
+};
+
+struct AdpcmFrame {
+	uint8_t header = 0;
+	uint8_t data[8] = {};
+	int16_t book1[8] = {};
+	int16_t book2[8] = {};
+};
+
+void read_adpcm_frame(uint32_t in, AdpcmFrame& frame) {
+	frame.header = dmem_u8(in);
+	for (uint32_t i = 0; i < 8; i++) {
+		frame.data[i] = dmem_u8(in + 1 + i);
+	}
+	const uint32_t book = kAdpcmBook + ((frame.header & 0xF) << 5);
+	for (uint32_t i = 0; i < 8; i++) {
+		frame.book1[i] = dmem_s16(book + 2 * i);
+		frame.book2[i] = dmem_s16(book + 0x10 + 2 * i);
+	}
+}
+
+void decode_adpcm_frame(const AdpcmFrame& frame, const AdpcmConsts& k, int16_t& prev2, int16_t& prev1, int16_t* out) {
+	const int32_t range = 12 - (frame.header >> 4);
+	const int64_t scale = (range > 0) ? (0x8000 >> (range - 1)) : 0;
+
+	int16_t residual[16];
+	for (int j = 0; j < 16; j++) {
+		const uint16_t word = static_cast<uint16_t>((frame.data[(j >> 2) * 2] << 8) | frame.data[(j >> 2) * 2 + 1]);
+		int16_t value = acc_low(int64_t(k.mask[j & 3] & word) * k.mul[j & 3]);
+		if (range > 0) {
+			value = acc_mid(int64_t(value) * scale);
+		}
+		residual[j] = value;
+	}
+
+	for (int half = 0; half < 2; half++) {
+		const int16_t* x = residual + 8 * half;
+		int16_t* o = out + 8 * half;
+		for (int i = 0; i < 8; i++) {
+			// VMADH accumulates in bits 16..47, so the sum wraps at 32 bits.
+			uint32_t sum = uint32_t(int32_t(frame.book1[i]) * prev2) + uint32_t(int32_t(frame.book2[i]) * prev1);
+			for (int tap = 1; tap <= i; tap++) {
+				sum += uint32_t(int32_t(frame.book2[i - tap]) * x[tap - 1]);
+			}
+			sum += uint32_t(int32_t(x[i]) * k.in_scale);
+			o[i] = acc_mid(int64_t(static_cast<int32_t>(sum)) * k.out_scale);
+		}
+		prev2 = o[6];
+		prev1 = o[7];
+	}
+}
+
+void cmd_adpcm(uint8_t* rdram, uint32_t w1, uint32_t w2) {
+	const uint32_t flags = w1 >> 16;
+	uint32_t in = dmem_u16(kAudioState + kIn);
+	uint32_t out = dmem_u16(kAudioState + kOut);
+	int32_t count = dmem_u16(kAudioState + kCount);
+	const uint32_t address = segment_address(w2);
+
+	AdpcmConsts k;
+	for (uint32_t i = 0; i < 4; i++) {
+		k.mask[i] = dmem_u16(kAdpcmNibbles + 2 * i);
+		k.mul[i] = dmem_s16(kAdpcmNibbles + 8 + 2 * i);
+	}
+	k.out_scale = dmem_s16(kUcodeConsts + 0x8);
+	k.in_scale = dmem_s16(kUcodeConsts + 0xA);
+
+	dmem_store_vec(out, Vec{});
+	dmem_store_vec(out + 0x10, Vec{});
+	if ((flags & kFlagInit) == 0) {
+		dma_read(rdram, out, ((flags & kFlagLoop) != 0) ? dmem_u32(kAudioState + kLoop) : address, 0x1F);
+	}
+
+	int16_t prev2 = dmem_s16(out + 0x1C);
+	int16_t prev1 = dmem_s16(out + 0x1E);
+	out += 0x20;
+	if (count != 0) {
+		AdpcmFrame frame;
+		read_adpcm_frame(in, frame);
+		do {
+			int16_t samples[16];
+			decode_adpcm_frame(frame, k, prev2, prev1, samples);
+			// The next frame and its codebook are read before this frame is stored.
+			in += 9;
+			read_adpcm_frame(in, frame);
+			for (uint32_t i = 0; i < 16; i++) {
+				dmem_store_s16(out + 2 * i, samples[i]);
+			}
+			count -= 0x20;
+			out += 0x20;
+		} while (count > 0);
+	}
+
+	dma_write(rdram, out - 0x20, address, 0x1F);
+}
+
+// RESAMPLE: 4-tap polyphase filter, 8 outputs per step. The RSP computes each output's input
+// position and filter row from a 16.16 pitch accumulator with vector ops and constants from
+// DMEM (0x40-0xAF); this follows those ops lane for lane.
+
+struct ResampleLanes {
+	Vec pos;   // v21: DMEM address of the output's first tap
+	Vec row;   // v17: DMEM address of the output's filter row
+	Vec whole; // v22
+	Vec frac;  // v23
+};
+
+void resample_addresses(ResampleLanes& s, const Vec& k50, const Vec& k60, int16_t in_base) {
+	for (int i = 0; i < 8; i++) {
+		int64_t acc = u16(k50[i]) * in_base;                      // VMUDN v21, v31, v18[2]
+		acc = acc48(acc + u16(s.whole[i]) * k60[2]);              // VMADN v21, v22, v30[2]
+		s.pos[i] = acc_low(acc);
+		acc = (u16(s.frac[i]) * 0x40) >> 16;                      // VMUDL v17, v23, v18[5]
+		const int16_t row = acc_low(acc);
+		acc = u16(row) * k60[4];                                  // VMUDN v17, v17, v30[4]
+		acc = acc48(acc + u16(k50[i]) * 0xC0);                    // VMADN v17, v31, v18[3]
+		s.row[i] = acc_low(acc);
+	}
+}
+
+void cmd_resample(uint8_t* rdram, uint32_t w1, uint32_t w2) {
+	const uint32_t flags = w1 >> 16;
+	const int64_t pitch = w1 & 0xFFFF;
+	int32_t in = dmem_s16(kAudioState + kIn);
+	int32_t out = dmem_s16(kAudioState + kOut);
+	int32_t count = dmem_s16(kAudioState + kCount);
+	const uint32_t address = segment_address(w2);
+
+	dmem_store_u32(kStateStage + 0x40, address);
+	if ((flags & kFlagInit) != 0) {
+		dmem_store_s16(kStateStage + 0x8, 0);
+		for (uint32_t i = 0; i < 8; i++) {
+			dmem_store_u8(kStateStage + i, 0);
+		}
+	} else {
+		dma_read(rdram, kStateStage, address, 0x1F);
+	}
+	if ((flags & kFlagLoop) != 0) {
+		// Restore the samples in front of an input that was not 16-byte aligned last time.
+		const int32_t shift = dmem_s16(kStateStage + 0xA);
+		uint8_t saved[16];
+		for (uint32_t i = 0; i < 16; i++) {
+			saved[i] = dmem_u8(kStateStage + 0x10 + i);
+		}
+		for (uint32_t i = 0; i < 16; i++) {
+			dmem_store_u8(in - 16 + i, saved[i]);
+		}
+		in -= shift;
+	}
+	in -= 8;
+	const uint16_t frac0 = dmem_u16(kStateStage + 0x8);
+	dmem_copy(in, kStateStage, 8);
+
+	const Vec k40 = dmem_vec(kResampleConsts + 0x00);
+	const Vec k50 = dmem_vec(kResampleConsts + 0x10);
+	const Vec k60 = dmem_vec(kResampleConsts + 0x20);
+	const Vec select[4] = {
+		dmem_vec(kResampleConsts + 0x30),
+		dmem_vec(kResampleConsts + 0x40),
+		dmem_vec(kResampleConsts + 0x50),
+		dmem_vec(kResampleConsts + 0x60),
+	};
+	const int16_t in_base = static_cast<int16_t>(in);
+
+	ResampleLanes s{};
+	for (int i = 0; i < 8; i++) {
+		const int16_t step = sat16(sat16(k40[i] - k50[i]) - k50[i]); // VSUB twice
+		int64_t acc = int64_t(k50[i]) * frac0;                     // VMUDM v23, v31, v23[7]
+		acc = acc48(acc + int64_t(step) * pitch);                   // VMADM v22, v25, v18[4]
+		s.whole[i] = acc_mid(acc);
+		acc = acc48(acc + u16(k50[i]) * k60[0]);                    // VMADN v23, v31, v30[0]
+		s.frac[i] = acc_low(acc);
+	}
+	resample_addresses(s, k50, k60, in_base);
+
+	do {
+		int16_t filtered[8];
+		for (int k = 0; k < 8; k++) {
+			int16_t taps[4];
+			for (int j = 0; j < 4; j++) {
+				taps[j] = vmulf(dmem_s16(static_cast<uint32_t>(s.pos[k] + 2 * j)), dmem_s16(static_cast<uint32_t>(s.row[k] + 2 * j)));
+			}
+			filtered[k] = sat16(sat16(taps[0] + taps[1]) + sat16(taps[2] + taps[3]));
+		}
+
+		const int16_t frac7 = s.frac[7];
+		const int16_t whole7 = s.whole[7];
+		for (int i = 0; i < 8; i++) {
+			int64_t acc = int64_t(k50[i]) * static_cast<uint16_t>(frac7); // VMUDM v23, v31, v23[7]
+			acc = acc48(acc + (int64_t(k50[i]) * whole7 << 16));           // VMADH v23, v31, v22[7]
+			acc = acc48(acc + int64_t(k40[i]) * pitch);                    // VMADM v22, v25, v18[4]
+			s.whole[i] = acc_mid(acc);
+			acc = acc48(acc + u16(k50[i]) * k60[0]);                       // VMADN v23, v31, v30[0]
+			s.frac[i] = acc_low(acc);
+		}
+		resample_addresses(s, k50, k60, in_base);
+
+		Vec result;
+		for (int k = 0; k < 8; k++) {
+			const int base = k & 4;
+			int64_t acc = 0;
+			for (int j = 0; j < 4; j++) {
+				acc += u16(select[j][k]) * filtered[base + j];
+			}
+			result[k] = acc_low(acc);
+		}
+		dmem_store_vec(static_cast<uint32_t>(out), result);
+		count -= 16;
+		out += 16;
+	} while (count > 0);
+
+	dmem_store_vec(kStateStage + 0x20, s.pos);
+	dmem_store_vec(kStateStage + 0x30, s.row);
+
+	// Save the next four input samples, the pitch fraction and the 16 bytes around the next
+	// aligned input position.
+	int32_t next = s.pos[0];
+	dmem_store_s16(kStateStage + 0x8, s.frac[0]);
+	dmem_copy(kStateStage, static_cast<uint32_t>(next), 8);
+	next += 8;
+	int32_t shift = (next - dmem_s16(kAudioState + kIn)) & 0xF;
+	next -= shift;
+	if (shift != 0) {
+		shift = 16 - shift;
+	}
+	dmem_store_s16(kStateStage + 0xA, static_cast<int16_t>(shift));
+	dmem_copy(kStateStage + 0x10, static_cast<uint32_t>(next), 8);
+	dmem_copy(kStateStage + 0x18, static_cast<uint32_t>(next + 8), 8);
+	dma_write(rdram, kStateStage, dmem_u32(kStateStage + 0x40), 0x1F);
+}
+
+// ENVMIXER: mixes the input into dry left/right (and, with A_AUX, wet left/right) buffers
+// under per-channel volume ramps. Each lane of a ramp holds one sample of volume as 16.16;
+// every 8 samples the ramp is multiplied by the 16.16 rate and clamped against the target.
+
+struct Ramp {
+	Vec hi;
+	Vec lo;
+};
+
+// VMUDL/VMADM/VMADN/VMADH of the ramp by the rate, then VMADN to read the low half.
+void ramp_step(Ramp& ramp, int16_t rate_hi, int16_t rate_lo) {
+	for (int i = 0; i < 8; i++) {
+		int64_t acc = (u16(ramp.lo[i]) * u16(rate_lo)) >> 16;
+		acc = acc48(acc + int64_t(ramp.hi[i]) * u16(rate_lo));
+		acc = acc48(acc + u16(ramp.lo[i]) * rate_hi);
+		acc = acc48(acc + (int64_t(ramp.hi[i]) * rate_hi << 16));
+		ramp.hi[i] = acc_mid(acc);
+		ramp.lo[i] = acc_low(acc);
+	}
+}
+
+// A_INIT: spread the first step from vol to vol * rate across the 8 lanes.
+Ramp ramp_start(int16_t vol, int16_t rate_hi, int16_t rate_lo, const Vec& k30, const Vec& k31) {
+	int64_t acc = int64_t(vol) * u16(rate_lo);
+	acc = acc48(acc + (int64_t(vol) * rate_hi << 16));
+	const int16_t next_lo = acc_low(acc);
+	const int16_t delta_hi = sat16(acc_mid(acc) - vol);
+
+	Ramp ramp;
+	for (int i = 0; i < 8; i++) {
+		acc = (u16(k30[i]) * u16(next_lo)) >> 16;
+		acc = acc48(acc + u16(k30[i]) * delta_hi);
+		acc = acc48(acc + (int64_t(k31[i]) * vol << 16));
+		ramp.hi[i] = acc_mid(acc);
+		ramp.lo[i] = acc_low(acc);
+	}
+	return ramp;
+}
+
+// Rising ramps stop at the target with VCL (unsigned min), falling ones with VGE (signed max).
+void ramp_clamp(Ramp& ramp, int16_t target, int16_t rate_hi) {
+	for (int16_t& hi : ramp.hi) {
+		if (rate_hi > 0) {
+			hi = (static_cast<uint16_t>(hi) >= static_cast<uint16_t>(target)) ? target : hi;
+		} else {
+			hi = (hi >= target) ? hi : target;
+		}
+	}
+}
+
+inline Block ramp_gains(const Ramp& ramp, int16_t level) {
+	Block gains;
+	for (int i = 0; i < 8; i++) {
+		gains.lanes[i ^ 1] = vmulf(ramp.hi[i], level);
+	}
+	return gains;
+}
+
+void cmd_envmixer(uint8_t* rdram, uint32_t w1, uint32_t w2) {
+	const uint32_t flags = w1 >> 16;
+	const uint32_t address = segment_address(w2);
+	const int16_t keep = dmem_s16(kUcodeConsts + 0xC);
+	const Vec k31 = dmem_vec(kResampleConsts + 0x10);
+	const Vec k30 = dmem_vec(kEnvRampConsts);
+
+	Vec params = dmem_vec(kAudioState + kEnvParams);
+	Ramp left{};
+	Ramp right{};
+	if ((flags & kFlagInit) == 0) {
+		dma_read(rdram, kStateStage, address, 0x4F);
+		left.hi = dmem_vec(kStateStage + 0x00);
+		left.lo = dmem_vec(kStateStage + 0x10);
+		right.hi = dmem_vec(kStateStage + 0x20);
+		right.lo = dmem_vec(kStateStage + 0x30);
+		params = dmem_vec(kStateStage + 0x40);
+	}
+	const int16_t target_l = params[0], rate_l_hi = params[1], rate_l_lo = params[2];
+	const int16_t target_r = params[3], rate_r_hi = params[4], rate_r_lo = params[5];
+	const int16_t dry = params[6], wet = params[7];
+
+	int32_t in = dmem_s16(kAudioState + kIn);
+	int32_t dry_l = dmem_s16(kAudioState + kOut);
+	int32_t dry_r = dmem_s16(kAudioState + kDryRight);
+	int32_t wet_l = dmem_s16(kAudioState + kWetLeft);
+	int32_t wet_r = dmem_s16(kAudioState + kWetRight);
+	int32_t count = dmem_s16(kAudioState + kCount);
+	int32_t wet_step = 16;
+	if ((flags & kFlagAux) == 0) {
+		// Without A_AUX the wet mix goes to a scratch block.
+		wet_l = wet_r = static_cast<int32_t>(kStateStage + 0x50);
+		wet_step = 0;
+	}
+
+	if ((flags & kFlagInit) != 0) {
+		left = ramp_start(dmem_s16(kAudioState + kVolLeft), rate_l_hi, rate_l_lo, k30, k31);
+		ramp_clamp(left, target_l, rate_l_hi);
+		const Block samples = load_block(in);
+		Block gains_dry = ramp_gains(left, dry);
+		Block gains_wet = ramp_gains(left, wet);
+		store_block(dry_l, mix_block(load_block(dry_l), samples, keep, gains_dry));
+		store_block(wet_l, mix_block(load_block(wet_l), samples, keep, gains_wet));
+
+		right = ramp_start(dmem_s16(kAudioState + kVolRight), rate_r_hi, rate_r_lo, k30, k31);
+		ramp_clamp(right, target_r, rate_r_hi);
+		gains_dry = ramp_gains(right, dry);
+		gains_wet = ramp_gains(right, wet);
+		store_block(dry_r, mix_block(load_block(dry_r), samples, keep, gains_dry));
+		store_block(wet_r, mix_block(load_block(wet_r), samples, keep, gains_wet));
+
+		count -= 16;
+		in += 16;
+		dry_l += 16;
+		dry_r += 16;
+		wet_l += wet_step;
+		wet_r += wet_step;
+	}
+
+	ramp_step(left, rate_l_hi, rate_l_lo);
+	do {
+		ramp_clamp(left, target_l, rate_l_hi);
+		const Block samples = load_block(in);
+		ramp_step(right, rate_r_hi, rate_r_lo);
+		const Block out_dry_l = load_block(dry_l);
+		const Block out_wet_l = load_block(wet_l);
+		dmem_store_vec(kStateStage + 0x00, left.hi);
+		dmem_store_vec(kStateStage + 0x10, left.lo);
+		const Block mixed_dry_l = mix_block(out_dry_l, samples, keep, ramp_gains(left, dry));
+		const Block out_dry_r = load_block(dry_r);
+		const Block out_wet_r = load_block(wet_r);
+		const Block mixed_wet_l = mix_block(out_wet_l, samples, keep, ramp_gains(left, wet));
+		store_block(dry_l, mixed_dry_l);
+		ramp_clamp(right, target_r, rate_r_hi);
+		store_block(wet_l, mixed_wet_l);
+		ramp_step(left, rate_l_hi, rate_l_lo);
+		store_block(dry_r, mix_block(out_dry_r, samples, keep, ramp_gains(right, dry)));
+		store_block(wet_r, mix_block(out_wet_r, samples, keep, ramp_gains(right, wet)));
+
+		count -= 16;
+		in += 16;
+		dry_l += 16;
+		dry_r += 16;
+		wet_l += wet_step;
+		wet_r += wet_step;
+	} while (count > 0);
+
+	dmem_store_vec(kStateStage + 0x20, right.hi);
+	dmem_store_vec(kStateStage + 0x30, right.lo);
+	dmem_store_vec(kStateStage + 0x40, params);
+	dma_write(rdram, kStateStage, address, 0x4F);
+}
+
+// ── Task ────────────────────────────────────────────────────────────────
+
+enum class Fallback {
+	None,
+	JumpTable,
+	TaskSize,
+	Command,
+	Polef,
+	Alignment,
+	Count
+};
+
+constexpr const char* kFallbackNames[] = {
+	"none",
+	"unexpected ucode jump table",
+	"task size",
+	"unknown command",
+	"POLEF",
+	"unaligned vector buffer",
+};
+
+inline uint32_t command_word(const uint8_t* rdram, uint32_t addr) {
+	return *reinterpret_cast<const uint32_t*>(rdram + addr);
+}
+
+// Checks that every command in the task can be reproduced exactly, tracking SETBUFF to know
+// which buffers the vector loads and stores will touch.
+Fallback prescan(const uint8_t* rdram, uint32_t data, uint32_t size) {
+	for (uint32_t i = 0; i < kCommandCount; i++) {
+		if (aspmain::imem_target(dmem_u16(aspmain::kJumpTableAddr + 2 * i)) != aspmain::command_targets[i]) {
+			return Fallback::JumpTable;
+		}
+	}
+	if ((size == 0) || ((size & 7) != 0) || (size > kMaxTaskBytes)) {
+		return Fallback::TaskSize;
+	}
+
+	uint16_t in = dmem_u16(kAudioState + kIn);
+	uint16_t out = dmem_u16(kAudioState + kOut);
+	uint16_t dry_r = dmem_u16(kAudioState + kDryRight);
+	uint16_t wet_l = dmem_u16(kAudioState + kWetLeft);
+	uint16_t wet_r = dmem_u16(kAudioState + kWetRight);
+	for (uint32_t offset = 0; offset < size; offset += 8) {
+		const uint32_t w1 = command_word(rdram, data + offset);
+		const uint32_t w2 = command_word(rdram, data + offset + 4);
+		const uint32_t flags = w1 >> 16;
+		bool aligned = true;
+		switch ((w1 >> 24) & 0x7F) {
+		case A_SPNOOP:
+		case A_CLEARBUFF:
+		case A_LOADBUFF:
+		case A_SAVEBUFF:
+		case A_SEGMENT:
+		case A_SETVOL:
+		case A_DMEMMOVE:
+		case A_LOADADPCM:
+		case A_SETLOOP:
+			break;
+		case A_SETBUFF:
+			if ((flags & kFlagAux) != 0) {
+				wet_r = static_cast<uint16_t>(w2 + kBufferBase);
+				dry_r = static_cast<uint16_t>(w1 + kBufferBase);
+				wet_l = static_cast<uint16_t>((w2 >> 16) + kBufferBase);
+			} else {
+				in = static_cast<uint16_t>(w1 + kBufferBase);
+				out = static_cast<uint16_t>((w2 >> 16) + kBufferBase);
+			}
+			break;
+		case A_ADPCM:
+		case A_RESAMPLE:
+			aligned = (out & 0xF) == 0;
+			break;
+		case A_ENVMIXER:
+			aligned = ((in | out | dry_r) & 0xF) == 0;
+			if ((flags & kFlagAux) != 0) {
+				aligned = aligned && (((wet_l | wet_r) & 0xF) == 0);
+			}
+			break;
+		case A_MIXER:
+		case A_INTERLEAVE:
+			aligned = (((w2 >> 16) | w2) & 0xF) == 0;
+			break;
+		case A_POLEF:
+			return Fallback::Polef;
+		default:
+			return Fallback::Command;
+		}
+		if (!aligned) {
+			return Fallback::Alignment;
+		}
+	}
+	return Fallback::None;
+}
+
+void run_hle(uint8_t* rdram, uint32_t data, uint32_t size) {
+	for (uint32_t offset = 0; offset < size; offset += 8) {
+		const uint32_t w1 = command_word(rdram, data + offset);
+		const uint32_t w2 = command_word(rdram, data + offset + 4);
+		switch ((w1 >> 24) & 0x7F) {
+		case A_SPNOOP:                                  break;
+		case A_ADPCM:      cmd_adpcm(rdram, w1, w2);    break;
+		case A_CLEARBUFF:  cmd_clearbuff(w1, w2);       break;
+		case A_ENVMIXER:   cmd_envmixer(rdram, w1, w2); break;
+		case A_LOADBUFF:   cmd_loadbuff(rdram, w2);     break;
+		case A_RESAMPLE:   cmd_resample(rdram, w1, w2); break;
+		case A_SAVEBUFF:   cmd_savebuff(rdram, w2);     break;
+		case A_SEGMENT:    cmd_segment(w2);             break;
+		case A_SETBUFF:    cmd_setbuff(w1, w2);         break;
+		case A_SETVOL:     cmd_setvol(w1, w2);          break;
+		case A_DMEMMOVE:   cmd_dmemmove(w1, w2);        break;
+		case A_LOADADPCM:  cmd_loadadpcm(rdram, w1, w2); break;
+		case A_MIXER:      cmd_mixer(w1, w2);           break;
+		case A_INTERLEAVE: cmd_interleave(w2);          break;
+		case A_SETLOOP:    cmd_setloop(w2);             break;
+		default:                                        break;
+		}
+	}
+}
+
+// An RDRAM range as the RSP DMA touches it: the address masked like dma_read/dma_write, the
+// length rounded up to whole doublewords.
+capture::Range dma_range(uint32_t dram_addr, uint32_t length) {
+	return { dram_addr & 0xFFFFF8, (length + 7) & ~7u };
+}
+
+// ── Stats / verification ────────────────────────────────────────────────
+
+constexpr uint64_t kVerifyReportInterval = 1024;
+constexpr uint64_t kMismatchLogLimit = 16;
+
+struct Stats {
+	uint64_t hle_tasks = 0;
+	uint64_t fallbacks[static_cast<int>(Fallback::Count)] = {};
+	uint64_t verified = 0;
+	uint64_t mismatched = 0;
+	uint64_t hle_ns = 0;
+	uint64_t lle_ns = 0;
+};
+
+Stats s_stats;
+
+uint64_t now_ns() {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void note_fallback(Fallback reason) {
+	if (s_stats.fallbacks[static_cast<int>(reason)]++ == 0) {
+		std::printf("[AUDIO HLE] running tasks with %s on the LLE ucode\n", kFallbackNames[static_cast<int>(reason)]);
+		std::fflush(stdout);
+	}
+}
+
+RspExitReason verify_task(uint8_t* rdram, uint32_t ucode_addr, uint32_t data, uint32_t size) {
+	static std::array<uint8_t, kDmemSize> dmem_before;
+	static std::array<uint8_t, kDmemSize> dmem_hle;
+	std::memcpy(dmem_before.data(), dmem, kDmemSize);
+
+	s_writes.clear();
+	s_log_writes = true;
+	const uint64_t hle_start = now_ns();
+	run_hle(rdram, data, size);
+	const uint64_t hle_end = now_ns();
+	s_log_writes = false;
+
+	// Keep the HLE result, then put RDRAM and DMEM back for the LLE run.
+	for (RdramWrite& write : s_writes) {
+		write.after.assign(rdram + write.begin, rdram + write.end);
+	}
+	std::memcpy(dmem_hle.data(), dmem, kDmemSize);
+	for (auto it = s_writes.rbegin(); it != s_writes.rend(); ++it) {
+		std::memcpy(rdram + it->begin, it->before.data(), it->before.size());
+	}
+	std::memcpy(dmem, dmem_before.data(), kDmemSize);
+
+	const uint64_t lle_start = now_ns();
+	const RspExitReason reason = aspMain(rdram, ucode_addr);
+	const uint64_t lle_end = now_ns();
+
+	s_stats.verified++;
+	s_stats.hle_ns += hle_end - hle_start;
+	s_stats.lle_ns += lle_end - lle_start;
+
+	// Compare what the game will see: every RDRAM range the HLE wrote, and the DMEM buffers
+	// the next task may read back.
+	const char* where = nullptr;
+	uint32_t first = 0;
+	uint8_t hle_byte = 0;
+	uint8_t lle_byte = 0;
+	uint32_t differing = 0;
+	for (const RdramWrite& write : s_writes) {
+		for (uint32_t i = 0; i < write.after.size(); i++) {
+			const uint8_t lle = rdram[write.begin + i];
+			if (lle != write.after[i]) {
+				if (differing++ == 0) {
+					where = "RDRAM";
+					first = (write.begin + i) ^ 3;
+					hle_byte = write.after[i];
+					lle_byte = lle;
+				}
+			}
+		}
+	}
+	for (uint32_t addr = kAdpcmBook; addr < kStateStage; addr++) {
+		const uint8_t hle = dmem_hle[addr ^ 3];
+		const uint8_t lle = dmem[addr ^ 3];
+		if (hle != lle) {
+			if (differing++ == 0) {
+				where = "DMEM";
+				first = addr;
+				hle_byte = hle;
+				lle_byte = lle;
+			}
+		}
+	}
+
+	if (differing != 0) {
+		if (s_stats.mismatched++ < kMismatchLogLimit) {
+			std::printf("[AUDIO HLE] verify mismatch in task %llu: %u bytes differ, first at %s 0x%06X (hle=%02X lle=%02X)\n",
+				(unsigned long long)s_stats.verified, differing, where, first, hle_byte, lle_byte);
+			std::fflush(stdout);
+		}
+	}
+	if ((s_stats.verified % kVerifyReportInterval) == 0) {
+		std::printf("[AUDIO HLE] verify: %llu tasks, %llu mismatched, hle=%.1fus lle=%.1fus per task\n",
+			(unsigned long long)s_stats.verified, (unsigned long long)s_stats.mismatched,
+			s_stats.hle_ns / 1000.0 / s_stats.verified, s_stats.lle_ns / 1000.0 / s_stats.verified);
+		std::fflush(stdout);
+	}
+	return reason;
+}
+
+// ── Capture ─────────────────────────────────────────────────────────────
+
+// Sorted with overlapping and adjacent ranges joined, so sample data read by several
+// commands is stored once.
+std::vector<capture::Range> merge_ranges(std::vector<capture::Range> ranges) {
+	std::sort(ranges.begin(), ranges.end(), [](const capture::Range& a, const capture::Range& b) { return a.addr < b.addr; });
+	std::vector<capture::Range> merged;
+	for (const capture::Range& range : ranges) {
+		if (!merged.empty() && (range.addr <= merged.back().addr + merged.back().size)) {
+			capture::Range& last = merged.back();
+			last.size = std::max(last.addr + last.size, range.addr + range.size) - last.addr;
+		} else {
+			merged.push_back(range);
+		}
+	}
+	return merged;
+}
+
+// RDRAM reads seen by observe_lle_dma, rounded out to whole doublewords as the RSP DMA reads
+// them. Writes go to s_writes, like the HLE's own.
+std::vector<capture::Range> s_reads;
+
+void observe_lle_dma(const uint8_t* rdram, bool write, uint32_t dram_addr, uint32_t length_minus_one) {
+	const uint32_t length = length_minus_one + 1;
+	if (length == 0) {
+		return;
+	}
+	if (!write) {
+		s_reads.push_back(dma_range(dram_addr, length));
+		return;
+	}
+	RdramWrite& entry = s_writes.emplace_back();
+	entry.begin = dram_addr & 0xFFFFF8;
+	entry.end = (entry.begin + length + 3) & ~3u;
+	entry.before.assign(rdram + entry.begin, rdram + entry.end);
+}
+
+// Finds what the task reads and writes with a dry run of aspMain itself, so every task is
+// captured, including the ones the HLE hands back to the ucode. RDRAM and DMEM are then put
+// back so the real run sees the task untouched.
+void record_task(uint8_t* rdram, uint32_t ucode_addr, capture::TaskRecord& task) {
+	std::memcpy(task.dmem.data(), dmem, kDmemSize);
+
+	s_reads.clear();
+	s_writes.clear();
+	sssv::aspmain::dma_observer = observe_lle_dma;
+	aspMain(rdram, ucode_addr);
+	sssv::aspmain::dma_observer = nullptr;
+
+	for (auto it = s_writes.rbegin(); it != s_writes.rend(); ++it) {
+		std::memcpy(rdram + it->begin, it->before.data(), it->before.size());
+	}
+	std::memcpy(dmem, task.dmem.data(), kDmemSize);
+
+	task.inputs = merge_ranges(s_reads);
+	task.input_bytes.clear();
+	for (const capture::Range& range : task.inputs) {
+		task.input_bytes.insert(task.input_bytes.end(), rdram + range.addr, rdram + range.addr + range.size);
+	}
+	std::vector<capture::Range> writes;
+	writes.reserve(s_writes.size());
+	for (const RdramWrite& write : s_writes) {
+		writes.push_back({ write.begin, write.end - write.begin });
+	}
+	task.outputs = merge_ranges(std::move(writes));
+}
+
+} // namespace
+
+bool task_dma_ranges(const uint8_t* rdram, std::vector<capture::Range>& reads, std::vector<capture::Range>& writes) {
+	const uint32_t data = dmem_u32(kTaskDataPtr) & 0xFFFFF8;
+	const uint32_t size = dmem_u32(kTaskDataSize);
+	if ((size == 0) || ((size & 7) != 0) || (size > kMaxTaskBytes)) {
+		return false;
+	}
+
+	// The parameter commands run for real so segments, buffer counts and the loop address
+	// follow the ucode's own DMEM state; DMEM is put back afterward.
+	static std::array<uint8_t, kDmemSize> dmem_before;
+	std::memcpy(dmem_before.data(), dmem, kDmemSize);
+	reads.clear();
+	writes.clear();
+	reads.push_back(dma_range(data, size));
+	bool complete = true;
+	for (uint32_t offset = 0; complete && (offset < size); offset += 8) {
+		const uint32_t w1 = command_word(rdram, data + offset);
+		const uint32_t w2 = command_word(rdram, data + offset + 4);
+		const uint32_t flags = w1 >> 16;
+		const uint32_t count = dmem_u16(kAudioState + kCount);
+		switch ((w1 >> 24) & 0x7F) {
+		case A_SPNOOP:
+		case A_CLEARBUFF:
+		case A_DMEMMOVE:
+		case A_MIXER:
+		case A_INTERLEAVE:
+			break;
+		case A_SEGMENT: cmd_segment(w2);     break;
+		case A_SETBUFF: cmd_setbuff(w1, w2); break;
+		case A_SETVOL:  cmd_setvol(w1, w2);  break;
+		case A_SETLOOP: cmd_setloop(w2);     break;
+		case A_LOADBUFF:
+			if (count != 0) {
+				reads.push_back(dma_range(segment_address(w2), count));
+			}
+			break;
+		case A_SAVEBUFF:
+			if (count != 0) {
+				writes.push_back(dma_range(segment_address(w2), count));
+			}
+			break;
+		case A_LOADADPCM:
+			if ((w1 & 0xFFFF) != 0) {
+				reads.push_back(dma_range(segment_address(w2), w1 & 0xFFFF));
+			}
+			break;
+		case A_ADPCM:
+			if ((flags & kFlagInit) == 0) {
+				reads.push_back(dma_range(((flags & kFlagLoop) != 0) ? dmem_u32(kAudioState + kLoop) : segment_address(w2), 0x20));
+			}
+			writes.push_back(dma_range(segment_address(w2), 0x20));
+			break;
+		case A_RESAMPLE:
+			if ((flags & kFlagInit) == 0) {
+				reads.push_back(dma_range(segment_address(w2), 0x20));
+			}
+			writes.push_back(dma_range(segment_address(w2), 0x20));
+			break;
+		case A_ENVMIXER:
+			if ((flags & kFlagInit) == 0) {
+				reads.push_back(dma_range(segment_address(w2), 0x50));
+			}
+			writes.push_back(dma_range(segment_address(w2), 0x50));
+			break;
+		default:
+			// POLEF's state and anything unknown.
+			complete = false;
+			break;
+		}
+	}
+	std::memcpy(dmem, dmem_before.data(), kDmemSize);
+	if (!complete) {
+		reads.clear();
+		writes.clear();
+	}
+	return complete;
+}
+
+void set_enabled(bool enabled) {
+	g_enabled = enabled;
+}
+
+void set_verify(bool verify) {
+	g_verify = verify;
+}
+
+Mode mode() {
+	if (g_verify) {
+		return Mode::Verify;
+	}
+	return g_enabled ? Mode::Hle : Mode::Lle;
+}
+
+RspExitReason run_task(uint8_t* rdram, uint32_t ucode_addr) {
+	sssv::timeline::Span span("audio_task");
+	const Mode current = mode();
+	const bool capturing = capture::enabled();
+	if ((current == Mode::Lle) && !capturing) {
+		return aspMain(rdram, ucode_addr);
+	}
+
+	static capture::TaskRecord captured;
+	if (capturing) {
+		record_task(rdram, ucode_addr, captured);
+	}
+
+	// Same masking as the ucode's command list DMA.
+	const uint32_t data = dmem_u32(kTaskDataPtr) & 0xFFFFF8;
+	const uint32_t size = dmem_u32(kTaskDataSize);
+	const Fallback fallback = (current == Mode::Lle) ? Fallback::None : prescan(rdram, data, size);
+	if (fallback != Fallback::None) {
+		note_fallback(fallback);
+	}
+
+	RspExitReason reason = RspExitReason::Broke;
+	if ((current == Mode::Lle) || (fallback != Fallback::None)) {
+		reason = aspMain(rdram, ucode_addr);
+	} else if (current == Mode::Verify) {
+		reason = verify_task(rdram, ucode_addr, data, size);
+	} else {
+		run_hle(rdram, data, size);
+		s_stats.hle_tasks++;
+	}
+
+	if (capturing) {
+		captured.output_hash = capture::hash_outputs(rdram, captured.outputs);
+		capture::write_task(captured);
+	}
+	return reason;
+}
+
+} // namespace sssv::audio_hle
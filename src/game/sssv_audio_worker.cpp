@@ -0,0 +1,135 @@
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "sssv_audio_hle.h"
+#include "sssv_audio_worker.h"
+#include "sssv_timeline.h"
+
+namespace sssv::audio_worker {
+
+namespace {
+
+namespace capture = sssv::audio_hle::capture;
+
+// The ucode masks DMA addresses to 24 bits; the margin covers a range starting near the top.
+constexpr size_t kShadowBytes = (16u << 20) + 0x10000;
+
+struct Task {
+	uint8_t* rdram = nullptr; // the game's RDRAM, where the task's writes go back to
+	uint32_t ucode_addr = 0;
+	std::vector<capture::Range> writes;
+};
+
+struct Worker {
+	std::mutex mutex;
+	std::condition_variable task_ready;
+	std::condition_variable task_done;
+	std::thread thread;
+	Task task;
+	bool has_task = false; // set from submission until the task has finished
+	bool stopping = false;
+	// Private RDRAM image the queued task runs against. Only the ranges the task touches are
+	// kept current.
+	std::unique_ptr<uint8_t[]> shadow;
+	std::vector<capture::Range> reads;
+};
+
+std::atomic<bool> g_enabled = false;
+Worker s_worker;
+
+void copy_ranges(uint8_t* dst, const uint8_t* src, const std::vector<capture::Range>& ranges) {
+	for (const capture::Range& range : ranges) {
+		std::memcpy(dst + range.addr, src + range.addr, range.size);
+	}
+}
+
+void worker_main() {
+	sssv::timeline::name_current_thread("Audio Worker");
+	std::unique_lock lock(s_worker.mutex);
+	while (true) {
+		s_worker.task_ready.wait(lock, [] { return s_worker.has_task || s_worker.stopping; });
+		if (!s_worker.has_task) {
+			return;
+		}
+		const uint32_t ucode_addr = s_worker.task.ucode_addr;
+		lock.unlock();
+
+		const RspExitReason reason = sssv::audio_hle::run_task(s_worker.shadow.get(), ucode_addr);
+		if (reason != RspExitReason::Broke) {
+			printf("[AUDIO WORKER] aspMain exited with reason %d\n", static_cast<int>(reason));
+			fflush(stdout);
+		}
+
+		lock.lock();
+		copy_ranges(s_worker.task.rdram, s_worker.shadow.get(), s_worker.task.writes);
+		s_worker.has_task = false;
+		s_worker.task_done.notify_all();
+	}
+}
+
+} // namespace
+
+void set_enabled(bool enabled) {
+	g_enabled = enabled;
+}
+
+bool enabled() {
+	return g_enabled;
+}
+
+RspExitReason submit_task(uint8_t* rdram, uint32_t ucode_addr) {
+	std::unique_lock lock(s_worker.mutex);
+	// get_rsp_microcode already waited; this only covers the worker being toggled mid-task.
+	s_worker.task_done.wait(lock, [] { return !s_worker.has_task; });
+
+	Task& task = s_worker.task;
+	if (!sssv::audio_hle::task_dma_ranges(rdram, s_worker.reads, task.writes)) {
+		// Without the full list of what it reads, the task cannot run on a copy.
+		lock.unlock();
+		return sssv::audio_hle::run_task(rdram, ucode_addr);
+	}
+
+	if (!s_worker.shadow) {
+		s_worker.shadow = std::make_unique<uint8_t[]>(kShadowBytes);
+	}
+	// Written ranges are copied in too, so the parts of a doubleword the task leaves alone go
+	// back unchanged.
+	copy_ranges(s_worker.shadow.get(), rdram, s_worker.reads);
+	copy_ranges(s_worker.shadow.get(), rdram, task.writes);
+
+	if (!s_worker.thread.joinable()) {
+		s_worker.stopping = false;
+		s_worker.thread = std::thread(worker_main);
+	}
+	task.rdram = rdram;
+	task.ucode_addr = ucode_addr;
+	s_worker.has_task = true;
+	s_worker.task_ready.notify_one();
+	return RspExitReason::Broke;
+}
+
+void wait_idle() {
+	std::unique_lock lock(s_worker.mutex);
+	s_worker.task_done.wait(lock, [] { return !s_worker.has_task; });
+}
+
+void shutdown() {
+	{
+		std::lock_guard lock(s_worker.mutex);
+		if (!s_worker.thread.joinable()) {
+			return;
+		}
+		s_worker.stopping = true;
+		s_worker.task_ready.notify_one();
+	}
+	// The worker finishes a pending task before it sees stopping.
+	s_worker.thread.join();
+}
+
+} // namespace sssv::audio_worker
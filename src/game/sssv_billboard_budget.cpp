@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "sssv_billboard_budget.h"
+#include "sssv_billboard_controls.h"
+
+namespace sssv::billboard::budget {
+
+std::atomic<bool> g_enabled{ false };
+
+namespace {
+
+// NTSC VI period.
+constexpr uint64_t kViPeriodNs = 16'683'333;
+
+// Frames slower than the target by more than this fraction count as over budget.
+constexpr double kOverloadTolerance = 0.10;
+
+// Submits per target window. The target follows the fastest cadence seen in a window; it
+// drops immediately but only rises after kRaiseWindows slower windows in a row, so a
+// stretch of overloaded frames is not mistaken for a new cadence.
+constexpr int kTargetWindowFrames = 256;
+constexpr int kRaiseWindows = 8;
+
+// Frames to wait after a decrease before reacting again, so the cut can take effect.
+constexpr int kDecreaseCooldownFrames = 16;
+constexpr int kLodIncreaseStep = 2;
+constexpr int kRewriteIncreaseStep = 8;
+
+// Renderer side state. Only touched from on_display_list_submitted.
+uint64_t s_last_submit_ns = 0;
+int s_window_frames = 0;
+int s_window_min_vis = INT32_MAX;
+int s_slower_windows = 0;
+
+// Published to the game thread.
+std::atomic<uint64_t> s_smoothed_interval_ns{ 0 };
+std::atomic<int> s_target_vis{ 0 };
+
+// Game side state.
+uint32_t s_frame_key = 0;
+int s_lod_budget = kLodBudgetMax;
+int s_rewrite_budget = kRewriteBudgetMax;
+int s_lod_used = 0;
+// Camera distances of this frame's LOD checks; at the next frame they give the cutoff that
+// lets the nearest lod_budget() checks through, whatever order the game runs them in.
+std::vector<float> s_lod_distances;
+float s_lod_cutoff = std::numeric_limits<float>::infinity();
+int s_rewrite_used[telemetry::kHookCount] = {};
+int s_cooldown = 0;
+std::atomic<bool> s_reset_pending{ false };
+
+uint64_t now_ns() {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void update_target(int interval_vis) {
+	s_window_min_vis = std::min(s_window_min_vis, interval_vis);
+	if (++s_window_frames < kTargetWindowFrames) {
+		return;
+	}
+
+	const int target = s_target_vis.load(std::memory_order_relaxed);
+	if ((target == 0) || (s_window_min_vis <= target)) {
+		s_target_vis.store(s_window_min_vis, std::memory_order_relaxed);
+		s_slower_windows = 0;
+	} else if (++s_slower_windows >= kRaiseWindows) {
+		s_target_vis.store(s_window_min_vis, std::memory_order_relaxed);
+		s_slower_windows = 0;
+	}
+	s_window_frames = 0;
+	s_window_min_vis = INT32_MAX;
+}
+
+} // namespace
+
+void set_enabled(bool enabled) {
+	if (enabled && !g_enabled) {
+		s_reset_pending.store(true);
+	}
+	g_enabled = enabled;
+	// The LOD hook runs only while the budget or Disable LOD is on.
+	refresh_hooks();
+}
+
+void on_display_list_submitted() {
+	const uint64_t now = now_ns();
+	const uint64_t last = s_last_submit_ns;
+	s_last_submit_ns = now;
+	if (!g_enabled || (last == 0)) {
+		return;
+	}
+
+	const uint64_t interval = now - last;
+	// Long stalls (loading, pausing the window) say nothing about rendering cost.
+	if (interval > (kViPeriodNs * 30)) {
+		return;
+	}
+
+	const uint64_t smoothed = s_smoothed_interval_ns.load(std::memory_order_relaxed);
+	const uint64_t next = (smoothed == 0) ? interval : (smoothed - (smoothed / 8) + (interval / 8));
+	s_smoothed_interval_ns.store(next, std::memory_order_relaxed);
+
+	const int interval_vis = std::max(1, static_cast<int>(std::lround(static_cast<double>(interval) / kViPeriodNs)));
+	update_target(interval_vis);
+}
+
+void begin_frame(uint32_t frame_key) {
+	if (frame_key == s_frame_key) {
+		return;
+	}
+	s_frame_key = frame_key;
+	s_lod_used = 0;
+	std::fill(std::begin(s_rewrite_used), std::end(s_rewrite_used), 0);
+
+	s_lod_cutoff = std::numeric_limits<float>::infinity();
+	if ((s_lod_budget > 0) && (s_lod_distances.size() > static_cast<size_t>(s_lod_budget))) {
+		auto nth = s_lod_distances.begin() + (s_lod_budget - 1);
+		std::nth_element(s_lod_distances.begin(), nth, s_lod_distances.end());
+		s_lod_cutoff = *nth;
+	}
+	s_lod_distances.clear();
+
+	if (s_reset_pending.exchange(false)) {
+		s_lod_budget = kLodBudgetMax;
+		s_rewrite_budget = kRewriteBudgetMax;
+		s_cooldown = 0;
+		return;
+	}
+
+	const int target = s_target_vis.load(std::memory_order_relaxed);
+	const uint64_t smoothed = s_smoothed_interval_ns.load(std::memory_order_relaxed);
+	if ((target == 0) || (smoothed == 0)) {
+		return;
+	}
+
+	if (s_cooldown > 0) {
+		s_cooldown--;
+	}
+	const double limit_ns = static_cast<double>(target) * kViPeriodNs * (1.0 + kOverloadTolerance);
+	if (static_cast<double>(smoothed) > limit_ns) {
+		if (s_cooldown == 0) {
+			s_lod_budget = std::max(kLodBudgetMin, s_lod_budget / 2);
+			s_rewrite_budget = std::max(kRewriteBudgetMin, s_rewrite_budget / 2);
+			s_cooldown = kDecreaseCooldownFrames;
+		}
+	} else {
+		s_lod_budget = std::min(kLodBudgetMax, s_lod_budget + kLodIncreaseStep);
+		s_rewrite_budget = std::min(kRewriteBudgetMax, s_rewrite_budget + kRewriteIncreaseStep);
+	}
+}
+
+bool take_lod(float distance) {
+	if (s_lod_distances.size() < kMaxLodChecks) {
+		s_lod_distances.push_back(distance);
+	}
+	if ((s_lod_used >= s_lod_budget) || !(distance <= s_lod_cutoff)) {
+		return false;
+	}
+	s_lod_used++;
+	return true;
+}
+
+bool take_rewrite(telemetry::Hook hook) {
+	int& used = s_rewrite_used[static_cast<int>(hook)];
+	if (used >= s_rewrite_budget) {
+		return false;
+	}
+	used++;
+	return true;
+}
+
+int lod_budget() { return s_lod_budget; }
+int rewrite_budget() { return s_rewrite_budget; }
+int target_vis() { return s_target_vis.load(std::memory_order_relaxed); }
+
+} // namespace sssv::billboard::budget
@@ -0,0 +1,123 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+#include "sssv_billboard_capture.h"
+
+namespace sssv::billboard::capture {
+
+std::atomic<bool> g_enabled{ false };
+
+namespace {
+
+constexpr size_t kWriteBufferBytes = 1 << 20;
+
+std::mutex s_mutex;
+std::FILE* s_file = nullptr;
+FrameRecord s_last_frame;
+bool s_has_last_frame = false;
+uint64_t s_calls_written = 0;
+
+} // namespace
+
+bool start(const std::filesystem::path& path) {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	if (s_file != nullptr) {
+		return true;
+	}
+
+	s_file = std::fopen(path.string().c_str(), "wb");
+	if (s_file == nullptr) {
+		std::printf("[BILLBOARD CAPTURE] failed to open %s\n", path.string().c_str());
+		return false;
+	}
+	std::setvbuf(s_file, nullptr, _IOFBF, kWriteBufferBytes);
+
+	const CaptureHeader header{};
+	std::fwrite(&header, sizeof(header), 1, s_file);
+	s_has_last_frame = false;
+	s_calls_written = 0;
+	g_enabled = true;
+
+	std::printf("[BILLBOARD CAPTURE] recording to %s\n", path.string().c_str());
+	std::fflush(stdout);
+	return true;
+}
+
+void stop() {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	g_enabled = false;
+	if (s_file == nullptr) {
+		return;
+	}
+	std::fclose(s_file);
+	s_file = nullptr;
+
+	std::printf("[BILLBOARD CAPTURE] stopped after %llu calls\n", (unsigned long long)s_calls_written);
+	std::fflush(stdout);
+}
+
+void write_frame(const FrameRecord& frame) {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	if (s_file == nullptr) {
+		return;
+	}
+	if (s_has_last_frame && (std::memcmp(&s_last_frame, &frame, sizeof(frame)) == 0)) {
+		return;
+	}
+	std::fwrite(&frame, sizeof(frame), 1, s_file);
+	s_last_frame = frame;
+	s_has_last_frame = true;
+}
+
+void write_call(const CallRecord& call) {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	if (s_file == nullptr) {
+		return;
+	}
+	std::fwrite(&call, sizeof(call), 1, s_file);
+	s_calls_written++;
+}
+
+bool load(const std::filesystem::path& path, CaptureFile& out) {
+	std::ifstream in(path, std::ios::binary);
+	if (!in.is_open()) {
+		return false;
+	}
+
+	CaptureHeader header;
+	if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || (header.magic != kMagic) || (header.version != kVersion)) {
+		return false;
+	}
+
+	out = CaptureFile{};
+	bool have_frame = false;
+	RecordType type;
+	while (in.read(reinterpret_cast<char*>(&type), sizeof(type))) {
+		if (type == RecordType::Frame) {
+			FrameRecord frame;
+			if (!in.read(reinterpret_cast<char*>(&frame) + sizeof(type), sizeof(frame) - sizeof(type))) {
+				return false;
+			}
+			out.frames.push_back(frame);
+			have_frame = true;
+		} else if (type == RecordType::Call) {
+			CallRecord call;
+			if (!in.read(reinterpret_cast<char*>(&call) + sizeof(type), sizeof(call) - sizeof(type))) {
+				return false;
+			}
+			// Calls before the first frame record have no game state to replay against.
+			if (!have_frame) {
+				continue;
+			}
+			out.calls.push_back(call);
+			out.call_frame.push_back(static_cast<uint32_t>(out.frames.size() - 1));
+		} else {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace sssv::billboard::capture
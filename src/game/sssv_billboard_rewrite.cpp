@@ -1,13 +1,23 @@
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
-#include <unordered_map>
+#include <limits>
+#include <mutex>
+#include <vector>
 
 #include "recomp.h"
 #include "rt64_extended_gbi.h"
+#include "sssv_billboard_budget.h"
+#include "sssv_billboard_capture.h"
 #include "sssv_billboard_controls.h"
+#include "sssv_billboard_projection.h"
+#include "sssv_billboard_telemetry.h"
+#include "sssv_hooks.h"
+#include "sssv_timeline.h"
 
 // Debug logging: on in debug builds, off in release builds.
 #ifndef SSSV_BILLBOARD_DEBUG
@@ -39,9 +49,18 @@ constexpr int DISPLAYLIST_OFF_VIEWPROJ_F32 = 0x38A10;
 // shared with other game data. Instead, we allocate our own pool in extended RDRAM
 // (addresses >= 0x80800000). The recomp framework allocates 512 MB, so this is safe.
 // RT64's gEXSetRDRAMExtended (which we already emit) handles these addresses.
-constexpr uint32_t BILLBOARD_POOL_VRAM  = 0x80900000u;
-constexpr int      BILLBOARD_POOL_SLOTS = 8192;  // 8192 * 16 = 128 KB
-constexpr int      BILLBOARD_SLOT_BYTES = 16;
+//
+// The pool is split into regions used round-robin, one per frame, so a new frame never
+// overwrites vertices RT64 may still be reading for a frame that is in flight. Each region
+// reserves BILLBOARD_POOL_MAX_SLOTS of address space; its working capacity starts at the
+// old fixed pool size and is resized from observed high-water marks.
+constexpr uint32_t BILLBOARD_POOL_VRAM          = 0x80900000u;
+constexpr int      BILLBOARD_SLOT_BYTES         = 16;
+constexpr int      BILLBOARD_POOL_REGIONS       = 3;
+constexpr int      BILLBOARD_POOL_MAX_SLOTS     = 32768; // per region: 32768 * 16 = 512 KB
+constexpr int      BILLBOARD_POOL_INITIAL_SLOTS = 8192;  // 8192 * 16 = 128 KB
+constexpr int      BILLBOARD_POOL_GRANULE_SLOTS = 1024;  // capacity is kept a multiple of this
+constexpr uint32_t BILLBOARD_POOL_REGION_BYTES  = static_cast<uint32_t>(BILLBOARD_POOL_MAX_SLOTS) * BILLBOARD_SLOT_BYTES;
 
 constexpr uint32_t CMD_SETPRIMDEPTH = 0xEE000000;
 constexpr uint32_t CMD_TRI2         = 0xB1000000; // F3DEX G_TRI2
@@ -65,32 +84,37 @@ constexpr uint32_t RDRAM_SIZE_BYTES = 0x0080'0000u;
 // Cull threshold for "behind camera". Kept as a named constant for clarity/tuning.
 constexpr float kBehindCameraZ = -3.0f;
 
-bool g_disable_6fa3a4_render = false;
-bool g_disable_lod = false;
-bool g_disable_6c5e44_render = false;
-bool g_disable_73f17c_render = false;
-bool g_disable_73f800_render = false;
-bool g_disable_740094_render = false;
-bool g_disable_740820_render = false;
-bool g_rewrite_6c5e44_ortho  = true;
-bool g_rewrite_73f17c_ortho  = true;
-bool g_rewrite_73f800_ortho  = true;
-bool g_rewrite_740094_ortho  = true;
-bool g_rewrite_740820_ortho  = true;
+// Written by the config thread, read by the hooks on the game thread.
+std::atomic<bool> g_disable_6fa3a4_render = false;
+std::atomic<bool> g_disable_lod = false;
+std::atomic<bool> g_disable_6c5e44_render = false;
+std::atomic<bool> g_disable_73f17c_render = false;
+std::atomic<bool> g_disable_73f800_render = false;
+std::atomic<bool> g_disable_740094_render = false;
+std::atomic<bool> g_disable_740820_render = false;
+std::atomic<bool> g_rewrite_6c5e44_ortho  = true;
+std::atomic<bool> g_rewrite_73f17c_ortho  = true;
+std::atomic<bool> g_rewrite_73f800_ortho  = true;
+std::atomic<bool> g_rewrite_740094_ortho  = true;
+std::atomic<bool> g_rewrite_740820_ortho  = true;
+std::atomic<bool> g_billboard_batch_emit  = true;
+std::atomic<bool> g_billboard_deferred_projection = false;
+std::atomic<bool> g_billboard_texture_sort = false;
+std::atomic<bool> g_billboard_owner_identity = false;
 #if defined(NDEBUG)
-bool g_rewrite_6c5e44_suppress_original = true;
-bool g_rewrite_73f17c_suppress_original = true;  // Release: Hide Original On
-bool g_rewrite_73f800_suppress_original = true;
-bool g_rewrite_740094_suppress_original = true;
-bool g_rewrite_740820_suppress_original = true;
-bool g_log_73f17c_ortho = false;                 // Release: Ortho Logs Off
+std::atomic<bool> g_rewrite_6c5e44_suppress_original = true;
+std::atomic<bool> g_rewrite_73f17c_suppress_original = true;  // Release: Hide Original On
+std::atomic<bool> g_rewrite_73f800_suppress_original = true;
+std::atomic<bool> g_rewrite_740094_suppress_original = true;
+std::atomic<bool> g_rewrite_740820_suppress_original = true;
+std::atomic<bool> g_log_73f17c_ortho = false;                 // Release: Ortho Logs Off
 #else
-bool g_rewrite_6c5e44_suppress_original = false;
-bool g_rewrite_73f17c_suppress_original = false;
-bool g_rewrite_73f800_suppress_original = false;
-bool g_rewrite_740094_suppress_original = false;
-bool g_rewrite_740820_suppress_original = false;
-bool g_log_73f17c_ortho = true;
+std::atomic<bool> g_rewrite_6c5e44_suppress_original = false;
+std::atomic<bool> g_rewrite_73f17c_suppress_original = false;
+std::atomic<bool> g_rewrite_73f800_suppress_original = false;
+std::atomic<bool> g_rewrite_740094_suppress_original = false;
+std::atomic<bool> g_rewrite_740820_suppress_original = false;
+std::atomic<bool> g_log_73f17c_ortho = true;
 #endif
 uint64_t g_billboard_frame_count = 0;
 
@@ -126,6 +150,9 @@ struct RewriteTrace {
 	float xh = 0.0f;
 	float yh = 0.0f;
 	uint32_t group_id = 0;
+	bool batched = false;        // appended to an open run instead of emitting a new one
+	bool deferred = false;       // queued for batch projection (quad patched at flush)
+	bool sorted = false;         // queued for the texture-sorted list
 };
 
 static const char* rewrite_outcome_name(RewriteOutcome outcome) {
@@ -171,16 +198,70 @@ static_assert(sizeof(Rt64VertexExV1) == 24, "Unexpected Rt64VertexExV1 size");
 
 // Cache of previous quad screen-space positions for interpolation.
 struct PrevQuad {
+	uint32_t key;     // group_id (never 0); 0 marks a slot that was never used
+	uint32_t stamp;   // low 32 bits of g_quad_stamp at the last update
 	int16_t x[4];
 	int16_t y[4];
 	// Optional signature to reduce rare hash-collision artifacts.
 	int32_t sig_x;
 	int32_t sig_y;
 	int32_t sig_z;
-	uint64_t stamp;
 };
 
-std::unordered_map<uint32_t, PrevQuad> g_prev_quads;
+static_assert(sizeof(PrevQuad) == 36, "Unexpected PrevQuad size");
+
+// Quads not updated within this many billboard draws are no longer interpolated from,
+// and their cache slots become free for reuse.
+constexpr uint32_t kPrevQuadRecentStamps = 300;
+
+// Fixed-capacity open-addressing table (linear probing) for PrevQuad entries.
+// Lives in static storage, so there is no heap allocation and a hard 288 KB cap.
+// Entries age out by stamp instead of being erased: a stale slot is simply taken over
+// by the next key that probes through it, so no cleanup pass is ever needed.
+class PrevQuadCache {
+public:
+	static constexpr uint32_t kCapacity = 8192; // must be a power of two
+	static constexpr uint32_t kMaxProbe = 16;
+
+	// Single probe sequence for lookup and insert. Returns the slot already holding key
+	// (found = true), otherwise the slot the caller should overwrite: the first empty or
+	// stale slot on the probe path, or the oldest one if the whole window is live.
+	PrevQuad& find_or_insert(uint32_t key, uint32_t now, bool& found) {
+		const uint32_t home = (key * 0x9E3779B1u) >> (32 - kCapacityBits);
+		PrevQuad* victim = nullptr;
+		PrevQuad* oldest = nullptr;
+		for (uint32_t i = 0; i < kMaxProbe; i++) {
+			PrevQuad& entry = entries_[(home + i) & (kCapacity - 1)];
+			if (entry.key == key) {
+				found = true;
+				return entry;
+			}
+			if (entry.key == 0) {
+				// Keys are never placed past a never-used slot, so the search ends here.
+				if (victim == nullptr) victim = &entry;
+				break;
+			}
+			const uint32_t age = now - entry.stamp;
+			if ((victim == nullptr) && (age > kPrevQuadRecentStamps)) {
+				victim = &entry;
+			}
+			if ((oldest == nullptr) || (age > (now - oldest->stamp))) {
+				oldest = &entry;
+			}
+		}
+		found = false;
+		return (victim != nullptr) ? *victim : *oldest;
+	}
+
+private:
+	static constexpr uint32_t kCapacityBits = 13;
+	static_assert((1u << kCapacityBits) == kCapacity, "kCapacityBits must match kCapacity");
+
+	PrevQuad entries_[kCapacity] = {};
+};
+
+PrevQuadCache g_prev_quads;
+PrevQuadCache g_owner_quads; // keyed by owner identity; kept apart so keys never meet position hashes
 uint64_t g_quad_stamp = 0;
 
 inline uint32_t vram_to_phys_u32(gpr vram_addr) {
@@ -249,18 +330,52 @@ static bool try_get_gfx_ptr(uint8_t* rdram, gpr vram_ptr, GfxWriteContext& out)
 	return true;
 }
 
+// Stretches of the game's display lists that hold our own commands. The texture sort's
+// display list walk steps over them, since the extended commands in them are not all one
+// command long. Only recorded while the texture sort is on, and only touched under
+// s_billboard_mutex.
+struct EmittedRange {
+	uint32_t begin_phys = 0;
+	uint32_t end_phys = 0;
+	uint64_t frame = 0;
+};
+
+static std::vector<EmittedRange> s_emitted_ranges;
+static bool s_track_emitted = false; // game thread: the current call runs with the texture sort on
+
 static void advance_gfx_ptr(uint8_t* rdram, const GfxWriteContext& wctx, GfxCommand* end_cmd, gpr vram_ptr) {
 	// end_cmd is in the same region starting at wctx.gfx_mem.
 	const ptrdiff_t written = reinterpret_cast<uint8_t*>(end_cmd) - wctx.gfx_mem;
 	const gpr new_gdl = ADD32(wctx.gdl_vram, static_cast<gpr>(written));
 	MEM_W(0, vram_ptr) = static_cast<int32_t>(new_gdl);
+	if (s_track_emitted) {
+		// A continued run starts inside the previous range (it rewinds over the run tail).
+		const uint32_t begin = wctx.gdl_phys;
+		const uint32_t end = begin + static_cast<uint32_t>(written);
+		if (!s_emitted_ranges.empty() && (s_emitted_ranges.back().end_phys == begin) && (s_emitted_ranges.back().frame == g_billboard_frame_count)) {
+			s_emitted_ranges.back().end_phys = std::max(s_emitted_ranges.back().end_phys, end);
+		} else {
+			s_emitted_ranges.push_back({ begin, end, g_billboard_frame_count });
+		}
+	}
 	(void)rdram;
 }
 
+// Drops the emitted ranges of frames before first_frame.
+static void prune_emitted_ranges(uint64_t first_frame) {
+	s_emitted_ranges.erase(std::remove_if(s_emitted_ranges.begin(), s_emitted_ranges.end(),
+		[first_frame](const EmittedRange& range) { return range.frame < first_frame; }), s_emitted_ranges.end());
+}
+
 // Per-frame billboard allocator in extended RDRAM with integrated matrix cache.
 struct BillboardAllocator {
 	gpr dl_state = 0;            // frame detection: new dl_state = new frame
 	int32_t used_slots = 0;      // linear allocation counter, reset each frame
+	int region = 0;              // pool region used by the current frame
+	int32_t region_end[BILLBOARD_POOL_REGIONS] = {}; // slots used by a region's frame once it ended
+	int32_t capacity_slots = BILLBOARD_POOL_INITIAL_SLOTS; // working size of each region
+	uint64_t grow_count = 0;     // times a frame grew the working capacity
+	uint64_t overflow_count = 0; // allocations refused because a region was full
 	// Ortho/identity matrix cache in extended RDRAM (shared across all billboard types within a frame)
 	gpr proj_mtx_addr = 0;
 	gpr view_mtx_addr = 0;
@@ -274,19 +389,77 @@ struct BillboardAllocator {
 
 static BillboardAllocator s_alloc;
 
+constexpr int32_t round_up_pool_slots(int32_t slots) {
+	return ((slots + (BILLBOARD_POOL_GRANULE_SLOTS - 1)) / BILLBOARD_POOL_GRANULE_SLOTS) * BILLBOARD_POOL_GRANULE_SLOTS;
+}
+
+// Switches to the next pool region for a new frame. The working capacity follows the
+// previous frame's high-water mark plus 25% headroom: it shrinks slowly (1/8 of the gap
+// per frame) so a single quiet frame does not undo a grow.
+static void begin_billboard_pool_frame() {
+	const int32_t prev_used = s_alloc.used_slots;
+	const int32_t target = std::clamp(round_up_pool_slots(prev_used + (prev_used / 4)),
+		BILLBOARD_POOL_INITIAL_SLOTS, BILLBOARD_POOL_MAX_SLOTS);
+	if (target < s_alloc.capacity_slots) {
+		const int32_t shrunk = s_alloc.capacity_slots - ((s_alloc.capacity_slots - target) / 8);
+		s_alloc.capacity_slots = std::max(target, (shrunk / BILLBOARD_POOL_GRANULE_SLOTS) * BILLBOARD_POOL_GRANULE_SLOTS);
+	}
+	s_alloc.region_end[s_alloc.region] = s_alloc.used_slots;
+	s_alloc.region = (s_alloc.region + 1) % BILLBOARD_POOL_REGIONS;
+	s_alloc.used_slots = 0;
+}
+
+// Returns false (and counts an overflow) if this frame's region cannot fit slots_needed more
+// slots. Demand past the working capacity grows it into the region's reservation.
+static bool reserve_billboard_pool_slots(int32_t slots_needed) {
+	const int32_t needed_end = s_alloc.used_slots + slots_needed;
+	if (needed_end <= s_alloc.capacity_slots) {
+		return true;
+	}
+	if (needed_end > BILLBOARD_POOL_MAX_SLOTS) {
+		s_alloc.overflow_count++;
+		return false;
+	}
+	s_alloc.capacity_slots = std::min(BILLBOARD_POOL_MAX_SLOTS, round_up_pool_slots(needed_end + (needed_end / 4)));
+	s_alloc.grow_count++;
+	return true;
+}
+
 static bool allocate_billboard_data(uint8_t* rdram, int bytes_needed, gpr& out_addr) {
 	const int slots_needed = (bytes_needed + (BILLBOARD_SLOT_BYTES - 1)) / BILLBOARD_SLOT_BYTES;
-	if ((s_alloc.used_slots + slots_needed) > BILLBOARD_POOL_SLOTS) {
+	if (!reserve_billboard_pool_slots(slots_needed)) {
 		return false;
 	}
 
+	const uint32_t region_base = BILLBOARD_POOL_VRAM + (static_cast<uint32_t>(s_alloc.region) * BILLBOARD_POOL_REGION_BYTES);
 	const uint32_t offset = static_cast<uint32_t>(s_alloc.used_slots) * BILLBOARD_SLOT_BYTES;
-	out_addr = static_cast<gpr>(static_cast<int32_t>(BILLBOARD_POOL_VRAM + offset));
+	out_addr = static_cast<gpr>(static_cast<int32_t>(region_base + offset));
 	s_alloc.used_slots += slots_needed;
 	(void)rdram;
 	return true;
 }
 
+// Allocates from a given frame's region: the current one, or the region of a frame that has
+// ended but whose display list is still being submitted. An ended frame's data is appended
+// past what that frame used, up to the region's reservation.
+static bool allocate_billboard_data_in_region(uint8_t* rdram, int region, int bytes_needed, gpr& out_addr) {
+	if (region == s_alloc.region) {
+		return allocate_billboard_data(rdram, bytes_needed, out_addr);
+	}
+	const int slots_needed = (bytes_needed + (BILLBOARD_SLOT_BYTES - 1)) / BILLBOARD_SLOT_BYTES;
+	int32_t& end = s_alloc.region_end[region];
+	if ((end + slots_needed) > BILLBOARD_POOL_MAX_SLOTS) {
+		s_alloc.overflow_count++;
+		return false;
+	}
+	const uint32_t region_base = BILLBOARD_POOL_VRAM + (static_cast<uint32_t>(region) * BILLBOARD_POOL_REGION_BYTES);
+	out_addr = static_cast<gpr>(static_cast<int32_t>(region_base + (static_cast<uint32_t>(end) * BILLBOARD_SLOT_BYTES)));
+	end += slots_needed;
+	return true;
+}
+
+namespace budget = sssv::billboard::budget;
+
 // ── Per-function diagnostic stats (logged every ~5 seconds) ──────────────
 
 struct BillboardStats {
@@ -295,6 +468,9 @@ struct BillboardStats {
 	uint64_t interval_emits = 0;
 	uint64_t interval_suppresses = 0;
 	uint64_t interval_skips = 0;
+	uint64_t interval_batched = 0;
+	uint64_t interval_deferred = 0;
+	uint64_t interval_sorted = 0;
 	uint64_t interval_fail_counts[12] = {};
 	uint64_t last_log_frame = 0;
 	int32_t sample_wx = 0, sample_wy = 0, sample_wz = 0;
@@ -324,10 +500,13 @@ static void maybe_log_stats(BillboardStats& s) {
 		uint64_t total_fails = 0;
 		for (int i = 1; i < 12; i++) total_fails += s.interval_fail_counts[i];
 
-		std::printf("[BILLBOARD %s] calls=%llu emit=%llu suppress=%llu skip=%llu fail=%llu",
+		std::printf("[BILLBOARD %s] calls=%llu emit=%llu batched=%llu deferred=%llu sorted=%llu suppress=%llu skip=%llu fail=%llu",
 			s.label,
 			(unsigned long long)s.interval_calls,
 			(unsigned long long)s.interval_emits,
+			(unsigned long long)s.interval_batched,
+			(unsigned long long)s.interval_deferred,
+			(unsigned long long)s.interval_sorted,
 			(unsigned long long)s.interval_suppresses,
 			(unsigned long long)s.interval_skips,
 			(unsigned long long)total_fails);
@@ -351,7 +530,15 @@ static void maybe_log_stats(BillboardStats& s) {
 				s.sample_wx, s.sample_wy, s.sample_wz,
 				s.sample_scale, s.sample_cam_z, s.sample_group_id);
 		}
-		std::printf(" pool=%d/%d\n", s_alloc.used_slots, BILLBOARD_POOL_SLOTS);
+		std::printf(" pool=%d/%d region=%d grow=%llu overflow=%llu",
+			s_alloc.used_slots, s_alloc.capacity_slots, s_alloc.region,
+			(unsigned long long)s_alloc.grow_count,
+			(unsigned long long)s_alloc.overflow_count);
+		if (budget::enabled()) {
+			std::printf(" budget=lod:%d,rewrite:%d,target:%dvi",
+				budget::lod_budget(), budget::rewrite_budget(), budget::target_vis());
+		}
+		std::printf("\n");
 		std::fflush(stdout);
 	}
 
@@ -359,6 +546,9 @@ static void maybe_log_stats(BillboardStats& s) {
 	s.interval_emits = 0;
 	s.interval_suppresses = 0;
 	s.interval_skips = 0;
+	s.interval_batched = 0;
+	s.interval_deferred = 0;
+	s.interval_sorted = 0;
 	std::memset(s.interval_fail_counts, 0, sizeof(s.interval_fail_counts));
 	s.has_sample = false;
 }
@@ -368,6 +558,9 @@ static void record_stat(BillboardStats& s, RewriteOutcome outcome, bool suppress
 	if (outcome == RewriteOutcome::Emitted) {
 		s.interval_emits++;
 		if (suppressed) s.interval_suppresses++;
+		if (trace && trace->batched) s.interval_batched++;
+		if (trace && trace->deferred) s.interval_deferred++;
+		if (trace && trace->sorted) s.interval_sorted++;
 		if (trace && !s.has_sample) {
 			s.sample_wx = trace->world_x;
 			s.sample_wy = trace->world_y;
@@ -416,391 +609,53 @@ static void write_ortho(float* matrix, float left, float right, float bottom, fl
 	matrix[14] = -(far_plane + near_plane) * inv_fn;
 }
 
-// Configuration for the generic billboard ortho-quad rewrite.
-// Each billboard function passes its own config to customize scaling, geometry, etc.
-struct BillboardConfig {
-	uint32_t hash_salt        = 0x73F17C00u;
-	float scale_clamp_min     = 0.0f;
-	float scale_clamp_max     = 16383.0f;
-	bool dual_scale           = false;   // if true, read independent Y scale from stack +0x1C
-	int16_t geom_half_h       = 0;       // 0 = use raw half_h; nonzero = use this for geometry (TC still uses raw)
-	float y_top_mul           = 1.0f;    // multiplier for yl offset (3.0 for 73F800 plants)
-	float y_bottom_fixed      = 0.0f;    // > 0: use center_y + this for yh instead of center_y + y_offset (for stars)
-	bool screen_wrap          = false;   // wrap center_x to [0, screen_w*4] (740820 tree tops)
-	int16_t offset_clamp      = 0;       // > 0: clamp x/y offsets to this * 2 (740820)
-	bool hash_includes_scale  = true;    // if false, exclude scale from group_id (for animated-scale items like Power Orbs)
-	int hash_coord_shift      = 0;       // right-shift world coords before hashing/signature (quantizes pulsating positions)
+// ── Billboard command emission ──────────────────────────────────────────
+//
+// Every rewritten billboard is drawn inside a "run": a header that switches RT64 into
+// the ortho/identity state, one or more quads, and a closing block that restores the
+// game's state. In batched mode consecutive billboards share one run; otherwise each
+// quad gets its own run (the original behavior).
+//
+// Run header:
+//   1: gEXEnable
+//   1: gEXSetRDRAMExtended(1)
+//   1: gEXPushOtherMode
+//   1: setothermode_h
+//   1: gEXPushProjectionMatrix
+//   2: gEXMatrixFloat (proj)
+//   2: gEXMatrixFloat (modelview push+load)
+//   1: gEXSetProjMatrixFloat
+//   1: gEXSetViewMatrixFloat
+// Quad:
+//   1: setprimdepth
+//   2: gEXMatrixGroup
+//   2: gEXVertex
+//   2: TRI2 (both windings)
+//   1: gEXPopMatrixGroup
+// Run tail:
+//   1: popmtx
+//   1: gEXPopProjectionMatrix
+//   1: gEXSetProjMatrixFloat (restore identity)
+//   1: gEXSetViewMatrixFloat (restore identity)
+//   1: gEXSetRDRAMExtended(0)
+//   1: gEXPopOtherMode
+// Each GfxCommand is 8 bytes.
+constexpr uint32_t kRunHeaderCmds = 11;
+constexpr uint32_t kQuadCmds      = 8;
+constexpr uint32_t kRunTailCmds   = 6;
+constexpr uint32_t kRunTailBytes  = kRunTailCmds * sizeof(GfxCommand);
+
+// Open run state for batched emission. Reset on every new frame.
+struct BillboardRun {
+	gpr ptr_addr = 0;                 // Gfx** the run was written through (ctx->r4)
+	gpr end_vram = 0;                 // write pointer right after the run tail
+	GfxCommand tail[kRunTailCmds] = {}; // copy of the emitted tail, to detect foreign writes
+	bool active = false;
 };
 
-static RewriteOutcome rewrite_billboard_ortho_quad(uint8_t* rdram, recomp_context* ctx, const BillboardConfig& cfg, RewriteTrace* out_trace) {
-	// One-time tuning to avoid unordered_map rehashing in hot paths.
-	static bool s_prev_quads_inited = false;
-	if (!s_prev_quads_inited) {
-		g_prev_quads.reserve(4096);
-		s_prev_quads_inited = true;
-	}
-
-	const int32_t world_x = static_cast<int32_t>(ctx->r5);
-	const int32_t world_y = static_cast<int32_t>(ctx->r6);
-	const int32_t world_z = static_cast<int32_t>(ctx->r7);
-
-	const int16_t half_w = static_cast<int16_t>(MEM_W(0x10, ctx->r29));
-	const int16_t half_h = static_cast<int16_t>(MEM_W(0x14, ctx->r29));
-	const int32_t scale  = static_cast<int32_t>(MEM_W(0x18, ctx->r29));
-	const int32_t scale_y_raw = cfg.dual_scale ? static_cast<int32_t>(MEM_W(0x1C, ctx->r29)) : scale;
-
-	RewriteTrace trace;
-	trace.world_x = world_x;
-	trace.world_y = world_y;
-	trace.world_z = world_z;
-	trace.half_w  = half_w;
-	trace.half_h  = half_h;
-	trace.scale   = scale;
-
-	if ((half_w <= 0) || (half_h <= 0) || (scale <= 0) || (cfg.dual_scale && (scale_y_raw <= 0))) {
-		if (out_trace) *out_trace = trace;
-		return RewriteOutcome::InvalidArgs;
-	}
-
-	const int16_t screen_w = static_cast<int16_t>(MEM_H(0, ADDR_SCREEN_WIDTH));
-	const int16_t screen_h = static_cast<int16_t>(MEM_H(0, ADDR_SCREEN_HEIGHT));
-	trace.screen_w = screen_w;
-	trace.screen_h = screen_h;
-
-	if ((screen_w <= 0) || (screen_h <= 0)) {
-		if (out_trace) *out_trace = trace;
-		return RewriteOutcome::InvalidScreen;
-	}
-
-	const gpr dl_state = MEM_W(0, ADDR_D_80204278_PTR);
-	if (dl_state == 0) {
-		if (out_trace) *out_trace = trace;
-		return RewriteOutcome::MissingDlState;
-	}
-
-	// Reset our extended RDRAM allocator on new frame (dl_state change).
-	if (s_alloc.dl_state != dl_state) {
-		s_alloc.dl_state = dl_state;
-		s_alloc.used_slots = 0;
-		s_alloc.matrices_cached = false;
-		s_alloc.vp_cached = false;
-		g_billboard_frame_count++;
-	}
-
-	// Check if we can reuse cached matrices from an earlier billboard this frame.
-	const bool cache_hit = s_alloc.matrices_cached
-		&& (s_alloc.screen_w == screen_w)
-		&& (s_alloc.screen_h == screen_h);
-
-	// Early capacity check: bail out before expensive math if our pool is full.
-	{
-		constexpr int kMtxBytes = static_cast<int>(sizeof(float) * 16);
-		constexpr int kVtxBytes = static_cast<int>(sizeof(Rt64VertexExV1) * 4);
-		const int kNeededBytes = cache_hit ? kVtxBytes : (2 * kMtxBytes) + kVtxBytes;
-		const int kNeededSlots = (kNeededBytes + (BILLBOARD_SLOT_BYTES - 1))
-		                       / BILLBOARD_SLOT_BYTES;
-		if ((s_alloc.used_slots + kNeededSlots) > BILLBOARD_POOL_SLOTS) {
-			if (out_trace) *out_trace = trace;
-			return RewriteOutcome::AllocFail;
-		}
-	}
-
-	// Read the game's view-projection matrix once per frame, then serve from cache.
-	// Saves 16 RDRAM reads per billboard call after the first one each frame.
-	if (!s_alloc.vp_cached) {
-		const gpr m_base = ADD32(dl_state, DISPLAYLIST_OFF_VIEWPROJ_F32);
-		for (int i = 0; i < 16; i++) {
-			s_alloc.vp_mtx[i] = read_f32(rdram, ADD32(m_base, i * 4));
-		}
-		s_alloc.vp_cached = true;
-	}
-	const float* vp = s_alloc.vp_mtx;
-	auto m = [vp](int r, int c) -> float {
-		return vp[r * 4 + c];
-	};
-
-	// World coords are 16.16 fixed-point.
-	const float x = static_cast<float>(world_x) / 65536.0f;
-	const float y = static_cast<float>(world_y) / 65536.0f;
-	const float z = static_cast<float>(world_z) / 65536.0f;
-
-	const float cam_z = m(2, 3) + (m(2, 2) * z) + (m(2, 1) * y) + (m(2, 0) * x);
-	trace.cam_z = cam_z;
-
-	// Conservative reject: keep behind-camera threshold as a named constant.
-	if (!(cam_z <= kBehindCameraZ)) {
-		if (out_trace) *out_trace = trace;
-		return RewriteOutcome::BehindCamera;
-	}
-
-	// Depth proxy used to derive prim-depth (keeps ordering close to original texrect path).
-	const float clip_w = ((m(3, 2) * cam_z) + m(3, 3)) / -cam_z;
-	trace.clip_w = clip_w;
-	if (!(clip_w > 0.0f)) {
-		if (out_trace) *out_trace = trace;
-		return RewriteOutcome::InvalidClipW;
-	}
-
-	const float proj_x = m(0, 3) + (m(0, 2) * z) + (m(0, 1) * y) + (m(0, 0) * x);
-	const float proj_y = m(1, 3) + (m(1, 2) * z) + (m(1, 1) * y) + (m(1, 0) * x);
-
-	// Screen coordinates are in a 4x scaled space (consistent with original path).
-	const float center_x = ((m(3, 0) * proj_x) / cam_z) + (static_cast<float>(screen_w) * 2.0f);
-	const float center_y = ((m(3, 1) * proj_y) / cam_z) + (static_cast<float>(screen_h) * 2.0f);
-
-	const float fov_y = read_f32(rdram, ADD32(ADDR_LEVEL_CONFIG, LEVELCFG_OFF_FOV_Y));
-	if (!std::isfinite(fov_y) || (std::fabs(fov_y) < 0.0001f)) {
-		if (out_trace) *out_trace = trace;
-		return RewriteOutcome::InvalidFov;
-	}
-
-	// Sprite scaling: mirrors original behavior. Supports independent X/Y scales.
-	const float scaled_x = (static_cast<float>(scale) * 33.0f) / fov_y;
-	const float scaled_y = (static_cast<float>(scale_y_raw) * 33.0f) / fov_y;
-	float sprite_scale_x = std::clamp((scaled_x * 32.0f) / -cam_z, cfg.scale_clamp_min, cfg.scale_clamp_max);
-	float sprite_scale_y = std::clamp((scaled_y * 32.0f) / -cam_z, cfg.scale_clamp_min, cfg.scale_clamp_max);
-	trace.sprite_scale = sprite_scale_x;
-	if (!(sprite_scale_x > 0.0f) || !(sprite_scale_y > 0.0f)) {
-		if (out_trace) *out_trace = trace;
-		return RewriteOutcome::InvalidSpriteScale;
-	}
-
-	// Geometry may use a modified half_h (e.g. 73F800 subtracts 32 for tall plants).
-	const int16_t geom_hh = (cfg.geom_half_h != 0) ? cfg.geom_half_h : half_h;
-
-	float x_offset = (static_cast<float>(half_w) * sprite_scale_x) / 128.0f;
-	float y_offset = (static_cast<float>(geom_hh) * sprite_scale_y) / 128.0f;
-
-	// Offset clamping (740820: clamp to arg9 * 2).
-	if (cfg.offset_clamp > 0) {
-		const float clamp_val = static_cast<float>(cfg.offset_clamp) * 2.0f;
-		x_offset = std::min(x_offset, clamp_val);
-		y_offset = std::min(y_offset, clamp_val);
-	}
-
-	// Screen wrapping (740820: wrap center_x into [0, screen_w*4]).
-	float adj_center_x = center_x;
-	if (cfg.screen_wrap) {
-		const float sw4 = static_cast<float>(screen_w) * 4.0f;
-		while (adj_center_x >= sw4) adj_center_x -= sw4;
-		while (adj_center_x < 0.0f) adj_center_x += sw4;
-	}
-
-	const float xl = adj_center_x - x_offset;
-	const float yl = center_y - (y_offset * cfg.y_top_mul);
-	const float xh = adj_center_x + x_offset;
-	const float yh = (cfg.y_bottom_fixed > 0.0f) ? (center_y + cfg.y_bottom_fixed) : (center_y + y_offset);
-	trace.xl = xl;
-	trace.yl = yl;
-	trace.xh = xh;
-	trace.yh = yh;
-
-	const float screen_max_x = static_cast<float>(screen_w) * 4.0f;
-	const float screen_max_y = static_cast<float>(screen_h) * 4.0f;
-
-	if (!((xl < xh) && (yl < yh) && (xl < screen_max_x) && (yl < screen_max_y) && (xh > 0.0f) && (yh > 0.0f))) {
-		if (out_trace) *out_trace = trace;
-		return RewriteOutcome::Offscreen;
-	}
-
-	// Allocate from our extended RDRAM pool (NOT the game's limited vertex pool).
-	// Cache hit: reuse matrices from first billboard, only allocate 4 vertices (6 slots).
-	// Cache miss: allocate 2 matrices + 4 vertices (14 slots), then populate cache.
-	constexpr int kMatrixBytes = static_cast<int>(sizeof(float) * 16);
-	constexpr int kVertexBytes = static_cast<int>(sizeof(Rt64VertexExV1) * 4);
-
-	gpr proj_mtx_addr, view_mtx_addr, verts_addr;
-
-	if (cache_hit) {
-		proj_mtx_addr = s_alloc.proj_mtx_addr;
-		view_mtx_addr = s_alloc.view_mtx_addr;
-		gpr alloc_addr = 0;
-		if (!allocate_billboard_data(rdram, kVertexBytes, alloc_addr)) {
-			if (out_trace) *out_trace = trace;
-			return RewriteOutcome::AllocFail;
-		}
-		verts_addr = alloc_addr;
-	} else {
-		constexpr int kAllocBytes = (kMatrixBytes * 2) + kVertexBytes;
-		gpr alloc_addr = 0;
-		if (!allocate_billboard_data(rdram, kAllocBytes, alloc_addr)) {
-			if (out_trace) *out_trace = trace;
-			return RewriteOutcome::AllocFail;
-		}
-		proj_mtx_addr = alloc_addr;
-		view_mtx_addr = ADD32(proj_mtx_addr, kMatrixBytes);
-		verts_addr    = ADD32(view_mtx_addr, kMatrixBytes);
-
-		float* proj_mtx = reinterpret_cast<float*>(rdram + vram_to_phys_u32(proj_mtx_addr));
-		float* view_mtx = reinterpret_cast<float*>(rdram + vram_to_phys_u32(view_mtx_addr));
-
-		write_ortho(
-			proj_mtx,
-			-static_cast<float>(screen_w) * 2.0f,
-			 static_cast<float>(screen_w) * 2.0f,
-			 static_cast<float>(screen_h) * 2.0f,
-			-static_cast<float>(screen_h) * 2.0f,
-			-1.0f,
-			 1.0f
-		);
-		write_identity(view_mtx);
-
-		// Populate cache for subsequent billboards this frame.
-		s_alloc.proj_mtx_addr = proj_mtx_addr;
-		s_alloc.view_mtx_addr = view_mtx_addr;
-		s_alloc.screen_w = screen_w;
-		s_alloc.screen_h = screen_h;
-		s_alloc.matrices_cached = true;
-	}
-
-	// Convert to centered coordinates (ortho matrix origin at screen center).
-	const float centered_xl = xl - (static_cast<float>(screen_w) * 2.0f);
-	const float centered_yl = yl - (static_cast<float>(screen_h) * 2.0f);
-	const float centered_xh = xh - (static_cast<float>(screen_w) * 2.0f);
-	const float centered_yh = yh - (static_cast<float>(screen_h) * 2.0f);
-
-	const int16_t cur_x[4] = {
-		clamp_i16(centered_xl),
-		clamp_i16(centered_xh),
-		clamp_i16(centered_xl),
-		clamp_i16(centered_xh)
-	};
-	const int16_t cur_y[4] = {
-		clamp_i16(centered_yl),
-		clamp_i16(centered_yl),
-		clamp_i16(centered_yh),
-		clamp_i16(centered_yh)
-	};
-
-	// Quantize world coords for hashing/signature when items pulsate (Power Cells).
-	// Right-shifting by hash_coord_shift rounds positions to a coarser grid so small
-	// frame-to-frame Z/scale oscillations don't produce a new group_id every frame.
-	const int32_t q_x = world_x >> cfg.hash_coord_shift;
-	const int32_t q_y = world_y >> cfg.hash_coord_shift;
-	const int32_t q_z = world_z >> cfg.hash_coord_shift;
-
-	// For items with animated scale (Power Orbs fade-out), exclude scale from hash
-	// so the group_id remains stable across frames and interpolation works correctly.
-	const int32_t hash_scale = cfg.hash_includes_scale ? scale : 0;
-	const uint32_t group_id = billboard_group_id(q_x, q_y, q_z, half_w, half_h, hash_scale, cfg.hash_salt);
-	trace.group_id = group_id;
-
-	g_quad_stamp++;
-
-	int16_t prev_x[4] = { cur_x[0], cur_x[1], cur_x[2], cur_x[3] };
-	int16_t prev_y[4] = { cur_y[0], cur_y[1], cur_y[2], cur_y[3] };
-
-	// Pull previous quad position for interpolation (if recent and signature matches).
-	const auto prev_it = g_prev_quads.find(group_id);
-	if (prev_it != g_prev_quads.end()) {
-		const PrevQuad& pq = prev_it->second;
-		const bool recent = ((g_quad_stamp - pq.stamp) <= 300);
-		const bool sig_ok = (pq.sig_x == q_x) && (pq.sig_y == q_y) && (pq.sig_z == q_z);
-		if (recent && sig_ok) {
-			for (int i = 0; i < 4; i++) {
-				prev_x[i] = pq.x[i];
-				prev_y[i] = pq.y[i];
-			}
-		}
-	}
-
-	// Update cache.
-	PrevQuad& prev_entry = g_prev_quads[group_id];
-	for (int i = 0; i < 4; i++) {
-		prev_entry.x[i] = cur_x[i];
-		prev_entry.y[i] = cur_y[i];
-	}
-	prev_entry.sig_x = q_x;
-	prev_entry.sig_y = q_y;
-	prev_entry.sig_z = q_z;
-	prev_entry.stamp = g_quad_stamp;
-
-	// No periodic cleanup: the map is naturally bounded because active billboards
-	// reuse the same group_ids each frame. Stale entries from billboards that left
-	// view waste a small amount of memory (~50 bytes/entry) but the signature check
-	// prevents false matches. Removing the cleanup avoids periodic iteration +
-	// erase-during-iteration costs that caused micro-stutters every ~512 draws.
-
-	const int16_t z_screen = 0;
-
-	const int s_max_i = (std::max(0, static_cast<int>(half_w) - 1) << 6);
-	const int t_max_i = (std::max(0, static_cast<int>(half_h) - 1) << 6);
-	const int16_t s_max = static_cast<int16_t>(std::clamp(s_max_i, -32768, 32767));
-	const int16_t t_max = static_cast<int16_t>(std::clamp(t_max_i, -32768, 32767));
-
-	auto* verts = reinterpret_cast<Rt64VertexExV1*>(rdram + vram_to_phys_u32(verts_addr));
-	auto set_vert = [&](int index, int16_t x0, int16_t y0, int16_t px, int16_t py, int16_t s0, int16_t t0) {
-		verts[index].v.y = y0;
-		verts[index].v.x = x0;
-		verts[index].v.flag = 0;
-		verts[index].v.z = z_screen;
-		verts[index].v.t = t0;
-		verts[index].v.s = s0;
-		verts[index].v.a = 0xFF;
-		verts[index].v.b = 0xFF;
-		verts[index].v.g = 0xFF;
-		verts[index].v.r = 0xFF;
-		verts[index].yp = py;
-		verts[index].xp = px;
-		verts[index].pad = 0;
-		verts[index].zp = z_screen;
-	};
-
-	set_vert(0, cur_x[0], cur_y[0], prev_x[0], prev_y[0], 0,     0);
-	set_vert(1, cur_x[1], cur_y[1], prev_x[1], prev_y[1], s_max, 0);
-	set_vert(2, cur_x[2], cur_y[2], prev_x[2], prev_y[2], 0,     t_max);
-	set_vert(3, cur_x[3], cur_y[3], prev_x[3], prev_y[3], s_max, t_max);
-
-	const int16_t prim_depth_bias = static_cast<int16_t>(MEM_H(LEVELCFG_OFF_PRIMDEPTH_BIAS, ADDR_LEVEL_CONFIG));
-	const int32_t depth_raw = static_cast<int32_t>(std::lround((clip_w * 1023.0f * 32.0f) + 32736.0f)) - prim_depth_bias;
-	const uint16_t prim_depth = static_cast<uint16_t>(depth_raw & 0xFFFF);
-
-	// Grab current write pointer.
-	GfxWriteContext wctx;
-	if (!try_get_gfx_ptr(rdram, ctx->r4, wctx)) {
-		if (out_trace) *out_trace = trace;
-		return RewriteOutcome::GfxPtrFail;
-	}
-
-	// Capacity check: ensure we won't overrun RDRAM when writing commands.
-	// This is a conservative safety check (we don't know the real DL buffer size,
-	// but we *do* know the max addressable RDRAM).
-	//
-	// Count commands we emit below:
-	//   1: setprimdepth
-	//   2: gEXEnable
-	//   2: gEXSetRDRAMExtended
-	//   2: gEXPushOtherMode
-	//   1: setothermode_h
-	//   2: gEXPushProjectionMatrix
-	//   2: gEXMatrixFloat (proj)
-	//   2: gEXMatrixFloat (modelview push+load)
-	//   2: gEXSetProjMatrixFloat
-	//   2: gEXSetViewMatrixFloat
-	//   2: gEXMatrixGroup
-	//   2: gEXVertex
-	//   2: TRI2 (two triangles)
-	//   1: popmtx
-	//   2: gEXPopMatrixGroup
-	//   2: gEXPopProjectionMatrix
-	//   1: gEXSetProjMatrixFloat (restore identity)
-	//   1: gEXSetViewMatrixFloat (restore identity)
-	//   1: gEXSetRDRAMExtended(0)
-	//   1: gEXPopOtherMode
-	// Total = 34 GfxCommand words (each GfxCommand is 8 bytes).
-	constexpr uint32_t kEmittedCmds = 34;
-	constexpr uint32_t kEmittedBytes = kEmittedCmds * sizeof(GfxCommand);
-	if (wctx.capacity_bytes < kEmittedBytes) {
-		if (out_trace) *out_trace = trace;
-		return RewriteOutcome::GfxCapacityFail;
-	}
-
-	GfxCommand* cmd = wctx.cmd;
-
-	cmd->values.word0 = CMD_SETPRIMDEPTH;
-	cmd->values.word1 = static_cast<uint32_t>(prim_depth) << 16;
-	cmd++;
+static BillboardRun s_run;
 
+static GfxCommand* emit_run_header(GfxCommand* cmd, gpr proj_mtx_addr, gpr view_mtx_addr) {
 	// Ensure RT64's extended command parser is active for this path.
 	gEXEnable(cmd);
 	cmd++;
@@ -835,6 +690,14 @@ static RewriteOutcome rewrite_billboard_ortho_quad(uint8_t* rdram, recomp_contex
 	gEXSetViewMatrixFloat(cmd, static_cast<uint32_t>(view_mtx_addr));
 	cmd++;
 
+	return cmd;
+}
+
+static GfxCommand* emit_quad(GfxCommand* cmd, uint16_t prim_depth, uint32_t group_id, gpr verts_addr) {
+	cmd->values.word0 = CMD_SETPRIMDEPTH;
+	cmd->values.word1 = static_cast<uint32_t>(prim_depth) << 16;
+	cmd++;
+
 	gEXMatrixGroup(
 		cmd,
 		group_id,
@@ -869,13 +732,18 @@ static RewriteOutcome rewrite_billboard_ortho_quad(uint8_t* rdram, recomp_contex
 	cmd->values.word1 =         (0u << 17) | (2u << 9) | (3u << 1);
 	cmd++;
 
+	gEXPopMatrixGroup(cmd, 0);
+	cmd++;
+
+	return cmd;
+}
+
+static GfxCommand* emit_run_tail(GfxCommand* cmd, gpr view_mtx_addr) {
 	// Pop standard RSP modelview stack.
 	cmd->values.word0 = CMD_POPMTX;
 	cmd->values.word1 = 0x00000000; // G_MTX_MODELVIEW
 	cmd++;
 
-	gEXPopMatrixGroup(cmd, 0);
-	cmd++;
 	gEXPopProjectionMatrix(cmd);
 	cmd++;
 
@@ -900,29 +768,1699 @@ static RewriteOutcome rewrite_billboard_ortho_quad(uint8_t* rdram, recomp_contex
 	gEXPopOtherMode(cmd);
 	cmd++;
 
-	advance_gfx_ptr(rdram, wctx, cmd, ctx->r4);
-
-	if (out_trace) *out_trace = trace;
-	return RewriteOutcome::Emitted;
+	return cmd;
 }
 
-} // namespace
+// Compile-time configuration for the generic billboard ortho-quad rewrite.
+// Each billboard hook instantiates the rewrite with its own traits, so the branches on
+// these fields fold away. Hooks derive from BillboardTraits and override what differs.
+struct BillboardTraits {
+	static constexpr uint32_t hash_salt       = 0x73F17C00u;
+	static constexpr float scale_clamp_min    = 0.0f;
+	static constexpr float scale_clamp_max    = 16383.0f;
+	static constexpr bool dual_scale          = false;   // if true, read independent Y scale from stack +0x1C
+	static constexpr bool tall_plant_args     = false;   // geometry half_h / yl multiplier come from BillboardDynamic (73F800)
+	static constexpr float y_bottom_fixed     = 0.0f;    // > 0: use center_y + this for yh instead of center_y + y_offset (for stars)
+	static constexpr bool wrap_clamp_args     = false;   // screen wrap / offset clamp come from BillboardDynamic (740820)
+	static constexpr bool hash_includes_scale = true;    // if false, exclude scale from group_id (for animated-scale items like Power Orbs)
+	static constexpr int hash_coord_shift     = 0;       // right-shift world coords before hashing/signature (quantizes pulsating positions)
+	static constexpr uint32_t owner_tag       = 1;       // 1-7, keeps owner identity keys of different hooks apart
+};
 
-namespace sssv::billboard {
+// 73F17C (energy items) uses the defaults.
+struct Traits73F17C : BillboardTraits {};
 
-void set_disable_6fa3a4_render(bool enabled) {
-	g_disable_6fa3a4_render = enabled;
-}
+// 6C5E44 (stars).
+struct Traits6C5E44 : BillboardTraits {
+	static constexpr uint32_t hash_salt    = 0x6C5E4400u;
+	static constexpr uint32_t owner_tag    = 2;
+	static constexpr float scale_clamp_min = 4.0f;
+	static constexpr float scale_clamp_max = 15.0f;
+	static constexpr float y_bottom_fixed  = 2.0f;
+};
+
+// 73F800 (flowers / Power Cells).
+struct Traits73F800 : BillboardTraits {
+	static constexpr uint32_t hash_salt       = 0x73F80000u;
+	static constexpr uint32_t owner_tag       = 3;
+	static constexpr bool tall_plant_args     = true;
+	static constexpr bool hash_includes_scale = false; // Power Cells pulsate scale every frame
+	static constexpr int hash_coord_shift     = 18;    // Quantize coords: 2^18 covers ~4 world-unit Z pulsation
+};
+
+// 740094 (collectibles, 2D scaling).
+struct Traits740094 : BillboardTraits {
+	static constexpr uint32_t hash_salt       = 0x74009400u;
+	static constexpr uint32_t owner_tag       = 4;
+	static constexpr bool dual_scale          = true;
+	static constexpr bool hash_includes_scale = false;
+};
+
+// 740820 (tree tops).
+struct Traits740820 : BillboardTraits {
+	static constexpr uint32_t hash_salt   = 0x74082000u;
+	static constexpr uint32_t owner_tag   = 5;
+	static constexpr bool dual_scale      = true;
+	static constexpr bool wrap_clamp_args = true;
+};
+
+// The few per-call values that really are dynamic. Only read when the traits enable them.
+struct BillboardDynamic {
+	int16_t geom_half_h  = 0;      // 73F800: nonzero = use this for geometry (TC still uses raw half_h)
+	float y_top_mul      = 1.0f;   // 73F800: multiplier for yl offset (3.0 for tall plants)
+	bool screen_wrap     = false;  // 740820: wrap center_x to [0, screen_w*4]
+	int16_t offset_clamp = 0;      // 740820: > 0 clamps x/y offsets to this * 2
+};
+
+// Everything the rewrite reads from a hook call before the sprite is projected.
+struct BillboardInput {
+	BillboardDynamic dyn;
+	int32_t world_x = 0;
+	int32_t world_y = 0;
+	int32_t world_z = 0;
+	int16_t half_w = 0;
+	int16_t half_h = 0;
+	int32_t scale = 0;
+	int32_t scale_y = 0;
+	int16_t screen_w = 0;
+	int16_t screen_h = 0;
+	float fov_y = 0.0f;
+	int16_t prim_depth_bias = 0;
+	// Quantized world coords used for the group_id and the interpolation signature.
+	int32_t q_x = 0;
+	int32_t q_y = 0;
+	int32_t q_z = 0;
+	uint32_t group_id = 0;
+	bool owner_identity = false; // group_id is an owner identity key (see owner_identity_key)
+};
+
+// Screen-space quad (centered ortho coordinates) derived from a projected BillboardInput.
+struct BillboardQuad {
+	int16_t x[4] = {};
+	int16_t y[4] = {};
+	uint16_t prim_depth = 0;
+};
+
+// ── Projection kernel ───────────────────────────────────────────────────
+// See sssv_billboard_projection.h.
+
+using sssv::billboard::BillboardProjection;
+using sssv::billboard::BillboardProjectInputX4;
+using sssv::billboard::BillboardProjectionX4;
+using sssv::billboard::kProjectLanes;
+using sssv::billboard::project_billboard_depth;
+using sssv::billboard::project_billboard_scalar;
+using sssv::billboard::project_billboards_x4;
+using sssv::billboard::same_float_bits;
+
+#if SSSV_BILLBOARD_DEBUG
+// Debug builds cross-check every SIMD batch against the scalar reference.
+static void verify_projection_x4(const float* vp, const BillboardProjectInputX4& in, const BillboardProjectionX4& out, int lanes) {
+	static bool s_reported = false;
+	for (int i = 0; i < lanes; i++) {
+		const BillboardProjection ref = project_billboard_scalar(
+			vp, in.world_x[i], in.world_y[i], in.world_z[i], in.screen_off_x[i], in.screen_off_y[i]);
+		const bool match = same_float_bits(ref.cam_z, out.cam_z[i])
+			&& same_float_bits(ref.clip_w, out.clip_w[i])
+			&& same_float_bits(ref.center_x, out.center_x[i])
+			&& same_float_bits(ref.center_y, out.center_y[i]);
+		if (!match && !s_reported) {
+			std::printf("[BILLBOARD] SIMD projection mismatch: xyz=(%d,%d,%d) cam_z=%a/%a clip_w=%a/%a center=(%a,%a)/(%a,%a)\n",
+				in.world_x[i], in.world_y[i], in.world_z[i],
+				ref.cam_z, out.cam_z[i], ref.clip_w, out.clip_w[i],
+				ref.center_x, ref.center_y, out.center_x[i], out.center_y[i]);
+			std::fflush(stdout);
+			s_reported = true;
+		}
+	}
+}
+#endif
+
+// ── Rewrite stages ──────────────────────────────────────────────────────
+
+struct BillboardScale {
+	float x = 0.0f;
+	float y = 0.0f;
+};
+
+// The rejects that only need cam_z and clip_w: behind the camera, the depth proxy, the FOV
+// and the sprite scale. Returns Emitted if the billboard passes them.
+template <typename Traits>
+static RewriteOutcome check_billboard_depth(const BillboardInput& in, const BillboardProjection& proj, BillboardScale& scale, RewriteTrace& trace) {
+	const float cam_z = proj.cam_z;
+	const float clip_w = proj.clip_w;
+	trace.cam_z = cam_z;
+
+	// Conservative reject: keep behind-camera threshold as a named constant.
+	if (!(cam_z <= kBehindCameraZ)) {
+		return RewriteOutcome::BehindCamera;
+	}
+
+	trace.clip_w = clip_w;
+	if (!(clip_w > 0.0f)) {
+		return RewriteOutcome::InvalidClipW;
+	}
+
+	const float fov_y = in.fov_y;
+	if (!std::isfinite(fov_y) || (std::fabs(fov_y) < 0.0001f)) {
+		return RewriteOutcome::InvalidFov;
+	}
+
+	// Sprite scaling: mirrors original behavior. Supports independent X/Y scales.
+	const float scaled_x = (static_cast<float>(in.scale) * 33.0f) / fov_y;
+	const float scaled_y = (static_cast<float>(in.scale_y) * 33.0f) / fov_y;
+	scale.x = std::clamp((scaled_x * 32.0f) / -cam_z, Traits::scale_clamp_min, Traits::scale_clamp_max);
+	scale.y = std::clamp((scaled_y * 32.0f) / -cam_z, Traits::scale_clamp_min, Traits::scale_clamp_max);
+	trace.sprite_scale = scale.x;
+	if (!(scale.x > 0.0f) || !(scale.y > 0.0f)) {
+		return RewriteOutcome::InvalidSpriteScale;
+	}
+	return RewriteOutcome::Emitted;
+}
+
+// Turns a projected billboard into its screen-space quad, applying the per-function config.
+// Returns Emitted when the quad should be drawn, otherwise the reason it was rejected.
+template <typename Traits>
+static RewriteOutcome finish_billboard(const BillboardInput& in, const BillboardProjection& proj, BillboardQuad& out, RewriteTrace& trace) {
+	const BillboardDynamic& dyn = in.dyn;
+	BillboardScale scale;
+	const RewriteOutcome depth_outcome = check_billboard_depth<Traits>(in, proj, scale, trace);
+	if (depth_outcome != RewriteOutcome::Emitted) {
+		return depth_outcome;
+	}
+	const float sprite_scale_x = scale.x;
+	const float sprite_scale_y = scale.y;
+
+	// Geometry may use a modified half_h (e.g. 73F800 subtracts 32 for tall plants).
+	int16_t geom_hh = in.half_h;
+	if constexpr (Traits::tall_plant_args) {
+		if (dyn.geom_half_h != 0) geom_hh = dyn.geom_half_h;
+	}
+
+	float x_offset = (static_cast<float>(in.half_w) * sprite_scale_x) / 128.0f;
+	float y_offset = (static_cast<float>(geom_hh) * sprite_scale_y) / 128.0f;
+
+	// Offset clamping (740820: clamp to arg9 * 2).
+	if constexpr (Traits::wrap_clamp_args) {
+		if (dyn.offset_clamp > 0) {
+			const float clamp_val = static_cast<float>(dyn.offset_clamp) * 2.0f;
+			x_offset = std::min(x_offset, clamp_val);
+			y_offset = std::min(y_offset, clamp_val);
+		}
+	}
+
+	// Screen wrapping (740820: wrap center_x into [0, screen_w*4]).
+	const float center_y = proj.center_y;
+	float adj_center_x = proj.center_x;
+	if constexpr (Traits::wrap_clamp_args) {
+		if (dyn.screen_wrap) {
+			const float sw4 = static_cast<float>(in.screen_w) * 4.0f;
+			while (adj_center_x >= sw4) adj_center_x -= sw4;
+			while (adj_center_x < 0.0f) adj_center_x += sw4;
+		}
+	}
+
+	const float xl = adj_center_x - x_offset;
+	float y_top = y_offset;
+	if constexpr (Traits::tall_plant_args) {
+		y_top = y_offset * dyn.y_top_mul;
+	}
+	const float yl = center_y - y_top;
+	const float xh = adj_center_x + x_offset;
+	float yh = center_y + y_offset;
+	if constexpr (Traits::y_bottom_fixed > 0.0f) {
+		yh = center_y + Traits::y_bottom_fixed;
+	}
+	trace.xl = xl;
+	trace.yl = yl;
+	trace.xh = xh;
+	trace.yh = yh;
+
+	const float screen_max_x = static_cast<float>(in.screen_w) * 4.0f;
+	const float screen_max_y = static_cast<float>(in.screen_h) * 4.0f;
+
+	if (!((xl < xh) && (yl < yh) && (xl < screen_max_x) && (yl < screen_max_y) && (xh > 0.0f) && (yh > 0.0f))) {
+		return RewriteOutcome::Offscreen;
+	}
+
+	// Convert to centered coordinates (ortho matrix origin at screen center).
+	const float centered_xl = xl - (static_cast<float>(in.screen_w) * 2.0f);
+	const float centered_yl = yl - (static_cast<float>(in.screen_h) * 2.0f);
+	const float centered_xh = xh - (static_cast<float>(in.screen_w) * 2.0f);
+	const float centered_yh = yh - (static_cast<float>(in.screen_h) * 2.0f);
+
+	out.x[0] = clamp_i16(centered_xl);
+	out.x[1] = clamp_i16(centered_xh);
+	out.x[2] = clamp_i16(centered_xl);
+	out.x[3] = clamp_i16(centered_xh);
+	out.y[0] = clamp_i16(centered_yl);
+	out.y[1] = clamp_i16(centered_yl);
+	out.y[2] = clamp_i16(centered_yh);
+	out.y[3] = clamp_i16(centered_yh);
+
+	const int32_t depth_raw = static_cast<int32_t>(std::lround((proj.clip_w * 1023.0f * 32.0f) + 32736.0f)) - in.prim_depth_bias;
+	out.prim_depth = static_cast<uint16_t>(depth_raw & 0xFFFF);
+
+	return RewriteOutcome::Emitted;
+}
+
+// Allocates this billboard's vertices from the extended RDRAM pool (NOT the game's limited
+// vertex pool), plus the frame's shared ortho/identity matrices on a cache miss.
+// Cache hit: reuse matrices from first billboard, only allocate 4 vertices (6 slots).
+// Cache miss: allocate 2 matrices + 4 vertices (14 slots), then populate cache.
+static bool reserve_billboard_storage(uint8_t* rdram, bool cache_hit, int16_t screen_w, int16_t screen_h, gpr& proj_mtx_addr, gpr& view_mtx_addr, gpr& verts_addr) {
+	constexpr int kMatrixBytes = static_cast<int>(sizeof(float) * 16);
+	constexpr int kVertexBytes = static_cast<int>(sizeof(Rt64VertexExV1) * 4);
+
+	if (cache_hit) {
+		proj_mtx_addr = s_alloc.proj_mtx_addr;
+		view_mtx_addr = s_alloc.view_mtx_addr;
+		return allocate_billboard_data(rdram, kVertexBytes, verts_addr);
+	}
+
+	constexpr int kAllocBytes = (kMatrixBytes * 2) + kVertexBytes;
+	gpr alloc_addr = 0;
+	if (!allocate_billboard_data(rdram, kAllocBytes, alloc_addr)) {
+		return false;
+	}
+	proj_mtx_addr = alloc_addr;
+	view_mtx_addr = ADD32(proj_mtx_addr, kMatrixBytes);
+	verts_addr    = ADD32(view_mtx_addr, kMatrixBytes);
+
+	float* proj_mtx = reinterpret_cast<float*>(rdram + vram_to_phys_u32(proj_mtx_addr));
+	float* view_mtx = reinterpret_cast<float*>(rdram + vram_to_phys_u32(view_mtx_addr));
+
+	write_ortho(
+		proj_mtx,
+		-static_cast<float>(screen_w) * 2.0f,
+		 static_cast<float>(screen_w) * 2.0f,
+		 static_cast<float>(screen_h) * 2.0f,
+		-static_cast<float>(screen_h) * 2.0f,
+		-1.0f,
+		 1.0f
+	);
+	write_identity(view_mtx);
+
+	// Populate cache for subsequent billboards this frame.
+	s_alloc.proj_mtx_addr = proj_mtx_addr;
+	s_alloc.view_mtx_addr = view_mtx_addr;
+	s_alloc.screen_w = screen_w;
+	s_alloc.screen_h = screen_h;
+	s_alloc.matrices_cached = true;
+	return true;
+}
+
+// Writes the quad's vertices, pairing each with its previous position for interpolation.
+static void write_billboard_vertices(uint8_t* rdram, gpr verts_addr, const BillboardInput& in, const BillboardQuad& quad) {
+	const int16_t* cur_x = quad.x;
+	const int16_t* cur_y = quad.y;
+
+	g_quad_stamp++;
+	const uint32_t stamp_now = static_cast<uint32_t>(g_quad_stamp);
+
+	int16_t prev_x[4] = { cur_x[0], cur_x[1], cur_x[2], cur_x[3] };
+	int16_t prev_y[4] = { cur_y[0], cur_y[1], cur_y[2], cur_y[3] };
+
+	// Pull previous quad position for interpolation (if recent and signature matches),
+	// then update the same slot in place.
+	// Owner identity keys are exact and need no signature, but an object slot can be reused
+	// by a new sprite, so those do not interpolate across a jump of more than a quarter screen.
+	bool prev_found = false;
+	PrevQuadCache& cache = in.owner_identity ? g_owner_quads : g_prev_quads;
+	PrevQuad& pq = cache.find_or_insert(in.group_id, stamp_now, prev_found);
+	if (prev_found) {
+		const bool recent = ((stamp_now - pq.stamp) <= kPrevQuadRecentStamps);
+		const bool sig_ok = in.owner_identity
+			? ((std::abs(pq.x[0] - cur_x[0]) <= in.screen_w) && (std::abs(pq.y[0] - cur_y[0]) <= in.screen_h))
+			: ((pq.sig_x == in.q_x) && (pq.sig_y == in.q_y) && (pq.sig_z == in.q_z));
+		if (recent && sig_ok) {
+			for (int i = 0; i < 4; i++) {
+				prev_x[i] = pq.x[i];
+				prev_y[i] = pq.y[i];
+			}
+		}
+	}
+
+	pq.key = in.group_id;
+	pq.stamp = stamp_now;
+	for (int i = 0; i < 4; i++) {
+		pq.x[i] = cur_x[i];
+		pq.y[i] = cur_y[i];
+	}
+	pq.sig_x = in.q_x;
+	pq.sig_y = in.q_y;
+	pq.sig_z = in.q_z;
+
+	const int16_t z_screen = 0;
+
+	const int s_max_i = (std::max(0, static_cast<int>(in.half_w) - 1) << 6);
+	const int t_max_i = (std::max(0, static_cast<int>(in.half_h) - 1) << 6);
+	const int16_t s_max = static_cast<int16_t>(std::clamp(s_max_i, -32768, 32767));
+	const int16_t t_max = static_cast<int16_t>(std::clamp(t_max_i, -32768, 32767));
+
+	auto* verts = reinterpret_cast<Rt64VertexExV1*>(rdram + vram_to_phys_u32(verts_addr));
+	auto set_vert = [&](int index, int16_t x0, int16_t y0, int16_t px, int16_t py, int16_t s0, int16_t t0) {
+		verts[index].v.y = y0;
+		verts[index].v.x = x0;
+		verts[index].v.flag = 0;
+		verts[index].v.z = z_screen;
+		verts[index].v.t = t0;
+		verts[index].v.s = s0;
+		verts[index].v.a = 0xFF;
+		verts[index].v.b = 0xFF;
+		verts[index].v.g = 0xFF;
+		verts[index].v.r = 0xFF;
+		verts[index].yp = py;
+		verts[index].xp = px;
+		verts[index].pad = 0;
+		verts[index].zp = z_screen;
+	};
+
+	set_vert(0, cur_x[0], cur_y[0], prev_x[0], prev_y[0], 0,     0);
+	set_vert(1, cur_x[1], cur_y[1], prev_x[1], prev_y[1], s_max, 0);
+	set_vert(2, cur_x[2], cur_y[2], prev_x[2], prev_y[2], 0,     t_max);
+	set_vert(3, cur_x[3], cur_y[3], prev_x[3], prev_y[3], s_max, t_max);
+}
+
+// Writes one quad into the display list behind ctx->r4. out_quad_phys receives the
+// physical address of the quad's commands so a deferred billboard can be patched later.
+static RewriteOutcome emit_billboard(uint8_t* rdram, recomp_context* ctx, bool cache_hit, gpr proj_mtx_addr, gpr view_mtx_addr, gpr verts_addr, uint16_t prim_depth, uint32_t group_id, RewriteTrace& trace, uint32_t* out_quad_phys) {
+	// Grab current write pointer.
+	GfxWriteContext wctx;
+	if (!try_get_gfx_ptr(rdram, ctx->r4, wctx)) {
+		return RewriteOutcome::GfxPtrFail;
+	}
+
+	// Batched emission: if nothing was written to this display list since our last quad,
+	// rewind over that run's closing block and append this quad to the open run instead of
+	// emitting a fresh state sandwich. Requires the same cached ortho/identity matrices the
+	// run header loaded, and the closing block must still hold exactly what we wrote.
+	const bool continue_run = g_billboard_batch_emit
+		&& cache_hit
+		&& s_run.active
+		&& (s_run.ptr_addr == ctx->r4)
+		&& (s_run.end_vram == wctx.gdl_vram)
+		&& (wctx.gdl_phys >= kRunTailBytes)
+		&& (std::memcmp(wctx.cmd - kRunTailCmds, s_run.tail, kRunTailBytes) == 0);
+	trace.batched = continue_run;
+
+	// Capacity check: ensure we won't overrun RDRAM when writing commands.
+	// This is a conservative safety check (we don't know the real DL buffer size,
+	// but we *do* know the max addressable RDRAM). A continued run reuses the
+	// closing block's space, so it only grows the list by one quad.
+	constexpr uint32_t kNewRunBytes = (kRunHeaderCmds + kQuadCmds + kRunTailCmds) * sizeof(GfxCommand);
+	constexpr uint32_t kContinueRunBytes = kQuadCmds * sizeof(GfxCommand);
+	if (wctx.capacity_bytes < (continue_run ? kContinueRunBytes : kNewRunBytes)) {
+		return RewriteOutcome::GfxCapacityFail;
+	}
+
+	GfxCommand* cmd = continue_run ? (wctx.cmd - kRunTailCmds) : wctx.cmd;
+	if (!continue_run) {
+		cmd = emit_run_header(cmd, proj_mtx_addr, view_mtx_addr);
+	}
+	if (out_quad_phys) {
+		*out_quad_phys = static_cast<uint32_t>(reinterpret_cast<uint8_t*>(cmd) - rdram);
+	}
+	cmd = emit_quad(cmd, prim_depth, group_id, verts_addr);
+	GfxCommand* tail = cmd;
+	cmd = emit_run_tail(cmd, view_mtx_addr);
+
+	advance_gfx_ptr(rdram, wctx, cmd, ctx->r4);
+
+	s_run.active = true;
+	s_run.ptr_addr = ctx->r4;
+	s_run.end_vram = MEM_W(0, ctx->r4);
+	std::memcpy(s_run.tail, tail, kRunTailBytes);
+
+	return RewriteOutcome::Emitted;
+}
+
+// ── Deferred projection ─────────────────────────────────────────────────
+//
+// In deferred mode a hook only reserves its vertices and display list commands (the quad
+// is emitted with a placeholder prim depth) and queues its inputs. Queued billboards are
+// projected four at a time when the queue fills, when a new frame starts, and right before
+// a display list is handed to the renderer. The depth rejects run when the hook does, so
+// those billboards keep the original draw; only offscreen billboards are rejected at that
+// point, and their reserved quad commands are overwritten with no-ops.
+// The flush can run on the renderer thread, so all rewrite state is guarded by
+// s_billboard_mutex while either queue is in use (s_queues_pending).
+
+constexpr uint32_t CMD_SPNOOP = 0x00000000; // F3DEX G_SPNOOP
+
+constexpr int kDeferredQueueSize = 64;
+
+using FinishBillboardFn = RewriteOutcome (*)(const BillboardInput&, const BillboardProjection&, BillboardQuad&, RewriteTrace&);
+
+struct DeferredBillboard {
+	BillboardInput in;
+	FinishBillboardFn finish = nullptr; // finish_billboard<Traits> of the queuing hook
+	gpr verts_addr = 0;
+	uint32_t quad_phys = 0; // physical address of the reserved quad commands
+};
+
+struct DeferredQueue {
+	DeferredBillboard entries[kDeferredQueueSize];
+	int count = 0;
+};
+
+static DeferredQueue s_deferred;
+static std::mutex s_billboard_mutex;
+// Set while the deferred or texture-sort queue holds entries. Only set by the game thread
+// with the lock held, and cleared by whoever empties the queues, also with the lock held.
+static std::atomic<bool> s_queues_pending = false;
+
+static void update_queues_pending();
+
+static void flush_deferred_billboards(uint8_t* rdram) {
+	const float* vp = s_alloc.vp_mtx;
+	for (int base = 0; base < s_deferred.count; base += kProjectLanes) {
+		const int lanes = std::min(kProjectLanes, s_deferred.count - base);
+
+		// Unused lanes repeat the first sprite so the kernel never sees garbage.
+		BillboardProjectInputX4 batch;
+		for (int i = 0; i < kProjectLanes; i++) {
+			const BillboardInput& in = s_deferred.entries[base + ((i < lanes) ? i : 0)].in;
+			batch.world_x[i] = in.world_x;
+			batch.world_y[i] = in.world_y;
+			batch.world_z[i] = in.world_z;
+			batch.screen_off_x[i] = static_cast<float>(in.screen_w) * 2.0f;
+			batch.screen_off_y[i] = static_cast<float>(in.screen_h) * 2.0f;
+		}
+
+		BillboardProjectionX4 projected;
+		project_billboards_x4(vp, batch, projected);
+#if SSSV_BILLBOARD_DEBUG
+		verify_projection_x4(vp, batch, projected, lanes);
+#endif
+
+		for (int i = 0; i < lanes; i++) {
+			const DeferredBillboard& entry = s_deferred.entries[base + i];
+			BillboardProjection proj;
+			proj.cam_z = projected.cam_z[i];
+			proj.clip_w = projected.clip_w[i];
+			proj.center_x = projected.center_x[i];
+			proj.center_y = projected.center_y[i];
+
+			BillboardQuad quad;
+			RewriteTrace trace;
+			GfxCommand* quad_cmds = reinterpret_cast<GfxCommand*>(rdram + entry.quad_phys);
+			if (entry.finish(entry.in, proj, quad, trace) == RewriteOutcome::Emitted) {
+				write_billboard_vertices(rdram, entry.verts_addr, entry.in, quad);
+				// First quad command is setprimdepth (see emit_quad).
+				quad_cmds[0].values.word1 = static_cast<uint32_t>(quad.prim_depth) << 16;
+			} else {
+				// Only the offscreen test is left by now (see rewrite_billboard_ortho_quad).
+				for (uint32_t c = 0; c < kQuadCmds; c++) {
+					quad_cmds[c].values.word0 = CMD_SPNOOP;
+					quad_cmds[c].values.word1 = 0;
+				}
+			}
+		}
+	}
+	s_deferred.count = 0;
+	update_queues_pending();
+}
+
+static void queue_deferred_billboard(uint8_t* rdram, const BillboardInput& in, FinishBillboardFn finish, gpr verts_addr, uint32_t quad_phys) {
+	DeferredBillboard& entry = s_deferred.entries[s_deferred.count++];
+	entry.in = in;
+	entry.finish = finish;
+	entry.verts_addr = verts_addr;
+	entry.quad_phys = quad_phys;
+	if (s_deferred.count == kDeferredQueueSize) {
+		flush_deferred_billboards(rdram);
+	} else {
+		s_queues_pending.store(true, std::memory_order_release);
+	}
+}
+
+// ── Owner identity ──────────────────────────────────────────────────────
+//
+// Opt-in alternative to position hashing for the interpolation key. A sprite is identified
+// by the object drawing it, read from a callee-saved register of the calling function
+// (hooks run at function entry, so it still holds the caller's value), plus its draw
+// ordinal for that object within the frame. The key is exact: its cache entries need no
+// position signature and pulsating items need no quantization. Sprites whose owner
+// register does not hold a KSEG0 RDRAM pointer, or whose owner draws more than
+// kMaxOwnerOrdinal sprites a frame, keep the position hash.
+//
+// Which s-register holds the object depends on the hook's callers, so each hook picks it
+// at runtime (OwnerRegisterProbe). Until it has, and for hooks where no register
+// qualifies, all of the hook's sprites keep the position hash.
+
+constexpr uint32_t kMaxOwnerOrdinal = 255;
+
+static bool is_owner_pointer(uint32_t value) {
+	const uint32_t phys = value - 0x80000000u;
+	return (value >= 0x80000000u) && (phys != 0) && (phys < RDRAM_SIZE_BYTES) && ((phys & 3u) == 0);
+}
+
+static uint32_t read_saved_reg(const recomp_context* ctx, int index) {
+	switch (index) {
+		case 0: return static_cast<uint32_t>(ctx->r16);
+		case 1: return static_cast<uint32_t>(ctx->r17);
+		case 2: return static_cast<uint32_t>(ctx->r18);
+		case 3: return static_cast<uint32_t>(ctx->r19);
+		case 4: return static_cast<uint32_t>(ctx->r20);
+		case 5: return static_cast<uint32_t>(ctx->r21);
+		case 6: return static_cast<uint32_t>(ctx->r22);
+		default: return static_cast<uint32_t>(ctx->r23);
+	}
+}
+
+// Watches s0-s7 over a hook's first kFrames frames with owner identity on and picks the
+// register whose values behave like object pointers: always a KSEG0 RDRAM pointer, mostly
+// distinct within a frame, and drawing at (nearly) the same position in the next frame.
+class OwnerRegisterProbe {
+public:
+	static constexpr int kNone = -1;
+
+	// Returns the chosen register (0-7 for s0-s7), or kNone while probing or if none qualified.
+	int observe(const recomp_context* ctx, uint32_t frame, int32_t x, int32_t y, int32_t z, uint32_t hook_id) {
+		if (chosen_ != kUndecided) {
+			return chosen_;
+		}
+		if (frame != frame_) {
+			frame_ = frame;
+			if (++frames_ > kFrames) {
+				decide(hook_id);
+				return chosen_;
+			}
+		}
+		for (int c = 0; c < kCandidates; c++) {
+			observe_candidate(c, read_saved_reg(ctx, c), frame, x, y, z);
+		}
+		return kNone;
+	}
+
+	void reset() {
+		*this = OwnerRegisterProbe{};
+	}
+
+private:
+	static constexpr int kUndecided = -2;
+	static constexpr int kCandidates = 8;
+	static constexpr uint32_t kFrames = 120;
+	static constexpr uint32_t kMinHits = 64;
+	static constexpr int32_t kMaxFrameMove = 16 << 16; // 16 world units per frame
+	static constexpr uint32_t kTableSize = 128;        // must be a power of two
+	static constexpr uint32_t kMaxProbe = 8;
+
+	struct Seen {
+		uint32_t value = 0;
+		uint32_t frame = 0;
+		int32_t x = 0;
+		int32_t y = 0;
+		int32_t z = 0;
+	};
+
+	struct Candidate {
+		uint32_t calls = 0;
+		uint32_t invalid = 0; // not an RDRAM pointer
+		uint32_t repeats = 0; // value already seen this frame
+		uint32_t hits = 0;    // seen last frame at a nearby position
+		uint32_t misses = 0;  // seen last frame somewhere else
+		Seen seen[2][kTableSize] = {}; // by frame parity
+	};
+
+	void observe_candidate(int c, uint32_t value, uint32_t frame, int32_t x, int32_t y, int32_t z) {
+		Candidate& cand = candidates_[c];
+		cand.calls++;
+		if (!is_owner_pointer(value)) {
+			cand.invalid++;
+			return;
+		}
+		const uint32_t home = (value * 0x9E3779B1u) >> 25;
+		Seen* cur = cand.seen[frame & 1];
+		for (uint32_t i = 0; i < kMaxProbe; i++) {
+			Seen& entry = cur[(home + i) & (kTableSize - 1)];
+			if ((entry.frame == frame) && (entry.value == value)) {
+				cand.repeats++;
+				return;
+			}
+			if (entry.frame != frame) {
+				entry = { value, frame, x, y, z };
+				break;
+			}
+		}
+		const Seen* prev = cand.seen[(frame & 1) ^ 1];
+		for (uint32_t i = 0; i < kMaxProbe; i++) {
+			const Seen& entry = prev[(home + i) & (kTableSize - 1)];
+			if ((entry.frame == (frame - 1)) && (entry.value == value)) {
+				const bool near = (std::abs(static_cast<int64_t>(entry.x) - x) <= kMaxFrameMove)
+					&& (std::abs(static_cast<int64_t>(entry.y) - y) <= kMaxFrameMove)
+					&& (std::abs(static_cast<int64_t>(entry.z) - z) <= kMaxFrameMove);
+				(near ? cand.hits : cand.misses)++;
+				return;
+			}
+		}
+	}
+
+	void decide(uint32_t hook_id) {
+		chosen_ = kNone;
+		uint32_t best_hits = 0;
+		for (int c = 0; c < kCandidates; c++) {
+			const Candidate& cand = candidates_[c];
+			// Under 1% non-pointers, at most one call in two repeating a value, 90% hits.
+			const bool qualifies = ((cand.invalid * 100) <= cand.calls)
+				&& ((cand.repeats * 2) <= cand.calls)
+				&& (cand.hits >= kMinHits)
+				&& ((cand.misses * 10) <= cand.hits);
+			if (qualifies && (cand.hits > best_hits)) {
+				best_hits = cand.hits;
+				chosen_ = c;
+			}
+		}
+		if (chosen_ == kNone) {
+			std::printf("[BILLBOARD] %06x: no register holds the drawing object, keeping position keys\n", hook_id);
+		} else {
+			std::printf("[BILLBOARD] %06x: owner identity from s%d\n", hook_id, chosen_);
+		}
+		std::fflush(stdout);
+	}
+
+	int chosen_ = kUndecided;
+	uint32_t frame_ = UINT32_MAX;
+	uint32_t frames_ = 0;
+	Candidate candidates_[kCandidates];
+};
+
+// Indexed by owner_tag. Game thread only; reset when owner identity is switched on.
+static OwnerRegisterProbe s_owner_probes[8];
+static std::atomic<bool> s_owner_probes_reset = false;
+
+// Per-frame draw counts by owner. Entries from earlier frames count as free, so the table
+// never needs clearing.
+class OwnerOrdinals {
+public:
+	static constexpr uint32_t kCapacity = 1024; // must be a power of two
+	static constexpr uint32_t kMaxProbe = 16;
+
+	// Returns the ordinal of this draw for owner in frame, or -1 if it cannot be counted.
+	int next(uint32_t owner, uint32_t frame) {
+		const uint32_t home = (owner * 0x9E3779B1u) >> (32 - kCapacityBits);
+		for (uint32_t i = 0; i < kMaxProbe; i++) {
+			Entry& entry = entries_[(home + i) & (kCapacity - 1)];
+			if (entry.frame != frame) {
+				// Owners are only ever placed in the first free slot of their probe path,
+				// so reaching one means owner has not drawn yet this frame.
+				entry.owner = owner;
+				entry.frame = frame;
+				entry.count = 1;
+				return 0;
+			}
+			if (entry.owner == owner) {
+				return (entry.count <= kMaxOwnerOrdinal) ? static_cast<int>(entry.count++) : -1;
+			}
+		}
+		return -1;
+	}
+
+private:
+	static constexpr uint32_t kCapacityBits = 10;
+	static_assert((1u << kCapacityBits) == kCapacity, "kCapacityBits must match kCapacity");
+
+	struct Entry {
+		uint32_t owner = 0;
+		uint32_t frame = 0;
+		uint32_t count = 0;
+	};
+	Entry entries_[kCapacity] = {};
+};
+
+static OwnerOrdinals s_owner_ordinals;
+
+// Packs the owner's word address (21 bits), the draw ordinal (8 bits) and the hook's
+// owner_tag (3 bits, never 0) into a nonzero key. Returns 0 if the sprite has no usable owner.
+template <typename Traits>
+static uint32_t owner_identity_key(const recomp_context* ctx, int32_t world_x, int32_t world_y, int32_t world_z) {
+	static_assert((Traits::owner_tag >= 1) && (Traits::owner_tag <= 7), "owner_tag must fit in 3 bits");
+	if (s_owner_probes_reset.exchange(false, std::memory_order_acquire)) {
+		for (OwnerRegisterProbe& probe : s_owner_probes) {
+			probe.reset();
+		}
+	}
+	const uint32_t frame = static_cast<uint32_t>(g_billboard_frame_count);
+	const int reg = s_owner_probes[Traits::owner_tag].observe(ctx, frame, world_x, world_y, world_z, Traits::hash_salt >> 8);
+	if (reg == OwnerRegisterProbe::kNone) {
+		return 0;
+	}
+	const uint32_t owner = read_saved_reg(ctx, reg);
+	if (!is_owner_pointer(owner)) {
+		return 0;
+	}
+
+	const uint32_t owner_word = (owner - 0x80000000u) >> 2;
+	const int ordinal = s_owner_ordinals.next((owner_word << 3) | Traits::owner_tag, frame);
+	if (ordinal < 0) {
+		return 0;
+	}
+	return (owner_word << 11) | (static_cast<uint32_t>(ordinal) << 3) | Traits::owner_tag;
+}
+
+// ── Texture-sorted flush ────────────────────────────────────────────────
+//
+// In texture-sort mode a hook writes the finished quad's vertices as usual but queues the
+// quad instead of emitting it. When the display list is submitted, it is walked from its
+// start: the walk follows gSPDisplayList calls and segment changes and tracks the RDP
+// texture and blend state the game has set up, and each queued quad takes the state in
+// effect at the point its draw would have been written. The quads are then grouped by that
+// state and written as one list in the billboard pool (one ortho run per matrix set, each
+// state group replayed once ahead of its quads), which ends by replaying the state at the
+// last quad's position and returning.
+//
+// The list is called from right after the last queued quad, not from the end of the display
+// list: anything drawn later (the HUD and other 2D passes, translucent geometry that does not
+// test depth) still draws over the billboards, as it did inline. Queuing a quad reserves a
+// two-command slot (no-ops) at its position for that call; consecutive quads share one. A quad
+// thus moves later by at most the game commands between it and the last quad of its list.
+//
+// If a display list holding sorted quads does not end the way we expect, or its walk meets
+// a command it cannot step over, those quads are dropped and the mode switches itself off
+// until it is toggled again.
+
+constexpr uint32_t CMD_DL          = 0x06000000; // F3DEX G_DL
+constexpr uint32_t CMD_DL_NOPUSH   = 0x00010000; // G_DL branch: do not return to the caller
+constexpr uint32_t CMD_ENDDL       = 0xB8000000; // F3DEX G_ENDDL
+constexpr uint32_t CMD_RDPLOADSYNC = 0xE6000000;
+constexpr uint32_t CMD_RDPPIPESYNC = 0xE7000000;
+
+constexpr int kSortedQuadCapacity = 2048;
+constexpr int kSortStateCapacity  = 128;
+constexpr int kMaxStateCmds       = 96;
+// Reserved per queued run of quads: gEXSetRDRAMExtended(1) and the G_DL call to the sorted list.
+constexpr uint32_t kSpliceCmds    = 2;
+constexpr uint32_t kSpliceBytes   = kSpliceCmds * sizeof(GfxCommand);
+
+// Upper bound on the top-level display list walk that looks for its end (512 KB).
+constexpr uint32_t kMaxDisplayListCmds = 1u << 16;
+// Upper bound on the state walk, which also counts the commands of called lists.
+constexpr uint32_t kMaxStateWalkCmds = kMaxDisplayListCmds * 4;
+// F3DEX display list stack depth.
+constexpr int kMaxDisplayListDepth = 10;
+
+struct SortState {
+	int count = 0;
+	GfxCommand cmds[kMaxStateCmds] = {};
+};
+
+struct SortedQuad {
+	uint32_t dl_phys = 0;     // display list write position when the hook ran
+	uint32_t splice_phys = 0; // reserved call slot at or right before dl_phys
+	uint64_t frame = 0;       // g_billboard_frame_count when queued
+	int region = 0;           // pool region of that frame
+	int state = -1;           // index into TextureSortQueue::states, assigned by the flush
+	uint16_t prim_depth = 0;
+	uint32_t group_id = 0;
+	gpr proj_mtx_addr = 0;
+	gpr view_mtx_addr = 0;
+	gpr verts_addr = 0;
+};
+
+struct TextureSortQueue {
+	SortedQuad quads[kSortedQuadCapacity];
+	int quad_count = 0;
+	SortState states[kSortStateCapacity]; // states of the display list being flushed
+	int state_count = 0;
+	uint64_t enable_frame = UINT64_MAX; // frame whose display list already has our gEXEnable
+	bool failed = false;                // a display list could not be patched
+};
+
+static TextureSortQueue s_sort;
+
+// First frame whose inline emissions have all been recorded in s_emitted_ranges. Quads are
+// only queued from then on, so the walk never meets our commands unannounced. Game thread.
+static uint64_t s_sort_tracked_frame = UINT64_MAX;
+
+// The texture and blend state as of some point in a display list: the latest command for
+// each piece of state, in the order they were issued, so replaying the slots in order
+// reproduces the state. A load is kept together with the gDPSetTextureImage and load-tile
+// gDPSetTile it used, keyed by the TMEM address it filled.
+class TextureRegisters {
+public:
+	static constexpr int kSlotCapacity = 64;
+	static constexpr int kMaxLoads = 4;
+	static constexpr int kMaxSlotCmds = 4;
+
+	// Applies one state command. Returns false for commands that do not change this state.
+	bool apply(const GfxCommand& cmd, uint32_t timg_phys) {
+		const uint32_t word0 = cmd.values.word0;
+		const uint32_t word1 = cmd.values.word1;
+		const uint32_t op = word0 >> 24;
+		switch (op) {
+			case 0xEF: // G_RDPSETOTHERMODE sets both halves, replacing any partial updates
+				erase_if([](uint32_t key) { return ((key >> 24) == 0xB9) || ((key >> 24) == 0xBA); });
+				set(op << 24, &cmd, 1);
+				return true;
+			case 0xB9: // G_SETOTHERMODE_L
+			case 0xBA: // G_SETOTHERMODE_H: keyed by shift and length
+				set((op << 24) | (word0 & 0xFFFFu), &cmd, 1);
+				return true;
+			case 0xBB: // G_TEXTURE
+			case 0xF8: // G_SETFOGCOLOR
+			case 0xF9: // G_SETBLENDCOLOR
+			case 0xFA: // G_SETPRIMCOLOR
+			case 0xFB: // G_SETENVCOLOR
+			case 0xFC: // G_SETCOMBINE
+				set(op << 24, &cmd, 1);
+				return true;
+			case 0xF5: { // G_SETTILE
+				const uint32_t tile = (word1 >> 24) & 7u;
+				tiles_[tile] = cmd;
+				tile_set_ |= 1u << tile;
+				set((op << 24) | tile, &cmd, 1);
+				return true;
+			}
+			case 0xF2: // G_SETTILESIZE
+				set((op << 24) | ((word1 >> 24) & 7u), &cmd, 1);
+				return true;
+			case 0xFD: // G_SETTIMG: only replayed as part of the loads that use it
+				timg_ = cmd;
+				timg_.values.word1 = timg_phys;
+				has_timg_ = true;
+				return true;
+			case 0xF0: // G_LOADTLUT
+			case 0xF3: // G_LOADBLOCK
+			case 0xF4: { // G_LOADTILE
+				const uint32_t tile = (word1 >> 24) & 7u;
+				if (!has_timg_ || ((tile_set_ & (1u << tile)) == 0)) {
+					// Loads from an image set before the walk started cannot be replayed.
+					return true;
+				}
+				const uint32_t key = (0xF3u << 24) | 0x00800000u | (tiles_[tile].values.word0 & 0x1FFu);
+				erase_if([key](uint32_t k) { return k == key; });
+				if (count_loads() == kMaxLoads) {
+					erase_first_load();
+				}
+				GfxCommand group[kMaxSlotCmds] = { timg_, tiles_[tile], {}, cmd };
+				group[2].values.word0 = CMD_RDPLOADSYNC;
+				group[2].values.word1 = 0;
+				set(key, group, kMaxSlotCmds);
+				return true;
+			}
+			default:
+				return false;
+		}
+	}
+
+	// Writes the state as a command list. Returns the command count, or -1 if it does not fit.
+	int flatten(GfxCommand* out, int capacity) const {
+		int count = 0;
+		auto put = [&](const GfxCommand& cmd) {
+			if (count < capacity) {
+				out[count] = cmd;
+			}
+			count++;
+		};
+		GfxCommand pipe_sync = {};
+		pipe_sync.values.word0 = CMD_RDPPIPESYNC;
+		put(pipe_sync);
+		for (int i = 0; i < slot_count_; i++) {
+			for (int c = 0; c < slots_[i].count; c++) {
+				put(slots_[i].cmds[c]);
+			}
+		}
+		return (count <= capacity) ? count : -1;
+	}
+
+	bool overflowed() const { return overflowed_; }
+
+private:
+	struct Slot {
+		uint32_t key = 0;
+		int count = 0;
+		GfxCommand cmds[kMaxSlotCmds] = {};
+	};
+
+	static bool is_load_key(uint32_t key) {
+		return (key & 0xFF800000u) == ((0xF3u << 24) | 0x00800000u);
+	}
+
+	void set(uint32_t key, const GfxCommand* cmds, int count) {
+		erase_if([key](uint32_t k) { return k == key; });
+		if (slot_count_ == kSlotCapacity) {
+			overflowed_ = true;
+			return;
+		}
+		Slot& slot = slots_[slot_count_++];
+		slot.key = key;
+		slot.count = count;
+		std::memcpy(slot.cmds, cmds, count * sizeof(GfxCommand));
+	}
+
+	template <typename Pred>
+	void erase_if(Pred pred) {
+		int kept = 0;
+		for (int i = 0; i < slot_count_; i++) {
+			if (!pred(slots_[i].key)) {
+				if (kept != i) {
+					slots_[kept] = slots_[i];
+				}
+				kept++;
+			}
+		}
+		slot_count_ = kept;
+	}
+
+	int count_loads() const {
+		int loads = 0;
+		for (int i = 0; i < slot_count_; i++) {
+			loads += is_load_key(slots_[i].key) ? 1 : 0;
+		}
+		return loads;
+	}
+
+	void erase_first_load() {
+		for (int i = 0; i < slot_count_; i++) {
+			if (is_load_key(slots_[i].key)) {
+				const uint32_t key = slots_[i].key;
+				erase_if([key](uint32_t k) { return k == key; });
+				return;
+			}
+		}
+	}
+
+	Slot slots_[kSlotCapacity];
+	int slot_count_ = 0;
+	GfxCommand tiles_[8] = {};
+	uint32_t tile_set_ = 0;
+	GfxCommand timg_ = {};
+	bool has_timg_ = false;
+	bool overflowed_ = false;
+};
+
+// Commands the walk steps over: geometry, matrices and RDP commands outside the texture
+// state. G_CULLDL is stepped over as if nothing was culled; a culled list's state commands
+// then still count, which at worst replays state the game did not use.
+static bool is_state_neutral_cmd(uint32_t op) {
+	switch (op) {
+		case 0x00: // G_SPNOOP / G_NOOP
+		case 0x01: // G_MTX
+		case 0x03: // G_MOVEMEM
+		case 0x04: // G_VTX
+		case 0xB1: // G_TRI2
+		case 0xB2: // G_MODIFYVTX
+		case 0xB3: // G_RDPHALF_2
+		case 0xB4: // G_RDPHALF_1
+		case 0xB5: // G_QUAD
+		case 0xB6: // G_CLEARGEOMETRYMODE
+		case 0xB7: // G_SETGEOMETRYMODE
+		case 0xBD: // G_POPMTX
+		case 0xBE: // G_CULLDL
+		case 0xBF: // G_TRI1
+		case 0xC0: // G_NOOP (RDP)
+		case 0xE4: // G_TEXRECT
+		case 0xE5: // G_TEXRECTFLIP
+		case 0xE6: // G_RDPLOADSYNC
+		case 0xE7: // G_RDPPIPESYNC
+		case 0xE8: // G_RDPTILESYNC
+		case 0xE9: // G_RDPFULLSYNC
+		case 0xEA: // G_SETKEYGB
+		case 0xEB: // G_SETKEYR
+		case 0xEC: // G_SETCONVERT
+		case 0xED: // G_SETSCISSOR
+		case 0xEE: // G_SETPRIMDEPTH
+		case 0xF6: // G_FILLRECT
+		case 0xF7: // G_SETFILLCOLOR
+		case 0xFE: // G_SETZIMG
+		case 0xFF: // G_SETCIMG
+			return true;
+		default:
+			return false;
+	}
+}
+
+// Queues a finished quad for the texture-sorted list. Returns false if the quad has to be
+// emitted inline instead.
+static bool queue_sorted_billboard(uint8_t* rdram, recomp_context* ctx, gpr proj_mtx_addr, gpr view_mtx_addr, gpr verts_addr, uint16_t prim_depth, uint32_t group_id) {
+	if ((s_sort.quad_count == kSortedQuadCapacity) || (s_sort_tracked_frame > g_billboard_frame_count)) {
+		return false;
+	}
+
+	GfxWriteContext wctx;
+	if (!try_get_gfx_ptr(rdram, ctx->r4, wctx)) {
+		return false;
+	}
+	// The call slot of the previous quad is reused when nothing was written since.
+	const bool needs_enable = (s_sort.enable_frame != g_billboard_frame_count);
+	const SortedQuad* previous = (s_sort.quad_count > 0) ? &s_sort.quads[s_sort.quad_count - 1] : nullptr;
+	const bool reuse_slot = !needs_enable && (previous != nullptr) && (previous->frame == g_billboard_frame_count)
+		&& ((previous->splice_phys + kSpliceBytes) == wctx.gdl_phys);
+	const uint32_t needed = (needs_enable ? sizeof(GfxCommand) : 0) + (reuse_slot ? 0 : kSpliceBytes);
+	if (wctx.capacity_bytes < needed) {
+		return false;
+	}
+
+	// The call is preceded by an extended command, so the extended parser has to be on by
+	// then. One gEXEnable per frame is enough.
+	GfxCommand* cmd = wctx.cmd;
+	if (needs_enable) {
+		gEXEnable(cmd);
+		cmd++;
+		s_sort.enable_frame = g_billboard_frame_count;
+	}
+	uint32_t splice_phys = reuse_slot ? previous->splice_phys : 0;
+	if (!reuse_slot) {
+		splice_phys = wctx.gdl_phys + static_cast<uint32_t>(reinterpret_cast<uint8_t*>(cmd) - reinterpret_cast<uint8_t*>(wctx.cmd));
+		for (uint32_t i = 0; i < kSpliceCmds; i++) {
+			cmd->values.word0 = CMD_SPNOOP;
+			cmd->values.word1 = 0;
+			cmd++;
+		}
+	}
+	if (cmd != wctx.cmd) {
+		advance_gfx_ptr(rdram, wctx, cmd, ctx->r4);
+	}
+
+	SortedQuad& quad = s_sort.quads[s_sort.quad_count++];
+	quad.dl_phys = wctx.gdl_phys + static_cast<uint32_t>(reinterpret_cast<uint8_t*>(cmd) - reinterpret_cast<uint8_t*>(wctx.cmd));
+	quad.splice_phys = splice_phys;
+	quad.frame = g_billboard_frame_count;
+	quad.region = s_alloc.region;
+	quad.state = -1;
+	quad.prim_depth = prim_depth;
+	quad.group_id = group_id;
+	quad.proj_mtx_addr = proj_mtx_addr;
+	quad.view_mtx_addr = view_mtx_addr;
+	quad.verts_addr = verts_addr;
+	s_queues_pending.store(true, std::memory_order_release);
+	return true;
+}
+
+struct DisplayListEnd {
+	uint32_t last_phys = 0;  // last command the walk looked at
+	bool found = false;      // last_phys is gSPEndDisplayList
+};
+
+// Walks the top-level display list at dl_phys (without following calls) to its end.
+static DisplayListEnd find_display_list_end(uint8_t* rdram, uint32_t dl_phys) {
+	DisplayListEnd end;
+	const GfxCommand* cmds = reinterpret_cast<const GfxCommand*>(rdram + dl_phys);
+	const uint32_t max_cmds = std::min(kMaxDisplayListCmds, (RDRAM_SIZE_BYTES - dl_phys) / static_cast<uint32_t>(sizeof(GfxCommand)));
+	for (uint32_t i = 0; i < max_cmds; i++) {
+		const uint32_t word0 = cmds[i].values.word0;
+		end.last_phys = dl_phys + (i * static_cast<uint32_t>(sizeof(GfxCommand)));
+		if (word0 == CMD_ENDDL) {
+			end.found = true;
+			return end;
+		}
+		// A top-level branch continues the list elsewhere; its end is not ours to find.
+		if ((word0 & 0xFFFF0000u) == (CMD_DL | CMD_DL_NOPUSH)) {
+			return end;
+		}
+	}
+	return end;
+}
+
+// Returns the index of the state in the table, adding it if it is new; -1 if the table is full.
+static int intern_sort_state(const GfxCommand* cmds, int count) {
+	for (int i = 0; i < s_sort.state_count; i++) {
+		const SortState& state = s_sort.states[i];
+		if ((state.count == count) && (std::memcmp(state.cmds, cmds, count * sizeof(GfxCommand)) == 0)) {
+			return i;
+		}
+	}
+	if (s_sort.state_count == kSortStateCapacity) {
+		return -1;
+	}
+	SortState& state = s_sort.states[s_sort.state_count];
+	state.count = count;
+	std::memcpy(state.cmds, cmds, count * sizeof(GfxCommand));
+	return s_sort.state_count++;
+}
+
+// Walks the display list from dl_phys to end_phys, following calls, and assigns each quad
+// at order[0..count) (sorted by dl_phys) the texture state in effect at its position.
+// Emitted ranges of the quads' frame are stepped over. Returns false if the walk met a
+// command it cannot follow; quads it did not reach keep state -1.
+static bool assign_sorted_states(uint8_t* rdram, uint32_t dl_phys, uint32_t end_phys, const int* order, int count) {
+	const uint64_t frame = s_sort.quads[order[0]].frame;
+	static std::vector<EmittedRange> s_ranges;
+	s_ranges.clear();
+	for (const EmittedRange& range : s_emitted_ranges) {
+		if (range.frame == frame) {
+			s_ranges.push_back(range);
+		}
+	}
+	std::sort(s_ranges.begin(), s_ranges.end(), [](const EmittedRange& a, const EmittedRange& b) {
+		return a.begin_phys < b.begin_phys;
+	});
+	auto emitted_end = [](uint32_t phys) -> uint32_t {
+		auto it = std::upper_bound(s_ranges.begin(), s_ranges.end(), phys, [](uint32_t p, const EmittedRange& range) {
+			return p < range.begin_phys;
+		});
+		if ((it == s_ranges.begin()) || (phys >= std::prev(it)->end_phys)) {
+			return 0;
+		}
+		return std::prev(it)->end_phys;
+	};
+
+	uint32_t segments[16] = {};
+	auto resolve = [&segments](uint32_t addr) -> uint32_t {
+		return (segments[(addr >> 24) & 0xFu] + (addr & 0x00FFFFFFu)) & 0x00FFFFFFu;
+	};
+
+	TextureRegisters regs;
+	uint32_t stack[kMaxDisplayListDepth] = {};
+	int depth = 0;
+	int next = 0;
+	uint32_t pc = dl_phys;
+	static GfxCommand s_flat[kMaxStateCmds];
+
+	for (uint32_t steps = 0; steps < kMaxStateWalkCmds; steps++) {
+		if ((depth == 0) && (next < count) && (s_sort.quads[order[next]].dl_phys <= pc)) {
+			const int flat_count = regs.overflowed() ? -1 : regs.flatten(s_flat, kMaxStateCmds);
+			const int state = (flat_count < 0) ? -1 : intern_sort_state(s_flat, flat_count);
+			while ((next < count) && (s_sort.quads[order[next]].dl_phys <= pc)) {
+				s_sort.quads[order[next++]].state = state;
+			}
+		}
+		if ((depth == 0) && (pc >= end_phys)) {
+			return true;
+		}
+		if (const uint32_t skip_to = emitted_end(pc); skip_to != 0) {
+			pc = skip_to;
+			continue;
+		}
+		if (((pc & 7u) != 0) || (pc > (RDRAM_SIZE_BYTES - sizeof(GfxCommand)))) {
+			return false;
+		}
+
+		const GfxCommand& cmd = *reinterpret_cast<const GfxCommand*>(rdram + pc);
+		const uint32_t word0 = cmd.values.word0;
+		const uint32_t op = word0 >> 24;
+		pc += sizeof(GfxCommand);
+
+		if (op == (CMD_DL >> 24)) {
+			if ((word0 & CMD_DL_NOPUSH) == 0) {
+				if (depth == kMaxDisplayListDepth) {
+					return false;
+				}
+				stack[depth++] = pc;
+			}
+			pc = resolve(cmd.values.word1);
+		} else if (word0 == CMD_ENDDL) {
+			if (depth == 0) {
+				return true;
+			}
+			pc = stack[--depth];
+		} else if (op == 0xBC) {
+			// G_MOVEWORD: only segment writes matter here.
+			if ((word0 & 0xFFu) == 0x06) {
+				segments[((word0 >> 10) & 0xFu)] = cmd.values.word1 & 0x00FFFFFFu;
+			}
+		} else if (!regs.apply(cmd, resolve(cmd.values.word1)) && !is_state_neutral_cmd(op)) {
+			// Branches we cannot evaluate (G_BRANCH_Z), microcode loads and commands we
+			// did not write ourselves, e.g. extended commands from another patch.
+			return false;
+		}
+	}
+	return false;
+}
+
+// Writes the sorted list for the quads at order[0..count) into the pool region of their
+// frame and returns its address, or 0 if the region has no room for it. The list ends by
+// replaying return_state, the state in effect where it is called from.
+static gpr write_sorted_billboard_list(uint8_t* rdram, int* order, int count, int return_state) {
+	const int region = s_sort.quads[order[0]].region;
+	std::stable_sort(order, order + count, [](int a, int b) {
+		const SortedQuad& qa = s_sort.quads[a];
+		const SortedQuad& qb = s_sort.quads[b];
+		if (qa.proj_mtx_addr != qb.proj_mtx_addr) {
+			return qa.proj_mtx_addr < qb.proj_mtx_addr;
+		}
+		return qa.state < qb.state;
+	});
+
+	auto starts_run = [&](int i) {
+		return (i == 0) || (s_sort.quads[order[i]].proj_mtx_addr != s_sort.quads[order[i - 1]].proj_mtx_addr);
+	};
+	auto starts_state = [&](int i) {
+		return starts_run(i) || (s_sort.quads[order[i]].state != s_sort.quads[order[i - 1]].state);
+	};
+
+	// Per state group: gEXSetRDRAMExtended(0), the state, gEXSetRDRAMExtended(1), TP_PERSP.
+	constexpr uint32_t kStateWrapCmds = 3;
+	// Final run tail, the return state and gSPEndDisplayList.
+	uint32_t total_cmds = kRunTailCmds + static_cast<uint32_t>(s_sort.states[return_state].count) + 1;
+	for (int i = 0; i < count; i++) {
+		if (starts_run(i)) {
+			total_cmds += kRunHeaderCmds + ((i > 0) ? kRunTailCmds : 0);
+		}
+		if (starts_state(i)) {
+			total_cmds += static_cast<uint32_t>(s_sort.states[s_sort.quads[order[i]].state].count) + kStateWrapCmds;
+		}
+		total_cmds += kQuadCmds;
+	}
+
+	gpr list_addr = 0;
+	if (!allocate_billboard_data_in_region(rdram, region, static_cast<int>(total_cmds * sizeof(GfxCommand)), list_addr)) {
+		return 0;
+	}
+
+	GfxCommand* cmd = reinterpret_cast<GfxCommand*>(rdram + vram_to_phys_u32(list_addr));
+	for (int i = 0; i < count; i++) {
+		const SortedQuad& quad = s_sort.quads[order[i]];
+		if (starts_run(i)) {
+			if (i > 0) {
+				cmd = emit_run_tail(cmd, s_sort.quads[order[i - 1]].view_mtx_addr);
+			}
+			cmd = emit_run_header(cmd, quad.proj_mtx_addr, quad.view_mtx_addr);
+		}
+		if (starts_state(i)) {
+			// The captured state addresses game RDRAM, which must not be resolved as extended.
+			const SortState& state = s_sort.states[quad.state];
+			gEXSetRDRAMExtended(cmd, 0);
+			cmd++;
+			std::memcpy(cmd, state.cmds, state.count * sizeof(GfxCommand));
+			cmd += state.count;
+			gEXSetRDRAMExtended(cmd, 1);
+			cmd++;
+			// The state may have rewritten othermode H, so force G_TP_PERSP again.
+			cmd->values.word0 = CMD_SETOTHERMODE_H_TP_PERSP;
+			cmd->values.word1 = CMD_SETOTHERMODE_H_TP_PERSP_W1;
+			cmd++;
+		}
+		cmd = emit_quad(cmd, quad.prim_depth, quad.group_id, quad.verts_addr);
+	}
+	cmd = emit_run_tail(cmd, s_sort.quads[order[count - 1]].view_mtx_addr);
+
+	// The run tail leaves extended addressing off, as the game's commands expect.
+	const SortState& state = s_sort.states[return_state];
+	std::memcpy(cmd, state.cmds, state.count * sizeof(GfxCommand));
+	cmd += state.count;
+	cmd->values.word0 = CMD_ENDDL;
+	cmd->values.word1 = 0;
+	return list_addr;
+}
+
+static void fail_texture_sort(const char* reason, int dropped) {
+	if (!s_sort.failed) {
+		std::printf("[BILLBOARD] texture-sorted flush disabled: %s (%d quads dropped)\n", reason, dropped);
+		std::fflush(stdout);
+	}
+	s_sort.failed = true;
+}
+
+// Removes the quads for which drop(quad) is true, keeping the rest in queue order.
+template <typename Pred>
+static int remove_sorted_quads(Pred drop) {
+	int kept = 0;
+	for (int i = 0; i < s_sort.quad_count; i++) {
+		if (!drop(s_sort.quads[i])) {
+			s_sort.quads[kept++] = s_sort.quads[i];
+		}
+	}
+	const int removed = s_sort.quad_count - kept;
+	s_sort.quad_count = kept;
+	return removed;
+}
+
+// Moves the sorted quads of the display list that starts at dl_phys into their list and
+// calls it from the slot reserved after the last of them.
+static void flush_sorted_billboards(uint8_t* rdram, uint32_t dl_phys) {
+	if (dl_phys < RDRAM_SIZE_BYTES) {
+		const DisplayListEnd end = find_display_list_end(rdram, dl_phys);
+		auto in_list = [&](const SortedQuad& quad) {
+			return (quad.dl_phys >= dl_phys) && (quad.dl_phys <= end.last_phys);
+		};
+
+		static int s_order[kSortedQuadCapacity];
+		int count = 0;
+		for (int i = 0; i < s_sort.quad_count; i++) {
+			if (in_list(s_sort.quads[i])) {
+				s_order[count++] = i;
+			}
+		}
+
+		if (count > 0) {
+			if (!end.found) {
+				fail_texture_sort("display list does not end with gSPEndDisplayList", remove_sorted_quads(in_list));
+			} else {
+				std::stable_sort(s_order, s_order + count, [](int a, int b) {
+					return s_sort.quads[a].dl_phys < s_sort.quads[b].dl_phys;
+				});
+				const uint64_t frame = s_sort.quads[s_order[0]].frame;
+				s_sort.state_count = 0;
+				const bool walked = assign_sorted_states(rdram, dl_phys, end.last_phys, s_order, count);
+				int placeable = 0;
+				for (int i = 0; i < count; i++) {
+					if (s_sort.quads[s_order[i]].state >= 0) {
+						s_order[placeable++] = s_order[i];
+					}
+				}
+				if (placeable > 0) {
+					// The quads are still in list order here; nothing is drawn between the
+					// last one's slot and its position, so its state is the slot's too.
+					const SortedQuad& last = s_sort.quads[s_order[placeable - 1]];
+					const uint32_t splice_phys = last.splice_phys;
+					const gpr list_addr = write_sorted_billboard_list(rdram, s_order, placeable, last.state);
+					if (list_addr != 0) {
+						GfxCommand* splice = reinterpret_cast<GfxCommand*>(rdram + splice_phys);
+						gEXSetRDRAMExtended(&splice[0], 1);
+						splice[1].values.word0 = CMD_DL; // push: the list returns to the slot
+						splice[1].values.word1 = static_cast<uint32_t>(list_addr);
+					}
+				}
+				// Without room in the pool the quads are lost for this frame, like any
+				// other allocation failure (counted in overflow_count).
+				const int unplaced = remove_sorted_quads(in_list) - placeable;
+				if (!walked) {
+					fail_texture_sort("display list walk met a command it cannot follow", unplaced);
+				} else if (unplaced > 0) {
+					fail_texture_sort("too many distinct texture states", unplaced);
+				}
+				// The walk was the last reader of this frame's emitted ranges.
+				prune_emitted_ranges(frame + 1);
+			}
+		}
+	}
+
+	// Anything still queued from a frame whose pool region is about to be reused was never
+	// part of a submitted display list (e.g. written into a sub-list), so it cannot be placed.
+	const int stale = remove_sorted_quads([](const SortedQuad& quad) {
+		return (quad.frame + (BILLBOARD_POOL_REGIONS - 1)) <= g_billboard_frame_count;
+	});
+	if (stale > 0) {
+		fail_texture_sort("quads outside the submitted display lists", stale);
+	}
+	update_queues_pending();
+}
+
+static void update_queues_pending() {
+	s_queues_pending.store((s_deferred.count != 0) || (s_sort.quad_count != 0), std::memory_order_release);
+}
+
+template <typename Traits>
+static RewriteOutcome rewrite_billboard_ortho_quad(uint8_t* rdram, recomp_context* ctx, const BillboardDynamic& dyn, RewriteTrace* out_trace) {
+	// The renderer thread only touches rewrite state to flush the queues, so the lock is only
+	// needed while a queue is switched on or still holds entries. The modes are read once so
+	// they cannot change under an unlocked call.
+	const bool deferred_requested = g_billboard_deferred_projection;
+	const bool sort_requested = g_billboard_texture_sort;
+	std::unique_lock<std::mutex> lock(s_billboard_mutex, std::defer_lock);
+	if (deferred_requested || sort_requested || s_queues_pending.load(std::memory_order_acquire)) {
+		lock.lock();
+	}
+	const bool texture_sort = sort_requested && !s_sort.failed;
+	s_track_emitted = texture_sort;
+	if (!texture_sort) {
+		s_sort_tracked_frame = UINT64_MAX;
+	}
+
+	// Texture-sorted quads need their vertices at queue time, so that mode takes precedence.
+	const bool deferred_projection = deferred_requested && !texture_sort;
+
+	// Switching deferred mode off mid-frame: project what is still queued first so the
+	// interpolation cache sees billboards in draw order.
+	if (!deferred_projection && (s_deferred.count != 0)) {
+		flush_deferred_billboards(rdram);
+	}
+
+	BillboardInput in;
+	in.dyn = dyn;
+	in.world_x = static_cast<int32_t>(ctx->r5);
+	in.world_y = static_cast<int32_t>(ctx->r6);
+	in.world_z = static_cast<int32_t>(ctx->r7);
+
+	in.half_w  = static_cast<int16_t>(MEM_W(0x10, ctx->r29));
+	in.half_h  = static_cast<int16_t>(MEM_W(0x14, ctx->r29));
+	in.scale   = static_cast<int32_t>(MEM_W(0x18, ctx->r29));
+	in.scale_y = Traits::dual_scale ? static_cast<int32_t>(MEM_W(0x1C, ctx->r29)) : in.scale;
+
+	RewriteTrace trace;
+	trace.world_x = in.world_x;
+	trace.world_y = in.world_y;
+	trace.world_z = in.world_z;
+	trace.half_w  = in.half_w;
+	trace.half_h  = in.half_h;
+	trace.scale   = in.scale;
+
+	if ((in.half_w <= 0) || (in.half_h <= 0) || (in.scale <= 0) || (Traits::dual_scale && (in.scale_y <= 0))) {
+		if (out_trace) *out_trace = trace;
+		return RewriteOutcome::InvalidArgs;
+	}
+
+	in.screen_w = static_cast<int16_t>(MEM_H(0, ADDR_SCREEN_WIDTH));
+	in.screen_h = static_cast<int16_t>(MEM_H(0, ADDR_SCREEN_HEIGHT));
+	trace.screen_w = in.screen_w;
+	trace.screen_h = in.screen_h;
+
+	if ((in.screen_w <= 0) || (in.screen_h <= 0)) {
+		if (out_trace) *out_trace = trace;
+		return RewriteOutcome::InvalidScreen;
+	}
+
+	const gpr dl_state = MEM_W(0, ADDR_D_80204278_PTR);
+	if (dl_state == 0) {
+		if (out_trace) *out_trace = trace;
+		return RewriteOutcome::MissingDlState;
+	}
+
+	// Reset our extended RDRAM allocator on new frame (dl_state change).
+	if (s_alloc.dl_state != dl_state) {
+		// Queued billboards belong to the previous frame's matrices and pool.
+		if (s_deferred.count != 0) {
+			flush_deferred_billboards(rdram);
+		}
+		s_alloc.dl_state = dl_state;
+		begin_billboard_pool_frame();
+		s_alloc.matrices_cached = false;
+		s_alloc.vp_cached = false;
+		s_run.active = false;
+		g_billboard_frame_count++;
+		if (texture_sort) {
+			// Ranges of frames whose pool region is about to be reused are no longer walked.
+			if (g_billboard_frame_count >= BILLBOARD_POOL_REGIONS) {
+				prune_emitted_ranges(g_billboard_frame_count - (BILLBOARD_POOL_REGIONS - 1));
+			}
+			if (s_sort_tracked_frame == UINT64_MAX) {
+				s_sort_tracked_frame = g_billboard_frame_count;
+			}
+		}
+	}
+
+	// Check if we can reuse cached matrices from an earlier billboard this frame.
+	const bool cache_hit = s_alloc.matrices_cached
+		&& (s_alloc.screen_w == in.screen_w)
+		&& (s_alloc.screen_h == in.screen_h);
+
+	// Early capacity check: bail out before expensive math if our pool is full.
+	{
+		constexpr int kMtxBytes = static_cast<int>(sizeof(float) * 16);
+		constexpr int kVtxBytes = static_cast<int>(sizeof(Rt64VertexExV1) * 4);
+		const int kNeededBytes = cache_hit ? kVtxBytes : (2 * kMtxBytes) + kVtxBytes;
+		const int kNeededSlots = (kNeededBytes + (BILLBOARD_SLOT_BYTES - 1))
+		                       / BILLBOARD_SLOT_BYTES;
+		if (!reserve_billboard_pool_slots(kNeededSlots)) {
+			if (out_trace) *out_trace = trace;
+			return RewriteOutcome::AllocFail;
+		}
+	}
+
+	// Read the game's view-projection matrix once per frame, then serve from cache.
+	// Saves 16 RDRAM reads per billboard call after the first one each frame.
+	if (!s_alloc.vp_cached) {
+		const gpr m_base = ADD32(dl_state, DISPLAYLIST_OFF_VIEWPROJ_F32);
+		for (int i = 0; i < 16; i++) {
+			s_alloc.vp_mtx[i] = read_f32(rdram, ADD32(m_base, i * 4));
+		}
+		s_alloc.vp_cached = true;
+	}
+
+	in.fov_y = read_f32(rdram, ADD32(ADDR_LEVEL_CONFIG, LEVELCFG_OFF_FOV_Y));
+	in.prim_depth_bias = static_cast<int16_t>(MEM_H(LEVELCFG_OFF_PRIMDEPTH_BIAS, ADDR_LEVEL_CONFIG));
+
+	// Quantize world coords for hashing/signature when items pulsate (Power Cells).
+	// Right-shifting by hash_coord_shift rounds positions to a coarser grid so small
+	// frame-to-frame Z/scale oscillations don't produce a new group_id every frame.
+	in.q_x = in.world_x >> Traits::hash_coord_shift;
+	in.q_y = in.world_y >> Traits::hash_coord_shift;
+	in.q_z = in.world_z >> Traits::hash_coord_shift;
+
+	// For items with animated scale (Power Orbs fade-out), exclude scale from hash
+	// so the group_id remains stable across frames and interpolation works correctly.
+	const int32_t hash_scale = Traits::hash_includes_scale ? in.scale : 0;
+	in.group_id = billboard_group_id(in.q_x, in.q_y, in.q_z, in.half_w, in.half_h, hash_scale, Traits::hash_salt);
+	if (g_billboard_owner_identity) {
+		const uint32_t owner_key = owner_identity_key<Traits>(ctx, in.world_x, in.world_y, in.world_z);
+		if (owner_key != 0) {
+			in.group_id = owner_key;
+			in.owner_identity = true;
+		}
+	}
+	trace.group_id = in.group_id;
+
+	gpr proj_mtx_addr = 0, view_mtx_addr = 0, verts_addr = 0;
+
+	if (deferred_projection) {
+		// The hook suppresses the original draw as soon as we report Emitted, so anything
+		// that should fall back to the original path has to be rejected now. The depth
+		// rejects need only cam_z (one matrix row); what is left for the flush is the
+		// offscreen test, and a billboard that fails it is not visible on either path.
+		BillboardScale scale;
+		const RewriteOutcome depth_outcome = check_billboard_depth<Traits>(
+			in, project_billboard_depth(s_alloc.vp_mtx, in.world_x, in.world_y, in.world_z), scale, trace);
+		if (depth_outcome != RewriteOutcome::Emitted) {
+			if (out_trace) *out_trace = trace;
+			return depth_outcome;
+		}
+		if (!reserve_billboard_storage(rdram, cache_hit, in.screen_w, in.screen_h, proj_mtx_addr, view_mtx_addr, verts_addr)) {
+			if (out_trace) *out_trace = trace;
+			return RewriteOutcome::AllocFail;
+		}
+		uint32_t quad_phys = 0;
+		const RewriteOutcome outcome = emit_billboard(rdram, ctx, cache_hit, proj_mtx_addr, view_mtx_addr, verts_addr, 0, in.group_id, trace, &quad_phys);
+		if (outcome == RewriteOutcome::Emitted) {
+			queue_deferred_billboard(rdram, in, &finish_billboard<Traits>, verts_addr, quad_phys);
+			trace.deferred = true;
+		}
+		if (out_trace) *out_trace = trace;
+		return outcome;
+	}
+
+	const BillboardProjection proj = project_billboard_scalar(
+		s_alloc.vp_mtx, in.world_x, in.world_y, in.world_z,
+		static_cast<float>(in.screen_w) * 2.0f,
+		static_cast<float>(in.screen_h) * 2.0f);
+
+	BillboardQuad quad;
+	const RewriteOutcome finish_outcome = finish_billboard<Traits>(in, proj, quad, trace);
+	if (finish_outcome != RewriteOutcome::Emitted) {
+		if (out_trace) *out_trace = trace;
+		return finish_outcome;
+	}
+
+	if (!reserve_billboard_storage(rdram, cache_hit, in.screen_w, in.screen_h, proj_mtx_addr, view_mtx_addr, verts_addr)) {
+		if (out_trace) *out_trace = trace;
+		return RewriteOutcome::AllocFail;
+	}
+
+	write_billboard_vertices(rdram, verts_addr, in, quad);
+
+	if (texture_sort && queue_sorted_billboard(rdram, ctx, proj_mtx_addr, view_mtx_addr, verts_addr, quad.prim_depth, in.group_id)) {
+		trace.sorted = true;
+		if (out_trace) *out_trace = trace;
+		return RewriteOutcome::Emitted;
+	}
+
+	const RewriteOutcome outcome = emit_billboard(rdram, ctx, cache_hit, proj_mtx_addr, view_mtx_addr, verts_addr, quad.prim_depth, in.group_id, trace, nullptr);
+	if (out_trace) *out_trace = trace;
+	return outcome;
+}
+
+namespace capture = sssv::billboard::capture;
+namespace telemetry = sssv::billboard::telemetry;
+
+// Snapshot of the game state the rewrite reads, for the capture trace.
+static capture::FrameRecord read_capture_frame(uint8_t* rdram) {
+	capture::FrameRecord frame;
+	const gpr dl_state = MEM_W(0, ADDR_D_80204278_PTR);
+	frame.dl_state = static_cast<uint32_t>(dl_state);
+	if (dl_state != 0) {
+		const gpr m_base = ADD32(dl_state, DISPLAYLIST_OFF_VIEWPROJ_F32);
+		for (int i = 0; i < 16; i++) {
+			frame.vp_mtx[i] = read_f32(rdram, ADD32(m_base, i * 4));
+		}
+	}
+	frame.screen_w = static_cast<int16_t>(MEM_H(0, ADDR_SCREEN_WIDTH));
+	frame.screen_h = static_cast<int16_t>(MEM_H(0, ADDR_SCREEN_HEIGHT));
+	frame.fov_y = read_f32(rdram, ADD32(ADDR_LEVEL_CONFIG, LEVELCFG_OFF_FOV_Y));
+	frame.prim_depth_bias = static_cast<int16_t>(MEM_H(LEVELCFG_OFF_PRIMDEPTH_BIAS, ADDR_LEVEL_CONFIG));
+	return frame;
+}
+
+static capture::CallRecord read_capture_call(uint8_t* rdram, recomp_context* ctx, telemetry::Hook hook) {
+	capture::CallRecord call;
+	call.hook = static_cast<uint32_t>(hook);
+	call.r4 = static_cast<uint32_t>(ctx->r4);
+	call.r5 = static_cast<uint32_t>(ctx->r5);
+	call.r6 = static_cast<uint32_t>(ctx->r6);
+	call.r7 = static_cast<uint32_t>(ctx->r7);
+	call.r29 = static_cast<uint32_t>(ctx->r29);
+	for (int i = 0; i < 6; i++) {
+		call.stack[i] = static_cast<uint32_t>(MEM_W(0x10 + (i * 4), ctx->r29));
+	}
+	call.gfx_before = static_cast<uint32_t>(MEM_W(0, ctx->r4));
+	return call;
+}
+
+// Runs the rewrite for one hook call, recording it when capture is on and timing it when
+// telemetry is on.
+template <typename Traits>
+static RewriteOutcome run_rewrite(uint8_t* rdram, recomp_context* ctx, const BillboardDynamic& dyn, RewriteTrace* out_trace, telemetry::Hook hook) {
+	if (!telemetry::enabled() && !capture::enabled()) {
+		return rewrite_billboard_ortho_quad<Traits>(rdram, ctx, dyn, out_trace);
+	}
+
+	capture::CallRecord call;
+	if (capture::enabled()) {
+		capture::write_frame(read_capture_frame(rdram));
+		call = read_capture_call(rdram, ctx, hook);
+	}
+
+	const uint64_t start_ns = telemetry::enabled() ? telemetry::now_ns() : 0;
+	const RewriteOutcome outcome = rewrite_billboard_ortho_quad<Traits>(rdram, ctx, dyn, out_trace);
+	if (telemetry::enabled()) {
+		const uint64_t elapsed_ns = telemetry::now_ns() - start_ns;
+		telemetry::record_call(hook, outcome == RewriteOutcome::Emitted, elapsed_ns, s_alloc.used_slots, g_billboard_frame_count);
+	}
+
+	if (capture::enabled()) {
+		call.gfx_after = static_cast<uint32_t>(MEM_W(0, ctx->r4));
+		capture::write_call(call);
+	}
+	return outcome;
+}
+
+// With the adaptive budget on, billboards past this frame's per-category budget keep the
+// game's original draw.
+static bool within_rewrite_budget(uint8_t* rdram, telemetry::Hook hook) {
+	if (!budget::enabled()) {
+		return true;
+	}
+	budget::begin_frame(static_cast<uint32_t>(MEM_W(0, ADDR_D_80204278_PTR)));
+	return budget::take_rewrite(hook);
+}
+
+// Runtime arguments of the hooks that have them, read from the stack.
+static BillboardDynamic read_dynamic_73f800(uint8_t* rdram, recomp_context* ctx) {
+	BillboardDynamic dyn;
+	const int16_t raw_half_h = static_cast<int16_t>(MEM_W(0x14, ctx->r29));
+	if (raw_half_h > 32) {
+		dyn.geom_half_h = raw_half_h - 32;
+		dyn.y_top_mul = 3.0f;
+	}
+	return dyn;
+}
+
+static BillboardDynamic read_dynamic_740820(uint8_t* rdram, recomp_context* ctx) {
+	BillboardDynamic dyn;
+	dyn.screen_wrap = (static_cast<uint8_t>(MEM_W(0x20, ctx->r29)) != 0);
+	dyn.offset_clamp = static_cast<int16_t>(MEM_W(0x24, ctx->r29));
+	return dyn;
+}
+
+} // namespace
+
+namespace sssv::billboard {
+
+void set_disable_6fa3a4_render(bool enabled) {
+	g_disable_6fa3a4_render = enabled;
+	refresh_hooks();
+}
 
 bool get_disable_6fa3a4_render() {
 	return g_disable_6fa3a4_render;
 }
 
-void set_disable_lod(bool v) { g_disable_lod = v; }
+void set_disable_lod(bool v) { g_disable_lod = v; refresh_hooks(); }
 bool get_disable_lod() { return g_disable_lod; }
 
 void set_disable_6c5e44_render(bool enabled) {
 	g_disable_6c5e44_render = enabled;
+	refresh_hooks();
 }
 
 bool get_disable_6c5e44_render() {
@@ -931,6 +2469,7 @@ bool get_disable_6c5e44_render() {
 
 void set_disable_73f17c_render(bool enabled) {
 	g_disable_73f17c_render = enabled;
+	refresh_hooks();
 }
 
 bool get_disable_73f17c_render() {
@@ -939,6 +2478,7 @@ bool get_disable_73f17c_render() {
 
 void set_disable_73f800_render(bool enabled) {
 	g_disable_73f800_render = enabled;
+	refresh_hooks();
 }
 
 bool get_disable_73f800_render() {
@@ -947,6 +2487,7 @@ bool get_disable_73f800_render() {
 
 void set_disable_740094_render(bool enabled) {
 	g_disable_740094_render = enabled;
+	refresh_hooks();
 }
 
 bool get_disable_740094_render() {
@@ -955,44 +2496,181 @@ bool get_disable_740094_render() {
 
 void set_disable_740820_render(bool enabled) {
 	g_disable_740820_render = enabled;
+	refresh_hooks();
 }
 
 bool get_disable_740820_render() {
 	return g_disable_740820_render;
 }
 
-void set_rewrite_6c5e44_ortho(bool v) { g_rewrite_6c5e44_ortho = v; }
+void set_rewrite_6c5e44_ortho(bool v) { g_rewrite_6c5e44_ortho = v; refresh_hooks(); }
 bool get_rewrite_6c5e44_ortho() { return g_rewrite_6c5e44_ortho; }
 void set_rewrite_6c5e44_suppress_original(bool v) { g_rewrite_6c5e44_suppress_original = v; }
 bool get_rewrite_6c5e44_suppress_original() { return g_rewrite_6c5e44_suppress_original; }
 
-void set_rewrite_73f17c_ortho(bool v) { g_rewrite_73f17c_ortho = v; }
+void set_rewrite_73f17c_ortho(bool v) { g_rewrite_73f17c_ortho = v; refresh_hooks(); }
 bool get_rewrite_73f17c_ortho() { return g_rewrite_73f17c_ortho; }
 void set_rewrite_73f17c_suppress_original(bool v) { g_rewrite_73f17c_suppress_original = v; }
 bool get_rewrite_73f17c_suppress_original() { return g_rewrite_73f17c_suppress_original; }
 
-void set_rewrite_73f800_ortho(bool v) { g_rewrite_73f800_ortho = v; }
+void set_rewrite_73f800_ortho(bool v) { g_rewrite_73f800_ortho = v; refresh_hooks(); }
 bool get_rewrite_73f800_ortho() { return g_rewrite_73f800_ortho; }
 void set_rewrite_73f800_suppress_original(bool v) { g_rewrite_73f800_suppress_original = v; }
 bool get_rewrite_73f800_suppress_original() { return g_rewrite_73f800_suppress_original; }
 
-void set_rewrite_740094_ortho(bool v) { g_rewrite_740094_ortho = v; }
+void set_rewrite_740094_ortho(bool v) { g_rewrite_740094_ortho = v; refresh_hooks(); }
 bool get_rewrite_740094_ortho() { return g_rewrite_740094_ortho; }
 void set_rewrite_740094_suppress_original(bool v) { g_rewrite_740094_suppress_original = v; }
 bool get_rewrite_740094_suppress_original() { return g_rewrite_740094_suppress_original; }
 
-void set_rewrite_740820_ortho(bool v) { g_rewrite_740820_ortho = v; }
+void set_rewrite_740820_ortho(bool v) { g_rewrite_740820_ortho = v; refresh_hooks(); }
 bool get_rewrite_740820_ortho() { return g_rewrite_740820_ortho; }
 void set_rewrite_740820_suppress_original(bool v) { g_rewrite_740820_suppress_original = v; }
 bool get_rewrite_740820_suppress_original() { return g_rewrite_740820_suppress_original; }
 
-void set_log_73f17c_ortho(bool v) { g_log_73f17c_ortho = v; }
+void set_log_73f17c_ortho(bool v) { g_log_73f17c_ortho = v; refresh_hooks(); }
 bool get_log_73f17c_ortho() { return g_log_73f17c_ortho; }
 
+void set_batch_emit(bool v) { g_billboard_batch_emit = v; }
+bool get_batch_emit() { return g_billboard_batch_emit; }
+
+void set_deferred_projection(bool v) { g_billboard_deferred_projection = v; }
+bool get_deferred_projection() { return g_billboard_deferred_projection; }
+
+void set_owner_identity(bool v) {
+	if (v && !g_billboard_owner_identity) {
+		s_owner_probes_reset.store(true, std::memory_order_release);
+	}
+	g_billboard_owner_identity = v;
+}
+bool get_owner_identity() { return g_billboard_owner_identity; }
+
+void set_texture_sort(bool v) {
+	std::lock_guard<std::mutex> lock(s_billboard_mutex);
+	g_billboard_texture_sort = v;
+	s_sort.failed = false;
+}
+bool get_texture_sort() { return g_billboard_texture_sort; }
+
+void on_display_list_submit(uint8_t* rdram, uint32_t dl_addr) {
+	budget::on_display_list_submitted();
+	if (!s_queues_pending.load(std::memory_order_acquire)) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(s_billboard_mutex);
+	if (s_deferred.count != 0) {
+		flush_deferred_billboards(rdram);
+	}
+	if ((s_sort.quad_count != 0) && (dl_addr != 0)) {
+		flush_sorted_billboards(rdram, dl_addr & 0x3FFFFFFu);
+	}
+}
+
 } // namespace sssv::billboard
 
-extern "C" void sssv_hook_lod_visibility(uint8_t* rdram, recomp_context* ctx) {
-	if (!g_disable_lod) return;
+namespace sssv::billboard::capture {
+
+void apply_frame(uint8_t* rdram, const FrameRecord& frame) {
+	auto write_f32 = [rdram](gpr addr, float value) {
+		uint32_t bits = 0;
+		std::memcpy(&bits, &value, sizeof(bits));
+		MEM_W(0, addr) = static_cast<int32_t>(bits);
+	};
+
+	const gpr dl_state = vram32(frame.dl_state);
+	MEM_W(0, ADDR_D_80204278_PTR) = static_cast<int32_t>(frame.dl_state);
+	if (dl_state != 0) {
+		const gpr m_base = ADD32(dl_state, DISPLAYLIST_OFF_VIEWPROJ_F32);
+		for (int i = 0; i < 16; i++) {
+			write_f32(ADD32(m_base, i * 4), frame.vp_mtx[i]);
+		}
+	}
+	MEM_H(0, ADDR_SCREEN_WIDTH) = frame.screen_w;
+	MEM_H(0, ADDR_SCREEN_HEIGHT) = frame.screen_h;
+	write_f32(ADD32(ADDR_LEVEL_CONFIG, LEVELCFG_OFF_FOV_Y), frame.fov_y);
+	MEM_H(LEVELCFG_OFF_PRIMDEPTH_BIAS, ADDR_LEVEL_CONFIG) = frame.prim_depth_bias;
+}
+
+ReplayResult replay_call(uint8_t* rdram, const CallRecord& call, uint32_t gfx_start) {
+	recomp_context ctx{};
+	ctx.r4 = vram32(call.r4);
+	ctx.r5 = vram32(call.r5);
+	ctx.r6 = vram32(call.r6);
+	ctx.r7 = vram32(call.r7);
+	ctx.r29 = vram32(call.r29);
+	for (int i = 0; i < 6; i++) {
+		MEM_W(0x10 + (i * 4), ctx.r29) = static_cast<int32_t>(call.stack[i]);
+	}
+	MEM_W(0, ctx.r4) = static_cast<int32_t>(gfx_start);
+
+	RewriteTrace trace;
+	RewriteOutcome outcome = RewriteOutcome::InvalidArgs;
+	switch (static_cast<telemetry::Hook>(call.hook)) {
+		case telemetry::Hook::Stars6C5E44:
+			outcome = rewrite_billboard_ortho_quad<Traits6C5E44>(rdram, &ctx, BillboardDynamic{}, &trace);
+			break;
+		case telemetry::Hook::EnergyItems73F17C:
+			outcome = rewrite_billboard_ortho_quad<Traits73F17C>(rdram, &ctx, BillboardDynamic{}, &trace);
+			break;
+		case telemetry::Hook::Flowers73F800:
+			outcome = rewrite_billboard_ortho_quad<Traits73F800>(rdram, &ctx, read_dynamic_73f800(rdram, &ctx), &trace);
+			break;
+		case telemetry::Hook::Collectibles740094:
+			outcome = rewrite_billboard_ortho_quad<Traits740094>(rdram, &ctx, BillboardDynamic{}, &trace);
+			break;
+		case telemetry::Hook::Trees740820:
+			outcome = rewrite_billboard_ortho_quad<Traits740820>(rdram, &ctx, read_dynamic_740820(rdram, &ctx), &trace);
+			break;
+		default:
+			break;
+	}
+
+	ReplayResult result;
+	result.outcome = static_cast<int>(outcome);
+	result.gfx_bytes = static_cast<uint32_t>(MEM_W(0, ctx.r4)) - gfx_start;
+	return result;
+}
+
+int outcome_count() {
+	return static_cast<int>(RewriteOutcome::GfxCapacityFail) + 1;
+}
+
+const char* outcome_name(int outcome) {
+	return rewrite_outcome_name(static_cast<RewriteOutcome>(outcome));
+}
+
+} // namespace sssv::billboard::capture
+
+namespace {
+
+// ── Hook handlers ───────────────────────────────────────────────────────
+// Installed by refresh_hooks() below; each runs only while its settings call for it.
+
+// Camera distance of the object an LOD check is for. The check's first three arguments are
+// the object's world position (16.16, like the billboard hooks' r5-r7); its depth comes from
+// row 2 of the frame's view-projection matrix, as in project_billboard_depth. Objects behind
+// the camera sort last.
+float lod_check_distance(uint8_t* rdram, recomp_context* ctx) {
+	const gpr dl_state = MEM_W(0, ADDR_D_80204278_PTR);
+	if (dl_state == 0) {
+		return std::numeric_limits<float>::infinity();
+	}
+	const gpr row = ADD32(dl_state, DISPLAYLIST_OFF_VIEWPROJ_F32 + (2 * 4 * 4));
+	const float x = static_cast<float>(static_cast<int32_t>(ctx->r4)) / 65536.0f;
+	const float y = static_cast<float>(static_cast<int32_t>(ctx->r5)) / 65536.0f;
+	const float z = static_cast<float>(static_cast<int32_t>(ctx->r6)) / 65536.0f;
+	const float cam_z = read_f32(rdram, ADD32(row, 12)) + (read_f32(rdram, ADD32(row, 8)) * z)
+		+ (read_f32(rdram, ADD32(row, 4)) * y) + (read_f32(rdram, row) * x);
+	return (cam_z <= kBehindCameraZ) ? -cam_z : std::numeric_limits<float>::infinity();
+}
+
+// Installed while the LOD budget or Disable LOD is on.
+void lod_visibility_hook(uint8_t* rdram, recomp_context* ctx) {
+	if (budget::enabled()) {
+		// Adaptive: only the lod_budget() nearest checks are forced to full detail.
+		budget::begin_frame(static_cast<uint32_t>(MEM_W(0, ADDR_D_80204278_PTR)));
+		if (!budget::take_lod(lod_check_distance(rdram, ctx))) return;
+	}
 	// arg3=0 makes func_802E89F0_6FA0A0 take the simple path:
 	// just check area loading via func_8029A334_6AB9E4, skip all FOV/LOD/billboard logic.
 	ctx->r7 = 0;
@@ -1001,35 +2679,32 @@ extern "C" void sssv_hook_lod_visibility(uint8_t* rdram, recomp_context* ctx) {
 	MEM_B(0, (gpr)(int32_t)0x803F2EDD) = 0;
 }
 
-extern "C" void sssv_log_billboard_draw_6fa3a4(uint8_t* rdram, recomp_context* ctx) {
+void count_6fa3a4_hook(uint8_t* rdram, recomp_context* ctx) {
 	s_stats_6fa3a4.interval_calls++;
 	maybe_log_stats(s_stats_6fa3a4);
+	(void)rdram;
+	(void)ctx;
+}
 
-	if (!g_disable_6fa3a4_render) {
-		return;
-	}
-
+void suppress_6fa3a4_hook(uint8_t* rdram, recomp_context* ctx) {
+	count_6fa3a4_hook(rdram, ctx);
 	s_stats_6fa3a4.interval_suppresses++;
 	MEM_W(0, ctx->r29 + 0x10) = 100;
+}
+
+void suppress_6c5e44_hook(uint8_t* rdram, recomp_context* ctx) {
+	MEM_W(0, ctx->r29 + 0x18) = 0;
 	(void)rdram;
 }
 
-extern "C" void sssv_hook_billboard_6c5e44(uint8_t* rdram, recomp_context* ctx) {
-	if (g_disable_6c5e44_render) {
-		MEM_W(0, ctx->r29 + 0x18) = 0;
-		return;
-	}
-	if (!g_rewrite_6c5e44_ortho) {
+void rewrite_6c5e44_hook(uint8_t* rdram, recomp_context* ctx) {
+	sssv::timeline::Span span("billboard_6c5e44");
+	if (!g_rewrite_6c5e44_ortho || !within_rewrite_budget(rdram, telemetry::Hook::Stars6C5E44)) {
 		record_stat_skip(s_stats_6c5e44);
 		return;
 	}
-	BillboardConfig cfg;
-	cfg.hash_salt = 0x6C5E4400u;
-	cfg.scale_clamp_min = 4.0f;
-	cfg.scale_clamp_max = 15.0f;
-	cfg.y_bottom_fixed = 2.0f;
 	RewriteTrace trace;
-	const RewriteOutcome outcome = rewrite_billboard_ortho_quad(rdram, ctx, cfg, &trace);
+	const RewriteOutcome outcome = run_rewrite<Traits6C5E44>(rdram, ctx, BillboardDynamic{}, &trace, telemetry::Hook::Stars6C5E44);
 	const bool suppressed = (outcome == RewriteOutcome::Emitted) && g_rewrite_6c5e44_suppress_original;
 	record_stat(s_stats_6c5e44, outcome, suppressed, &trace);
 	if (suppressed) {
@@ -1037,26 +2712,19 @@ extern "C" void sssv_hook_billboard_6c5e44(uint8_t* rdram, recomp_context* ctx)
 	}
 }
 
-extern "C" void sssv_hook_billboard_73f800(uint8_t* rdram, recomp_context* ctx) {
-	if (g_disable_73f800_render) {
-		MEM_W(0, ctx->r29 + 0x18) = 0;
-		return;
-	}
-	if (!g_rewrite_73f800_ortho) {
+void suppress_73f800_hook(uint8_t* rdram, recomp_context* ctx) {
+	MEM_W(0, ctx->r29 + 0x18) = 0;
+	(void)rdram;
+}
+
+void rewrite_73f800_hook(uint8_t* rdram, recomp_context* ctx) {
+	sssv::timeline::Span span("billboard_73f800");
+	if (!g_rewrite_73f800_ortho || !within_rewrite_budget(rdram, telemetry::Hook::Flowers73F800)) {
 		record_stat_skip(s_stats_73f800);
 		return;
 	}
-	BillboardConfig cfg;
-	cfg.hash_salt = 0x73F80000u;
-	cfg.hash_includes_scale = false;   // Power Cells pulsate scale every frame
-	cfg.hash_coord_shift = 18;         // Quantize coords: 2^18 covers ~4 world-unit Z pulsation
-	const int16_t raw_half_h = static_cast<int16_t>(MEM_W(0x14, ctx->r29));
-	if (raw_half_h > 32) {
-		cfg.geom_half_h = raw_half_h - 32;
-		cfg.y_top_mul = 3.0f;
-	}
 	RewriteTrace trace;
-	const RewriteOutcome outcome = rewrite_billboard_ortho_quad(rdram, ctx, cfg, &trace);
+	const RewriteOutcome outcome = run_rewrite<Traits73F800>(rdram, ctx, read_dynamic_73f800(rdram, ctx), &trace, telemetry::Hook::Flowers73F800);
 	const bool suppressed = (outcome == RewriteOutcome::Emitted) && g_rewrite_73f800_suppress_original;
 	record_stat(s_stats_73f800, outcome, suppressed, &trace);
 	if (suppressed) {
@@ -1064,22 +2732,20 @@ extern "C" void sssv_hook_billboard_73f800(uint8_t* rdram, recomp_context* ctx)
 	}
 }
 
-extern "C" void sssv_hook_billboard_740094(uint8_t* rdram, recomp_context* ctx) {
-	if (g_disable_740094_render) {
-		MEM_W(0, ctx->r29 + 0x18) = 0;
-		MEM_W(0, ctx->r29 + 0x1C) = 0;
-		return;
-	}
-	if (!g_rewrite_740094_ortho) {
+void suppress_740094_hook(uint8_t* rdram, recomp_context* ctx) {
+	MEM_W(0, ctx->r29 + 0x18) = 0;
+	MEM_W(0, ctx->r29 + 0x1C) = 0;
+	(void)rdram;
+}
+
+void rewrite_740094_hook(uint8_t* rdram, recomp_context* ctx) {
+	sssv::timeline::Span span("billboard_740094");
+	if (!g_rewrite_740094_ortho || !within_rewrite_budget(rdram, telemetry::Hook::Collectibles740094)) {
 		record_stat_skip(s_stats_740094);
 		return;
 	}
-	BillboardConfig cfg;
-	cfg.hash_salt = 0x74009400u;
-	cfg.dual_scale = true;
-	cfg.hash_includes_scale = false;
 	RewriteTrace trace;
-	const RewriteOutcome outcome = rewrite_billboard_ortho_quad(rdram, ctx, cfg, &trace);
+	const RewriteOutcome outcome = run_rewrite<Traits740094>(rdram, ctx, BillboardDynamic{}, &trace, telemetry::Hook::Collectibles740094);
 	const bool suppressed = (outcome == RewriteOutcome::Emitted) && g_rewrite_740094_suppress_original;
 	record_stat(s_stats_740094, outcome, suppressed, &trace);
 	if (suppressed) {
@@ -1088,23 +2754,20 @@ extern "C" void sssv_hook_billboard_740094(uint8_t* rdram, recomp_context* ctx)
 	}
 }
 
-extern "C" void sssv_hook_billboard_740820(uint8_t* rdram, recomp_context* ctx) {
-	if (g_disable_740820_render) {
-		MEM_W(0, ctx->r29 + 0x18) = 0;
-		MEM_W(0, ctx->r29 + 0x1C) = 0;
-		return;
-	}
-	if (!g_rewrite_740820_ortho) {
+void suppress_740820_hook(uint8_t* rdram, recomp_context* ctx) {
+	MEM_W(0, ctx->r29 + 0x18) = 0;
+	MEM_W(0, ctx->r29 + 0x1C) = 0;
+	(void)rdram;
+}
+
+void rewrite_740820_hook(uint8_t* rdram, recomp_context* ctx) {
+	sssv::timeline::Span span("billboard_740820");
+	if (!g_rewrite_740820_ortho || !within_rewrite_budget(rdram, telemetry::Hook::Trees740820)) {
 		record_stat_skip(s_stats_740820);
 		return;
 	}
-	BillboardConfig cfg;
-	cfg.hash_salt = 0x74082000u;
-	cfg.dual_scale = true;
-	cfg.screen_wrap = (static_cast<uint8_t>(MEM_W(0x20, ctx->r29)) != 0);
-	cfg.offset_clamp = static_cast<int16_t>(MEM_W(0x24, ctx->r29));
 	RewriteTrace trace;
-	const RewriteOutcome outcome = rewrite_billboard_ortho_quad(rdram, ctx, cfg, &trace);
+	const RewriteOutcome outcome = run_rewrite<Traits740820>(rdram, ctx, read_dynamic_740820(rdram, ctx), &trace, telemetry::Hook::Trees740820);
 	const bool suppressed = (outcome == RewriteOutcome::Emitted) && g_rewrite_740820_suppress_original;
 	record_stat(s_stats_740820, outcome, suppressed, &trace);
 	if (suppressed) {
@@ -1113,20 +2776,20 @@ extern "C" void sssv_hook_billboard_740820(uint8_t* rdram, recomp_context* ctx)
 	}
 }
 
-extern "C" void sssv_log_billboard_draw_73f17c(uint8_t* rdram, recomp_context* ctx) {
-	if (g_disable_73f17c_render) {
-		MEM_W(0, ctx->r29 + 0x18) = 0;
-		return;
-	}
+void suppress_73f17c_hook(uint8_t* rdram, recomp_context* ctx) {
+	MEM_W(0, ctx->r29 + 0x18) = 0;
+	(void)rdram;
+}
 
-	if (!g_rewrite_73f17c_ortho) {
+void rewrite_73f17c_hook(uint8_t* rdram, recomp_context* ctx) {
+	sssv::timeline::Span span("billboard_73f17c");
+	if (!g_rewrite_73f17c_ortho || !within_rewrite_budget(rdram, telemetry::Hook::EnergyItems73F17C)) {
 		record_stat_skip(s_stats_73f17c);
 		return;
 	}
 
-	BillboardConfig cfg_73f17c;
 	RewriteTrace trace;
-	const RewriteOutcome outcome = rewrite_billboard_ortho_quad(rdram, ctx, cfg_73f17c, &trace);
+	const RewriteOutcome outcome = run_rewrite<Traits73F17C>(rdram, ctx, BillboardDynamic{}, &trace, telemetry::Hook::EnergyItems73F17C);
 	const bool suppressed = (outcome == RewriteOutcome::Emitted) && g_rewrite_73f17c_suppress_original;
 	record_stat(s_stats_73f17c, outcome, suppressed, &trace);
 
@@ -1166,3 +2829,64 @@ extern "C" void sssv_log_billboard_draw_73f17c(uint8_t* rdram, recomp_context* c
 		MEM_W(0, ctx->r29 + 0x18) = 0;
 	}
 }
+
+// Off: the suppress handler; rewrite on, or off with stats logging, the full handler
+// (which also counts skips); otherwise nothing.
+sssv::hooks::Handler select_billboard_hook(bool disabled, bool rewrite, sssv::hooks::Handler suppress, sssv::hooks::Handler full) {
+	if (disabled) {
+		return suppress;
+	}
+	return (rewrite || g_log_73f17c_ortho) ? full : nullptr;
+}
+
+} // namespace
+
+namespace sssv::billboard {
+
+void refresh_hooks() {
+	using hooks::Hook;
+	hooks::set_builtin(Hook::LodVisibility, (budget::enabled() || g_disable_lod) ? lod_visibility_hook : nullptr);
+	hooks::set_builtin(Hook::Billboard6FA3A4,
+		g_disable_6fa3a4_render ? suppress_6fa3a4_hook : (g_log_73f17c_ortho ? count_6fa3a4_hook : nullptr));
+	hooks::set_builtin(Hook::Billboard6C5E44,
+		select_billboard_hook(g_disable_6c5e44_render, g_rewrite_6c5e44_ortho, suppress_6c5e44_hook, rewrite_6c5e44_hook));
+	hooks::set_builtin(Hook::Billboard73F17C,
+		select_billboard_hook(g_disable_73f17c_render, g_rewrite_73f17c_ortho, suppress_73f17c_hook, rewrite_73f17c_hook));
+	hooks::set_builtin(Hook::Billboard73F800,
+		select_billboard_hook(g_disable_73f800_render, g_rewrite_73f800_ortho, suppress_73f800_hook, rewrite_73f800_hook));
+	hooks::set_builtin(Hook::Billboard740094,
+		select_billboard_hook(g_disable_740094_render, g_rewrite_740094_ortho, suppress_740094_hook, rewrite_740094_hook));
+	hooks::set_builtin(Hook::Billboard740820,
+		select_billboard_hook(g_disable_740820_render, g_rewrite_740820_ortho, suppress_740820_hook, rewrite_740820_hook));
+}
+
+} // namespace sssv::billboard
+
+// Entry points called by the recompiled code (sssv.us.toml).
+extern "C" void sssv_hook_lod_visibility(uint8_t* rdram, recomp_context* ctx) {
+	sssv::hooks::dispatch(sssv::hooks::Hook::LodVisibility, rdram, ctx);
+}
+
+extern "C" void sssv_log_billboard_draw_6fa3a4(uint8_t* rdram, recomp_context* ctx) {
+	sssv::hooks::dispatch(sssv::hooks::Hook::Billboard6FA3A4, rdram, ctx);
+}
+
+extern "C" void sssv_hook_billboard_6c5e44(uint8_t* rdram, recomp_context* ctx) {
+	sssv::hooks::dispatch(sssv::hooks::Hook::Billboard6C5E44, rdram, ctx);
+}
+
+extern "C" void sssv_log_billboard_draw_73f17c(uint8_t* rdram, recomp_context* ctx) {
+	sssv::hooks::dispatch(sssv::hooks::Hook::Billboard73F17C, rdram, ctx);
+}
+
+extern "C" void sssv_hook_billboard_73f800(uint8_t* rdram, recomp_context* ctx) {
+	sssv::hooks::dispatch(sssv::hooks::Hook::Billboard73F800, rdram, ctx);
+}
+
+extern "C" void sssv_hook_billboard_740094(uint8_t* rdram, recomp_context* ctx) {
+	sssv::hooks::dispatch(sssv::hooks::Hook::Billboard740094, rdram, ctx);
+}
+
+extern "C" void sssv_hook_billboard_740820(uint8_t* rdram, recomp_context* ctx) {
+	sssv::hooks::dispatch(sssv::hooks::Hook::Billboard740820, rdram, ctx);
+}
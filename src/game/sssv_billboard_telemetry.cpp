@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+
+#include "sssv_billboard_telemetry.h"
+
+namespace sssv::billboard::telemetry {
+
+#if SSSV_BILLBOARD_TELEMETRY
+
+std::atomic<bool> g_enabled{ false };
+
+namespace {
+
+const char* const kHookNames[kHookCount] = {
+	"6c5e44",
+	"73f17c",
+	"73f800",
+	"740094",
+	"740820",
+};
+
+// Frame currently being accumulated. Only touched by the game thread.
+FrameRecord s_current;
+bool s_has_current = false;
+
+// Completed frames. Guarded by s_ring_mutex, which the game thread only takes once per frame.
+std::mutex s_ring_mutex;
+FrameRecord s_ring[kRingFrames];
+size_t s_ring_head = 0;   // next write index
+size_t s_ring_count = 0;
+
+std::atomic<bool> s_reset_pending{ false };
+
+int time_bucket(uint64_t elapsed_ns) {
+	const uint64_t us = elapsed_ns / 1000;
+	int bucket = 0;
+	for (uint64_t limit = 1; (bucket < (kTimeBuckets - 1)) && (us >= limit); limit <<= 1) {
+		bucket++;
+	}
+	return bucket;
+}
+
+void commit_current_locked() {
+	if (!s_has_current) {
+		return;
+	}
+	s_ring[s_ring_head] = s_current;
+	s_ring_head = (s_ring_head + 1) % kRingFrames;
+	s_ring_count = std::min(s_ring_count + 1, kRingFrames);
+}
+
+void roll_frame(uint64_t frame) {
+	{
+		std::lock_guard<std::mutex> lock(s_ring_mutex);
+		if (s_reset_pending.exchange(false)) {
+			s_ring_head = 0;
+			s_ring_count = 0;
+		} else {
+			commit_current_locked();
+		}
+	}
+	s_current = FrameRecord{};
+	s_current.frame = frame;
+	s_has_current = true;
+}
+
+} // namespace
+
+void set_enabled(bool enabled) {
+	if (enabled && !g_enabled.load()) {
+		s_reset_pending.store(true);
+	}
+	g_enabled.store(enabled);
+}
+
+uint64_t now_ns() {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void record_call(Hook hook, bool emitted, uint64_t elapsed_ns, int32_t pool_used_slots, uint64_t frame) {
+	if (!s_has_current || (s_current.frame != frame) || s_reset_pending.load(std::memory_order_relaxed)) {
+		roll_frame(frame);
+	}
+
+	HookCounters& counters = s_current.hooks[static_cast<int>(hook)];
+	counters.calls++;
+	if (emitted) {
+		counters.emits++;
+	} else {
+		counters.fails++;
+	}
+
+	s_current.time_hist[time_bucket(elapsed_ns)]++;
+	s_current.rewrite_ns += elapsed_ns;
+	s_current.max_call_ns = std::max(s_current.max_call_ns, static_cast<uint32_t>(std::min<uint64_t>(elapsed_ns, UINT32_MAX)));
+	s_current.pool_high_water = std::max(s_current.pool_high_water, pool_used_slots);
+}
+
+size_t snapshot(FrameRecord* out, size_t max_frames) {
+	std::lock_guard<std::mutex> lock(s_ring_mutex);
+	const size_t count = std::min(max_frames, s_ring_count);
+	const size_t first = (s_ring_head + kRingFrames - count) % kRingFrames;
+	for (size_t i = 0; i < count; i++) {
+		out[i] = s_ring[(first + i) % kRingFrames];
+	}
+	return count;
+}
+
+bool dump_csv(const std::filesystem::path& path) {
+	static FrameRecord s_frames[kRingFrames];
+	const size_t count = snapshot(s_frames, kRingFrames);
+	if (count == 0) {
+		return false;
+	}
+
+	std::ofstream out(path, std::ios::trunc);
+	if (!out.is_open()) {
+		std::printf("[BILLBOARD TELEMETRY] failed to write %s\n", path.string().c_str());
+		std::fflush(stdout);
+		return false;
+	}
+
+	out << "frame";
+	for (const char* name : kHookNames) {
+		out << ',' << name << "_calls," << name << "_emits," << name << "_fails";
+	}
+	out << ",rewrite_us,max_call_us";
+	for (int b = 0; b < kTimeBuckets; b++) {
+		if (b == (kTimeBuckets - 1)) {
+			out << ",hist_ge" << (1u << (b - 1)) << "us";
+		} else {
+			out << ",hist_lt" << (1u << b) << "us";
+		}
+	}
+	out << ",pool_high_water\n";
+
+	uint64_t worst_ns = 0;
+	int32_t pool_peak = 0;
+	for (size_t i = 0; i < count; i++) {
+		const FrameRecord& r = s_frames[i];
+		out << r.frame;
+		for (const HookCounters& h : r.hooks) {
+			out << ',' << h.calls << ',' << h.emits << ',' << h.fails;
+		}
+		out << ',' << (static_cast<double>(r.rewrite_ns) / 1000.0)
+		    << ',' << (static_cast<double>(r.max_call_ns) / 1000.0);
+		for (uint32_t bucket : r.time_hist) {
+			out << ',' << bucket;
+		}
+		out << ',' << r.pool_high_water << '\n';
+		worst_ns = std::max(worst_ns, r.rewrite_ns);
+		pool_peak = std::max(pool_peak, r.pool_high_water);
+	}
+
+	out.close();
+	if (out.fail()) {
+		std::printf("[BILLBOARD TELEMETRY] failed to write %s\n", path.string().c_str());
+		std::fflush(stdout);
+		return false;
+	}
+
+	std::printf("[BILLBOARD TELEMETRY] wrote %zu frames to %s (worst frame %.1f us, pool peak %d)\n",
+		count, path.string().c_str(), static_cast<double>(worst_ns) / 1000.0, pool_peak);
+	std::fflush(stdout);
+	return true;
+}
+
+#else
+
+void set_enabled(bool) {}
+uint64_t now_ns() { return 0; }
+void record_call(Hook, bool, uint64_t, int32_t, uint64_t) {}
+size_t snapshot(FrameRecord*, size_t) { return 0; }
+bool dump_csv(const std::filesystem::path&) { return false; }
+
+#endif
+
+} // namespace sssv::billboard::telemetry
@@ -0,0 +1,115 @@
+#include <mutex>
+#include <utility>
+
+#include "sssv_hooks.h"
+
+namespace sssv::hooks {
+
+void noop(uint8_t* rdram, recomp_context* ctx) {
+	(void)rdram;
+	(void)ctx;
+}
+
+std::array<std::atomic<Handler>, kHookCount> g_active = {
+	noop, noop, noop, noop, noop, noop, noop, noop,
+};
+static_assert(kHookCount == 8, "g_active needs an initializer per hook");
+
+namespace {
+
+struct Slot {
+	Handler builtin = nullptr;
+	Handler override = nullptr;
+};
+
+constexpr std::array<std::string_view, kHookCount> kNames = {
+	"patch_trophy_collision_guard",
+	"hook_lod_visibility",
+	"hook_billboard_6c5e44",
+	"log_billboard_draw_6fa3a4",
+	"log_billboard_draw_73f17c",
+	"hook_billboard_73f800",
+	"hook_billboard_740094",
+	"hook_billboard_740820",
+};
+
+std::mutex s_mutex;
+std::array<Slot, kHookCount> s_slots;
+
+std::array<std::atomic<recomp_func_t*>, kHookCount> s_mod_funcs{};
+
+// Runs a mod override on a copy of ctx and returns only the argument registers (sssv_hooks.h).
+template <size_t Index>
+void mod_trampoline(uint8_t* rdram, recomp_context* ctx) {
+	recomp_func_t* func = s_mod_funcs[Index].load(std::memory_order_acquire);
+	if (func == nullptr) {
+		return;
+	}
+	recomp_context mod_ctx = *ctx;
+	func(rdram, &mod_ctx);
+	ctx->r4 = mod_ctx.r4;
+	ctx->r5 = mod_ctx.r5;
+	ctx->r6 = mod_ctx.r6;
+	ctx->r7 = mod_ctx.r7;
+}
+
+template <size_t... Indices>
+constexpr std::array<Handler, kHookCount> make_mod_trampolines(std::index_sequence<Indices...>) {
+	return { mod_trampoline<Indices>... };
+}
+
+constexpr std::array<Handler, kHookCount> kModTrampolines = make_mod_trampolines(std::make_index_sequence<kHookCount>{});
+
+void publish(Hook hook) {
+	const Slot& slot = s_slots[static_cast<size_t>(hook)];
+	Handler handler = slot.override != nullptr ? slot.override : slot.builtin;
+	g_active[static_cast<size_t>(hook)].store(handler != nullptr ? handler : noop, std::memory_order_release);
+}
+
+} // namespace
+
+void set_builtin(Hook hook, Handler handler) {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	s_slots[static_cast<size_t>(hook)].builtin = handler;
+	publish(hook);
+}
+
+Handler get_builtin(Hook hook) {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	Handler handler = s_slots[static_cast<size_t>(hook)].builtin;
+	return handler != nullptr ? handler : noop;
+}
+
+void set_override(Hook hook, Handler handler) {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	s_slots[static_cast<size_t>(hook)].override = handler;
+	publish(hook);
+}
+
+void set_mod_override(Hook hook, recomp_func_t* func) {
+	std::lock_guard<std::mutex> lock(s_mutex);
+	s_mod_funcs[static_cast<size_t>(hook)].store(func, std::memory_order_release);
+	s_slots[static_cast<size_t>(hook)].override = func != nullptr ? kModTrampolines[static_cast<size_t>(hook)] : nullptr;
+	publish(hook);
+}
+
+bool find(std::string_view name, Hook& out) {
+	for (size_t i = 0; i < kHookCount; i++) {
+		if (kNames[i] == name) {
+			out = static_cast<Hook>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace sssv::hooks
+
+extern "C" bool sssv_set_hook_override(const char* name, sssv::hooks::Handler handler) {
+	sssv::hooks::Hook hook;
+	if ((name == nullptr) || !sssv::hooks::find(name, hook)) {
+		return false;
+	}
+	sssv::hooks::set_override(hook, handler);
+	return true;
+}
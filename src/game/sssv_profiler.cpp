@@ -0,0 +1,367 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#include <Windows.h>
+#else
+	#include <pthread.h>
+	#include <signal.h>
+#endif
+
+#include "sssv_game.h"
+#include "sssv_profiler.h"
+
+namespace sssv::profiler {
+
+namespace {
+
+constexpr auto kSampleInterval = std::chrono::microseconds(1000);
+// A sample this far past the nearest preceding function start is not in recompiled code.
+constexpr uintptr_t kMaxFunctionBytes = 1 << 20;
+constexpr size_t kHotFunctionCount = 64;
+constexpr size_t kLogTopCount = 15;
+
+// ── Game threads ────────────────────────────────────────────────────────
+
+#if defined(_WIN32)
+using ThreadHandle = HANDLE;
+#else
+using ThreadHandle = pthread_t;
+#endif
+
+std::mutex s_threads_mutex;
+std::vector<ThreadHandle> s_threads;
+
+// Removes the thread from the sample list when it exits, so the sampler never signals a
+// thread that is gone. The sampler holds s_threads_mutex while it interrupts a thread.
+struct Registration {
+	ThreadHandle handle{};
+	bool registered = false;
+
+	~Registration() {
+		if (!registered) {
+			return;
+		}
+		std::lock_guard<std::mutex> lock(s_threads_mutex);
+		s_threads.erase(std::remove(s_threads.begin(), s_threads.end(), handle), s_threads.end());
+#if defined(_WIN32)
+		CloseHandle(handle);
+#endif
+	}
+};
+
+thread_local Registration t_registration;
+
+// ── Sampling ────────────────────────────────────────────────────────────
+
+#if !defined(_WIN32)
+// Each interrupt is a numbered request for one thread. The handler answers in the request's
+// own slot, so a handler that runs after its request timed out never passes for a later one:
+// it either reads a newer number meant for another thread and does nothing, or writes its
+// old number into a slot the sampler is no longer waiting on.
+constexpr size_t kSignalSlots = 16;
+
+struct SignalSlot {
+	std::atomic<uint64_t> sequence{ 0 };
+	std::atomic<uintptr_t> ip{ 0 };
+};
+
+std::atomic<uint64_t> s_signal_request{ 0 };
+std::atomic<pthread_t> s_signal_target{};
+SignalSlot s_signal_slots[kSignalSlots];
+// Installed on the first start() and never removed: a SIGPROF that was still pending when
+// sample_thread gave up can arrive after stop(), and under SIG_DFL it would kill the process.
+// Late signals are harmless to on_sample_signal.
+bool s_handler_installed = false;
+
+uintptr_t context_ip(void* context) {
+	const ucontext_t* uc = static_cast<const ucontext_t*>(context);
+#if defined(__APPLE__) && (defined(__aarch64__) || defined(__arm64__))
+	return static_cast<uintptr_t>(uc->uc_mcontext->__ss.__pc);
+#elif defined(__APPLE__)
+	return static_cast<uintptr_t>(uc->uc_mcontext->__ss.__rip);
+#elif defined(__x86_64__)
+	return static_cast<uintptr_t>(uc->uc_mcontext.gregs[REG_RIP]);
+#elif defined(__aarch64__)
+	return static_cast<uintptr_t>(uc->uc_mcontext.pc);
+#else
+	(void)uc;
+	return 0;
+#endif
+}
+
+void on_sample_signal(int, siginfo_t*, void* context) {
+	const uint64_t sequence = s_signal_request.load(std::memory_order_acquire);
+	if (!pthread_equal(s_signal_target.load(std::memory_order_relaxed), pthread_self())) {
+		return;
+	}
+	SignalSlot& slot = s_signal_slots[sequence % kSignalSlots];
+	slot.ip.store(context_ip(context), std::memory_order_relaxed);
+	slot.sequence.store(sequence, std::memory_order_release);
+}
+#endif
+
+// Interrupts the thread and returns where it was, or 0.
+uintptr_t sample_thread(ThreadHandle thread) {
+#if defined(_WIN32)
+	if (SuspendThread(thread) == (DWORD)-1) {
+		return 0;
+	}
+	CONTEXT context{};
+	context.ContextFlags = CONTEXT_CONTROL;
+	uintptr_t ip = 0;
+	if (GetThreadContext(thread, &context)) {
+#if defined(_M_ARM64)
+		ip = static_cast<uintptr_t>(context.Pc);
+#else
+		ip = static_cast<uintptr_t>(context.Rip);
+#endif
+	}
+	ResumeThread(thread);
+	return ip;
+#else
+	const uint64_t sequence = s_signal_request.load(std::memory_order_relaxed) + 1;
+	SignalSlot& slot = s_signal_slots[sequence % kSignalSlots];
+	s_signal_target.store(thread, std::memory_order_relaxed);
+	s_signal_request.store(sequence, std::memory_order_release);
+	if (pthread_kill(thread, SIGPROF) != 0) {
+		return 0;
+	}
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(2);
+	while (slot.sequence.load(std::memory_order_acquire) != sequence) {
+		if (std::chrono::steady_clock::now() > deadline) {
+			return 0;
+		}
+		std::this_thread::yield();
+	}
+	const uintptr_t ip = slot.ip.load(std::memory_order_relaxed);
+	// A handler from kSignalSlots requests ago may have overwritten the ip since.
+	return slot.sequence.load(std::memory_order_acquire) == sequence ? ip : 0;
+#endif
+}
+
+std::vector<RecompiledFunction> s_functions; // sorted by host address
+std::vector<uint64_t> s_counts;              // per entry of s_functions
+uint64_t s_outside = 0;
+uint64_t s_missed = 0;
+
+std::atomic<bool> s_running{ false };
+std::thread s_sampler;
+
+// Index into s_functions, or -1 when ip is not in recompiled code.
+ptrdiff_t find_function(uintptr_t ip) {
+	auto it = std::upper_bound(s_functions.begin(), s_functions.end(), ip,
+		[](uintptr_t addr, const RecompiledFunction& f) { return addr < reinterpret_cast<uintptr_t>(f.host); });
+	if (it == s_functions.begin()) {
+		return -1;
+	}
+	--it;
+	if ((ip - reinterpret_cast<uintptr_t>(it->host)) >= kMaxFunctionBytes) {
+		return -1;
+	}
+	return it - s_functions.begin();
+}
+
+void sampler_main() {
+	auto next = std::chrono::steady_clock::now();
+	while (s_running.load(std::memory_order_relaxed)) {
+		{
+			std::lock_guard<std::mutex> lock(s_threads_mutex);
+			for (ThreadHandle thread : s_threads) {
+				const uintptr_t ip = sample_thread(thread);
+				if (ip == 0) {
+					s_missed++;
+					continue;
+				}
+				const ptrdiff_t index = find_function(ip);
+				if (index < 0) {
+					s_outside++;
+				} else {
+					s_counts[index]++;
+				}
+			}
+		}
+		next += kSampleInterval;
+		std::this_thread::sleep_until(next);
+	}
+}
+
+// ── Output ──────────────────────────────────────────────────────────────
+
+// Function names by ROM address from an N64Recomp symbol file. Only the fields needed are
+// read: each [[section]]'s rom and vram, and the name and vram of its function entries.
+std::unordered_map<uint32_t, std::string> load_symbol_names(const std::filesystem::path& path) {
+	std::unordered_map<uint32_t, std::string> names;
+	std::ifstream stream(path);
+	std::string line;
+	uint32_t section_rom = 0;
+	uint32_t section_vram = 0;
+	const auto hex_after = [](const std::string& text, size_t key) -> uint32_t {
+		const size_t eq = text.find('=', key);
+		return (eq == std::string::npos) ? 0 : static_cast<uint32_t>(std::strtoul(text.c_str() + eq + 1, nullptr, 0));
+	};
+	while (std::getline(stream, line)) {
+		const size_t first = line.find_first_not_of(" \t");
+		if (first == std::string::npos) {
+			continue;
+		}
+		if (line.compare(first, 4, "rom ") == 0) {
+			section_rom = hex_after(line, first);
+		} else if (line.compare(first, 5, "vram ") == 0) {
+			section_vram = hex_after(line, first);
+		} else if (line[first] == '{') {
+			const size_t name_key = line.find("name", first);
+			const size_t vram_key = line.find("vram", first);
+			const size_t open = line.find('"', name_key);
+			const size_t close = (open == std::string::npos) ? open : line.find('"', open + 1);
+			if ((name_key == std::string::npos) || (vram_key == std::string::npos) || (close == std::string::npos)) {
+				continue;
+			}
+			const uint32_t vram = hex_after(line, vram_key);
+			names[section_rom + (vram - section_vram)] = line.substr(open + 1, close - open - 1);
+		}
+	}
+	return names;
+}
+
+void write_results(const std::filesystem::path& output_folder, const std::filesystem::path& symbols_folder) {
+	std::unordered_map<uint32_t, std::string> names;
+	for (const std::filesystem::path& folder : { output_folder, symbols_folder }) {
+		std::error_code ec;
+		if (std::filesystem::exists(folder / "sssv.us.syms.toml", ec)) {
+			names = load_symbol_names(folder / "sssv.us.syms.toml");
+			break;
+		}
+	}
+	const auto name_of = [&](const RecompiledFunction& f) {
+		auto it = names.find(f.rom);
+		if (it != names.end()) {
+			return it->second;
+		}
+		char buf[32];
+		std::snprintf(buf, sizeof(buf), "func_%08X", f.vram);
+		return std::string(buf);
+	};
+
+	std::vector<size_t> order;
+	uint64_t game_samples = 0;
+	std::unordered_map<uint32_t, uint64_t> section_counts;
+	for (size_t i = 0; i < s_functions.size(); i++) {
+		if (s_counts[i] != 0) {
+			order.push_back(i);
+			game_samples += s_counts[i];
+			section_counts[s_functions[i].section_rom] += s_counts[i];
+		}
+	}
+	std::sort(order.begin(), order.end(), [](size_t a, size_t b) { return s_counts[a] > s_counts[b]; });
+
+	const std::filesystem::path folded_path = output_folder / "profile.folded";
+	if (std::FILE* f = std::fopen(folded_path.string().c_str(), "w")) {
+		for (size_t i : order) {
+			std::fprintf(f, "rom_%06X;%s %llu\n", s_functions[i].section_rom, name_of(s_functions[i]).c_str(), (unsigned long long)s_counts[i]);
+		}
+		if (s_outside != 0) {
+			std::fprintf(f, "outside_game_code %llu\n", (unsigned long long)s_outside);
+		}
+		std::fclose(f);
+	}
+
+	const std::filesystem::path hot_path = output_folder / "hot_funcs.txt";
+	if (std::FILE* f = std::fopen(hot_path.string().c_str(), "w")) {
+		std::fprintf(f, "# Hottest recompiled functions from the last profile, one ROM address per line.\n");
+		for (size_t n = 0; n < std::min(order.size(), kHotFunctionCount); n++) {
+			const RecompiledFunction& func = s_functions[order[n]];
+			std::fprintf(f, "%08X # %s, vram 0x%08X, %llu samples\n", func.rom, name_of(func).c_str(), func.vram, (unsigned long long)s_counts[order[n]]);
+		}
+		std::fclose(f);
+	}
+
+	const uint64_t total = game_samples + s_outside;
+	std::printf("[PROFILER] %llu samples: %llu in game code, %llu outside, %llu missed. Wrote %s\n",
+		(unsigned long long)total, (unsigned long long)game_samples, (unsigned long long)s_outside,
+		(unsigned long long)s_missed, folded_path.string().c_str());
+	for (size_t n = 0; n < std::min(order.size(), kLogTopCount); n++) {
+		const RecompiledFunction& func = s_functions[order[n]];
+		std::printf("[PROFILER]   %5.1f%%  %-40s vram 0x%08X section rom 0x%06X\n",
+			100.0 * s_counts[order[n]] / total, name_of(func).c_str(), func.vram, func.section_rom);
+	}
+	std::vector<std::pair<uint32_t, uint64_t>> sections(section_counts.begin(), section_counts.end());
+	std::sort(sections.begin(), sections.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+	for (size_t n = 0; n < std::min<size_t>(sections.size(), 5); n++) {
+		std::printf("[PROFILER]   %5.1f%%  section rom 0x%06X\n", 100.0 * sections[n].second / total, sections[n].first);
+	}
+	std::fflush(stdout);
+}
+
+} // namespace
+
+void register_current_thread() {
+	if (t_registration.registered) {
+		return;
+	}
+#if defined(_WIN32)
+	t_registration.handle = OpenThread(THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION, FALSE, GetCurrentThreadId());
+	if (t_registration.handle == nullptr) {
+		return;
+	}
+#else
+	t_registration.handle = pthread_self();
+#endif
+	t_registration.registered = true;
+	std::lock_guard<std::mutex> lock(s_threads_mutex);
+	s_threads.push_back(t_registration.handle);
+}
+
+void start() {
+	if (s_running.load()) {
+		return;
+	}
+	s_functions = get_recompiled_functions();
+	std::sort(s_functions.begin(), s_functions.end(),
+		[](const RecompiledFunction& a, const RecompiledFunction& b) { return a.host < b.host; });
+	s_counts.assign(s_functions.size(), 0);
+	s_outside = 0;
+	s_missed = 0;
+
+#if !defined(_WIN32)
+	if (!s_handler_installed) {
+		struct sigaction action{};
+		action.sa_sigaction = on_sample_signal;
+		action.sa_flags = SA_SIGINFO | SA_RESTART;
+		sigemptyset(&action.sa_mask);
+		sigaction(SIGPROF, &action, nullptr);
+		s_handler_installed = true;
+	}
+#endif
+
+	size_t thread_count = 0;
+	{
+		std::lock_guard<std::mutex> lock(s_threads_mutex);
+		thread_count = s_threads.size();
+	}
+	s_running.store(true);
+	s_sampler = std::thread(sampler_main);
+	std::printf("[PROFILER] sampling %zu game threads every %lld us\n", thread_count, (long long)kSampleInterval.count());
+	std::fflush(stdout);
+}
+
+void stop(const std::filesystem::path& output_folder, const std::filesystem::path& symbols_folder) {
+	if (!s_running.exchange(false)) {
+		return;
+	}
+	s_sampler.join();
+	write_results(output_folder, symbols_folder);
+}
+
+} // namespace sssv::profiler
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "sssv_timeline.h"
+
+namespace sssv::timeline {
+
+std::atomic<bool> g_enabled{ false };
+
+namespace {
+
+// About a minute of spans per thread at a few hundred spans a second; older ones are overwritten.
+constexpr size_t kEventsPerThread = 1 << 16;
+// Spans still open when stop() runs record after it, each into the ring's next slot, which
+// once the ring has wrapped is its oldest event. stop() leaves this many of the oldest slots
+// unread, far more than spans ever nest.
+constexpr size_t kStopSlack = 64;
+
+struct Event {
+	const char* name;
+	uint64_t begin_ns;
+	uint64_t end_ns;
+};
+
+// Written only by its thread. count is published with release after each event, so stop()
+// can read every event below it. Buffers are never freed, so a thread that exits mid-trace
+// still shows up.
+struct ThreadBuffer {
+	uint32_t tid = 0;
+	std::string name;
+	std::atomic<uint64_t> count{ 0 };
+	std::array<Event, kEventsPerThread> events;
+};
+
+std::mutex s_buffers_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> s_buffers;
+uint64_t s_start_ns = 0;
+
+thread_local ThreadBuffer* t_buffer = nullptr;
+thread_local std::string t_name;
+
+ThreadBuffer* current_buffer() {
+	if (t_buffer == nullptr) {
+		auto buffer = std::make_unique<ThreadBuffer>();
+		std::lock_guard<std::mutex> lock(s_buffers_mutex);
+		buffer->tid = static_cast<uint32_t>(s_buffers.size() + 1);
+		buffer->name = t_name.empty() ? ("Thread " + std::to_string(buffer->tid)) : t_name;
+		t_buffer = buffer.get();
+		s_buffers.push_back(std::move(buffer));
+	}
+	return t_buffer;
+}
+
+void write_json_string(std::FILE* f, const char* text) {
+	std::fputc('"', f);
+	for (const char* c = text; *c != '\0'; c++) {
+		if ((*c == '"') || (*c == '\\')) {
+			std::fputc('\\', f);
+		}
+		std::fputc(*c, f);
+	}
+	std::fputc('"', f);
+}
+
+} // namespace
+
+void record(const char* name, uint64_t begin_ns, uint64_t end_ns) {
+	ThreadBuffer* buffer = current_buffer();
+	const uint64_t index = buffer->count.load(std::memory_order_relaxed);
+	buffer->events[index % kEventsPerThread] = { name, begin_ns, end_ns };
+	buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void name_current_thread(const std::string& name) {
+	t_name = name;
+	if (t_buffer != nullptr) {
+		std::lock_guard<std::mutex> lock(s_buffers_mutex);
+		t_buffer->name = name;
+	}
+}
+
+void start() {
+	std::lock_guard<std::mutex> lock(s_buffers_mutex);
+	s_start_ns = now_ns();
+	g_enabled.store(true);
+	std::printf("[TIMELINE] tracing\n");
+	std::fflush(stdout);
+}
+
+bool stop(const std::filesystem::path& path) {
+	if (!g_enabled.exchange(false)) {
+		return true;
+	}
+	std::lock_guard<std::mutex> lock(s_buffers_mutex);
+	std::FILE* f = std::fopen(path.string().c_str(), "w");
+	if (f == nullptr) {
+		std::printf("[TIMELINE] failed to open %s\n", path.string().c_str());
+		std::fflush(stdout);
+		return false;
+	}
+
+	// Spans still open on other threads may land after this snapshot; they are left out.
+	uint64_t written = 0;
+	std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	std::fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"SSSV\"}}");
+	for (const std::unique_ptr<ThreadBuffer>& buffer : s_buffers) {
+		std::fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", buffer->tid);
+		write_json_string(f, buffer->name.c_str());
+		std::fprintf(f, "}}");
+
+		const uint64_t count = buffer->count.load(std::memory_order_acquire);
+		const uint64_t readable = kEventsPerThread - kStopSlack;
+		const uint64_t first = (count > readable) ? (count - readable) : 0;
+		for (uint64_t i = first; i < count; i++) {
+			const Event& event = buffer->events[i % kEventsPerThread];
+			if (event.begin_ns < s_start_ns) {
+				continue;
+			}
+			std::fprintf(f, ",\n{\"name\":");
+			write_json_string(f, event.name);
+			std::fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", buffer->tid,
+				(event.begin_ns - s_start_ns) / 1000.0, (event.end_ns - event.begin_ns) / 1000.0);
+			written++;
+		}
+	}
+	std::fprintf(f, "\n]}\n");
+	std::fclose(f);
+
+	std::printf("[TIMELINE] wrote %llu spans from %zu threads to %s\n",
+		(unsigned long long)written, s_buffers.size(), path.string().c_str());
+	std::fflush(stdout);
+	return true;
+}
+
+} // namespace sssv::timeline
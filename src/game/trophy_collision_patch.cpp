@@ -1,6 +1,8 @@
 #include <cstdint>
 
 #include "recomp.h"
+#include "sssv_game.h"
+#include "sssv_hooks.h"
 
 namespace {
 constexpr gpr vram32(uint32_t v) {
@@ -9,9 +11,8 @@ constexpr gpr vram32(uint32_t v) {
 
 constexpr gpr ADDR_FBM_TROPHY_HITBOX_SIZE = vram32(0x803AD3F3);
 constexpr uint8_t FBM_TROPHY_HITBOX_FIXED_VALUE = 0x15;
-}
 
-extern "C" void sssv_patch_trophy_collision_guard(uint8_t* rdram, recomp_context* ctx) {
+void trophy_collision_guard(uint8_t* rdram, recomp_context* ctx) {
     if (MEM_BU(ADDR_FBM_TROPHY_HITBOX_SIZE, 0) != FBM_TROPHY_HITBOX_FIXED_VALUE) {
         MEM_B(ADDR_FBM_TROPHY_HITBOX_SIZE, 0) = FBM_TROPHY_HITBOX_FIXED_VALUE;
     }
@@ -19,3 +20,12 @@ extern "C" void sssv_patch_trophy_collision_guard(uint8_t* rdram, recomp_context
     (void)ctx;
     (void)rdram;
 }
+}
+
+void sssv::register_trophy_collision_patch() {
+    sssv::hooks::set_builtin(sssv::hooks::Hook::TrophyCollisionGuard, trophy_collision_guard);
+}
+
+extern "C" void sssv_patch_trophy_collision_guard(uint8_t* rdram, recomp_context* ctx) {
+    sssv::hooks::dispatch(sssv::hooks::Hook::TrophyCollisionGuard, rdram, ctx);
+}
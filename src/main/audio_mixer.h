@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+#include "audio_ring.h"
+
+namespace sssv::audio_output {
+    // Sums several SampleRing sources into one device callback, each with its own gain. A gain
+    // change is ramped over the requested number of frames on the audio thread, so one source
+    // can fade out under another on the same device instead of closing a device of its own.
+    class Mixer {
+    public:
+        static constexpr size_t max_sources = 4;
+
+        // One source per ring, in order, all at unity gain.
+        Mixer(size_t channels, std::initializer_list<SampleRing*> rings) : channels_(channels) {
+            for (SampleRing* ring : rings) {
+                sources_[source_count_++].ring = ring;
+            }
+        }
+
+        // Any thread. fade_frames == 0 applies the gain from the next callback.
+        void set_gain(size_t index, float gain, size_t fade_frames) {
+            Source& source = sources_[index];
+            source.rate.store(fade_frames == 0 ? 0.0f : 1.0f / static_cast<float>(fade_frames), std::memory_order_relaxed);
+            source.target.store(gain, std::memory_order_release);
+        }
+
+        // Device callback. Fills count samples and returns a bit per source that ran dry.
+        uint32_t mix(float* out, size_t count) {
+            std::fill(out, out + count, 0.0f);
+            uint32_t short_sources = 0;
+            for (size_t s = 0; s < source_count_; s++) {
+                Source& source = sources_[s];
+                const float target = source.target.load(std::memory_order_acquire);
+                const float rate = source.rate.load(std::memory_order_relaxed);
+                size_t done = 0;
+                while (done < count) {
+                    const size_t block = std::min(count - done, scratch_.size() - scratch_.size() % channels_);
+                    const size_t read = source.ring->read(scratch_.data(), block);
+                    accumulate(source, target, rate, out + done, read);
+                    done += read;
+                    if (read < block) {
+                        short_sources |= 1u << s;
+                        break;
+                    }
+                }
+            }
+            return short_sources;
+        }
+
+    private:
+        struct Source {
+            SampleRing* ring = nullptr;
+            float gain = 1.0f; // audio thread only
+            std::atomic<float> target{ 1.0f };
+            std::atomic<float> rate{ 0.0f };
+        };
+
+        void accumulate(Source& source, float target, float rate, float* out, size_t count) {
+            float gain = source.gain;
+            if ((gain == target) || (rate == 0.0f)) {
+                gain = target;
+                if (gain != 0.0f) {
+                    for (size_t i = 0; i < count; i++) {
+                        out[i] += scratch_[i] * gain;
+                    }
+                }
+            } else {
+                for (size_t i = 0; i < count; i += channels_) {
+                    gain = (gain < target) ? std::min(gain + rate, target) : std::max(gain - rate, target);
+                    for (size_t c = 0; c < channels_; c++) {
+                        out[i + c] += scratch_[i + c] * gain;
+                    }
+                }
+            }
+            source.gain = gain;
+        }
+
+        const size_t channels_;
+        std::array<Source, max_sources> sources_;
+        size_t source_count_ = 0;
+        std::array<float, 2048> scratch_{};
+    };
+} // namespace sssv::audio_output
@@ -0,0 +1,213 @@
+#include "audio_output.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE4_1__)
+    #include <smmintrin.h>
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+#endif
+
+namespace sssv::audio_output {
+
+namespace {
+
+constexpr size_t taps = 8;
+constexpr size_t taps_before = taps / 2 - 1; // input frames before the output position
+constexpr uint32_t phase_bits = 8;
+constexpr size_t phase_count = size_t(1) << phase_bits;
+constexpr size_t channels = 2;
+
+// Filter taps per phase, each duplicated for both channels to match interleaved frames.
+alignas(16) float filter[phase_count][taps * channels];
+
+// Filter history (the last frames of the previous buffer) followed by the current buffer.
+alignas(16) float staging[(taps + max_input_frames) * channels];
+size_t staged_frames = 0;
+
+std::vector<float> output;
+
+// Input position relative to staging[0] in 32.32 fixed point, and its step per output frame.
+uint64_t position = 0;
+uint64_t step = uint64_t(1) << 32;
+uint64_t nominal_step = uint64_t(1) << 32;
+uint32_t output_frame_rate = 48000;
+
+// Set from the config thread. The controller state below belongs to the audio thread, which
+// resets it when it sees the setting change.
+std::atomic<bool> rate_control = false;
+std::atomic<uint32_t> target_latency = default_target_latency_ms;
+bool rate_control_applied = false;
+double smoothed_error = 0.0;
+double integrated_adjust = 0.0;
+
+void build_filter(double cutoff) {
+    const double pi = 3.14159265358979323846;
+    const double half_width = double(taps) / 2.0;
+    for (size_t p = 0; p < phase_count; p++) {
+        const double frac = double(p) / double(phase_count);
+        double h[taps];
+        double sum = 0.0;
+        for (size_t k = 0; k < taps; k++) {
+            const double x = double(k) - double(taps_before) - frac;
+            const double sinc = (x == 0.0) ? 1.0 : std::sin(pi * cutoff * x) / (pi * cutoff * x);
+            // Blackman window over the filter's span.
+            const double w = 0.42 + 0.5 * std::cos(pi * x / half_width) + 0.08 * std::cos(2.0 * pi * x / half_width);
+            h[k] = sinc * std::max(w, 0.0);
+            sum += h[k];
+        }
+        for (size_t k = 0; k < taps; k++) {
+            const float tap = static_cast<float>(h[k] / sum);
+            filter[p][k * channels + 0] = tap;
+            filter[p][k * channels + 1] = tap;
+        }
+    }
+}
+
+// Appends frame_count frames as floats, left and right swapped and scaled.
+void convert(const int16_t* samples, size_t frame_count, float scale, float* dst) {
+    size_t i = 0;
+#if defined(__SSE4_1__)
+    const __m128 vscale = _mm_set1_ps(scale);
+    for (; i + 4 <= frame_count; i += 4) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i * channels));
+        s = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+        const __m128 lo = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(s));
+        const __m128 hi = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_srli_si128(s, 8)));
+        _mm_storeu_ps(dst + i * channels + 0, _mm_mul_ps(lo, vscale));
+        _mm_storeu_ps(dst + i * channels + 4, _mm_mul_ps(hi, vscale));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= frame_count; i += 4) {
+        const int16x8_t s = vrev32q_s16(vld1q_s16(samples + i * channels));
+        vst1q_f32(dst + i * channels + 0, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))), scale));
+        vst1q_f32(dst + i * channels + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(s))), scale));
+    }
+#endif
+    for (; i < frame_count; i++) {
+        dst[i * channels + 0] = samples[i * channels + 1] * scale;
+        dst[i * channels + 1] = samples[i * channels + 0] * scale;
+    }
+}
+
+// One output frame from the taps frames starting at src.
+inline void filter_frame(const float* src, const float* h, float* dst) {
+#if defined(__SSE4_1__)
+    __m128 acc = _mm_mul_ps(_mm_loadu_ps(src + 0), _mm_load_ps(h + 0));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(src + 4), _mm_load_ps(h + 4)));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(src + 8), _mm_load_ps(h + 8)));
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(src + 12), _mm_load_ps(h + 12)));
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    _mm_storel_pi(reinterpret_cast<__m64*>(dst), acc);
+#elif defined(__ARM_NEON)
+    float32x4_t acc = vmulq_f32(vld1q_f32(src + 0), vld1q_f32(h + 0));
+    acc = vmlaq_f32(acc, vld1q_f32(src + 4), vld1q_f32(h + 4));
+    acc = vmlaq_f32(acc, vld1q_f32(src + 8), vld1q_f32(h + 8));
+    acc = vmlaq_f32(acc, vld1q_f32(src + 12), vld1q_f32(h + 12));
+    vst1_f32(dst, vadd_f32(vget_low_f32(acc), vget_high_f32(acc)));
+#else
+    float left = 0.0f;
+    float right = 0.0f;
+    for (size_t k = 0; k < taps; k++) {
+        left += src[k * channels + 0] * h[k * channels + 0];
+        right += src[k * channels + 1] * h[k * channels + 1];
+    }
+    dst[0] = left;
+    dst[1] = right;
+#endif
+}
+
+} // namespace
+
+void configure(uint32_t input_rate, uint32_t output_rate) {
+    assert(input_rate != 0 && output_rate != 0);
+    nominal_step = (uint64_t(input_rate) << 32) / output_rate;
+    step = nominal_step;
+    output_frame_rate = output_rate;
+    smoothed_error = 0.0;
+    integrated_adjust = 0.0;
+
+    // Pass band slightly below the lower Nyquist frequency of the two rates.
+    build_filter(0.95 * std::min(1.0, double(output_rate) / double(input_rate)));
+
+    // Start from silence, positioned so the first output lines up with the first input frame.
+    std::fill(std::begin(staging), std::end(staging), 0.0f);
+    staged_frames = taps_before;
+    position = uint64_t(taps_before) << 32;
+
+    // Room for the slowest the rate control can run.
+    const double min_step = double(nominal_step) * (1.0 - max_rate_adjust);
+    const size_t max_output_frames = static_cast<size_t>(double(uint64_t(max_input_frames + taps) << 32) / min_step) + 2;
+    output.assign(max_output_frames * channels, 0.0f);
+}
+
+size_t process(const int16_t* samples, size_t sample_count, float volume, float** out) {
+    const size_t frame_count = std::min(sample_count / channels, max_input_frames);
+    convert(samples, frame_count, volume * (0.5f / 32768.0f), staging + staged_frames * channels);
+    staged_frames += frame_count;
+
+    size_t produced = 0;
+    while (((position >> 32) + taps - taps_before) <= staged_frames) {
+        const size_t first = static_cast<size_t>(position >> 32) - taps_before;
+        const size_t phase = static_cast<size_t>(position >> (32 - phase_bits)) & (phase_count - 1);
+        filter_frame(staging + first * channels, filter[phase], output.data() + produced * channels);
+        produced++;
+        position += step;
+    }
+
+    // Keep the frames the next output still needs.
+    const size_t keep_from = std::min(static_cast<size_t>(position >> 32) - taps_before, staged_frames);
+    std::memmove(staging, staging + keep_from * channels, (staged_frames - keep_from) * channels * sizeof(float));
+    staged_frames -= keep_from;
+    position -= uint64_t(keep_from) << 32;
+
+    *out = output.data();
+    return produced;
+}
+
+void set_rate_control(bool enabled) {
+    rate_control.store(enabled, std::memory_order_relaxed);
+}
+
+bool rate_control_enabled() {
+    return rate_control.load(std::memory_order_relaxed);
+}
+
+void set_target_latency_ms(uint32_t ms) {
+    target_latency.store(std::max<uint32_t>(ms, 1), std::memory_order_relaxed);
+}
+
+uint32_t target_latency_ms() {
+    return target_latency.load(std::memory_order_relaxed);
+}
+
+void update_rate_control(size_t queued_output_frames) {
+    const bool enabled = rate_control.load(std::memory_order_relaxed);
+    if (enabled != rate_control_applied) {
+        rate_control_applied = enabled;
+        smoothed_error = 0.0;
+        integrated_adjust = 0.0;
+        step = nominal_step;
+    }
+    if (!enabled) {
+        return;
+    }
+    // Relative distance from the target, smoothed over a few buffers so one late frame does
+    // not swing the pitch. The proportional part reaches the full adjustment at twice the
+    // target; the integral part settles out a steady clock drift between the game and the
+    // device so the queue ends up on the target rather than next to it.
+    const double target_frames = double(output_frame_rate) * target_latency_ms() / 1000.0;
+    const double error = (double(queued_output_frames) - target_frames) / target_frames;
+    smoothed_error += 0.1 * (error - smoothed_error);
+    integrated_adjust = std::clamp(integrated_adjust + smoothed_error * 0.00002, -max_rate_adjust, max_rate_adjust);
+    const double adjust = std::clamp(smoothed_error * max_rate_adjust + integrated_adjust, -max_rate_adjust, max_rate_adjust);
+    // A longer queue consumes input faster, producing fewer output frames per buffer.
+    step = static_cast<uint64_t>(double(nominal_step) * (1.0 + adjust));
+}
+
+} // namespace sssv::audio_output
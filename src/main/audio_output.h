@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Output stage between the AI buffers the game queues and the SDL audio device.
+//
+// Each buffer is converted in one vectorized pass (int16 to float, the N64's swapped
+// channel order, main volume) into a fixed-capacity staging buffer. It is then resampled from
+// the AI rate to the device rate with an 8-tap polyphase windowed-sinc filter. The filter
+// history carries over between buffers, so no frames are duplicated or discarded at buffer
+// edges. Only configure() allocates.
+namespace sssv::audio_output {
+    // Largest AI buffer in stereo frames (AI_LEN is 18 bits of bytes).
+    constexpr size_t max_input_frames = 0x40000 / 4;
+
+    // Sets the AI and device rates and resets the filter history.
+    void configure(uint32_t input_rate, uint32_t output_rate);
+
+    // Converts sample_count interleaved int16 samples (stereo). Returns the number of stereo
+    // float frames written to *out, which stays valid until the next call.
+    size_t process(const int16_t* samples, size_t sample_count, float volume, float** out);
+
+    // Dynamic rate control: instead of dropping samples when the device queue runs long, the
+    // resampling ratio is nudged by at most max_rate_adjust so the queue converges on the
+    // target latency. The pitch change this causes is far below what is audible.
+    constexpr double max_rate_adjust = 0.005;
+    constexpr uint32_t default_target_latency_ms = 40;
+
+    // The setters may be called from any thread; update_rate_control picks the change up on the
+    // audio thread.
+    void set_rate_control(bool enabled);
+    bool rate_control_enabled();
+    void set_target_latency_ms(uint32_t ms);
+    uint32_t target_latency_ms();
+
+    // Steers the ratio for the next process() call from the frames queued on the device.
+    void update_rate_control(size_t queued_output_frames);
+} // namespace sssv::audio_output
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+
+namespace sssv::audio_output {
+    // Lock-free single-producer/single-consumer ring of float samples, for feeding an SDL
+    // audio callback. The producer only moves head_, the consumer only moves tail_, and
+    // either side can read the fill level without blocking the other.
+    class SampleRing {
+    public:
+        explicit SampleRing(size_t capacity_log2)
+            : buffer_(new float[size_t(1) << capacity_log2]), capacity_(size_t(1) << capacity_log2) {}
+
+        size_t capacity() const { return capacity_; }
+
+        size_t size() const {
+            return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+        }
+
+        // Producer. Writes up to count samples, rounded down to a multiple of granularity
+        // (the channel count, so frames are never split), and returns how many were written.
+        size_t write(const float* src, size_t count, size_t granularity) {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            const size_t free = capacity_ - (head - tail_.load(std::memory_order_acquire));
+            count = std::min(count, free);
+            count -= count % granularity;
+            copy_in(head, src, count);
+            head_.store(head + count, std::memory_order_release);
+            return count;
+        }
+
+        // Consumer. Reads up to count samples and returns how many were read.
+        size_t read(float* dst, size_t count) {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            count = std::min(count, head_.load(std::memory_order_acquire) - tail);
+            copy_out(tail, dst, count);
+            tail_.store(tail + count, std::memory_order_release);
+            return count;
+        }
+
+        // Only while the consumer is stopped (device paused or locked).
+        void reset() {
+            tail_.store(head_.load(std::memory_order_relaxed), std::memory_order_release);
+        }
+
+    private:
+        void copy_in(size_t index, const float* src, size_t count) {
+            const size_t offset = index & (capacity_ - 1);
+            const size_t first = std::min(count, capacity_ - offset);
+            std::memcpy(buffer_.get() + offset, src, first * sizeof(float));
+            std::memcpy(buffer_.get(), src + first, (count - first) * sizeof(float));
+        }
+
+        void copy_out(size_t index, float* dst, size_t count) const {
+            const size_t offset = index & (capacity_ - 1);
+            const size_t first = std::min(count, capacity_ - offset);
+            std::memcpy(dst, buffer_.get() + offset, first * sizeof(float));
+            std::memcpy(dst + first, buffer_.get(), (count - first) * sizeof(float));
+        }
+
+        std::unique_ptr<float[]> buffer_;
+        const size_t capacity_;
+        alignas(64) std::atomic<size_t> head_{ 0 };
+        alignas(64) std::atomic<size_t> tail_{ 0 };
+    };
+} // namespace sssv::audio_output
@@ -0,0 +1,184 @@
+#include "audio_stats.h"
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+namespace sssv::audio_stats {
+
+namespace {
+
+constexpr uint64_t log_interval_ns = 5000000000ull;
+constexpr size_t stream_count = static_cast<size_t>(Stream::Count);
+
+struct StreamCounters {
+    std::atomic<bool> fed{ false };
+    std::atomic<uint64_t> underruns{ 0 };
+    std::atomic<uint64_t> overruns{ 0 };
+    std::atomic<uint64_t> overrun_samples{ 0 };
+    std::atomic<uint64_t> latency[latency_buckets] = {};
+};
+
+StreamCounters streams[stream_count];
+std::atomic<uint64_t> skipped_samples{ 0 };
+std::atomic<uint64_t> calls{ 0 };
+std::atomic<uint64_t> last_call_ns{ 0 };
+std::atomic<uint64_t> interval_ns_total{ 0 };
+std::atomic<uint64_t> interval_ns_max{ 0 };
+std::atomic<uint64_t> conversion_ns_total{ 0 };
+std::atomic<uint64_t> conversion_ns_max{ 0 };
+
+std::atomic<bool> logging{ false };
+std::atomic<uint64_t> last_log_ns{ 0 };
+
+// Values at the previous log line, so each line covers one interval. Maxima are reset instead.
+struct Totals {
+    uint64_t underruns[stream_count] = {};
+    uint64_t overruns[stream_count] = {};
+    uint64_t overrun_samples[stream_count] = {};
+    uint64_t latency[stream_count][latency_buckets] = {};
+    uint64_t skipped_samples = 0;
+    uint64_t calls = 0;
+    uint64_t interval_ns_total = 0;
+    uint64_t conversion_ns_total = 0;
+};
+
+Totals last_totals;
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+StreamCounters& counters(Stream stream) {
+    return streams[static_cast<size_t>(stream)];
+}
+
+void add(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+// Single writer, so a plain load and store is enough.
+void raise(std::atomic<uint64_t>& maximum, uint64_t value) {
+    if (value > maximum.load(std::memory_order_relaxed)) {
+        maximum.store(value, std::memory_order_relaxed);
+    }
+}
+
+size_t latency_bucket(uint64_t queued_us) {
+    size_t bucket = 0;
+    for (uint64_t limit = 5000; (bucket + 1 < latency_buckets) && (queued_us >= limit); limit *= 2) {
+        bucket++;
+    }
+    return bucket;
+}
+
+uint64_t take(const std::atomic<uint64_t>& counter, uint64_t& last) {
+    const uint64_t value = counter.load(std::memory_order_relaxed);
+    const uint64_t delta = value - last;
+    last = value;
+    return delta;
+}
+
+void print_stream(const char* name, size_t index) {
+    StreamCounters& c = streams[index];
+    const uint64_t underruns = take(c.underruns, last_totals.underruns[index]);
+    const uint64_t overruns = take(c.overruns, last_totals.overruns[index]);
+    const uint64_t overrun_samples = take(c.overrun_samples, last_totals.overrun_samples[index]);
+    uint64_t latency[latency_buckets];
+    for (size_t b = 0; b < latency_buckets; b++) {
+        latency[b] = take(c.latency[b], last_totals.latency[index][b]);
+    }
+    std::printf("[AUDIO STATS] %s: %" PRIu64 " underruns, %" PRIu64 " overruns (%" PRIu64 " samples), queued ms <5:%" PRIu64 " <10:%" PRIu64
+        " <20:%" PRIu64 " <40:%" PRIu64 " <80:%" PRIu64 " <160:%" PRIu64 " more:%" PRIu64 "\n",
+        name, underruns, overruns, overrun_samples,
+        latency[0], latency[1], latency[2], latency[3], latency[4], latency[5], latency[6]);
+}
+
+} // namespace
+
+void record_underrun(Stream stream) {
+    StreamCounters& c = counters(stream);
+    if (c.fed.exchange(false, std::memory_order_relaxed)) {
+        add(c.underruns, 1);
+    }
+}
+
+void record_fed(Stream stream) {
+    counters(stream).fed.store(true, std::memory_order_relaxed);
+}
+
+void record_stopped(Stream stream) {
+    counters(stream).fed.store(false, std::memory_order_relaxed);
+}
+
+void record_overrun(Stream stream, size_t dropped_samples) {
+    StreamCounters& c = counters(stream);
+    add(c.overruns, 1);
+    add(c.overrun_samples, dropped_samples);
+}
+
+void record_skipped(size_t dropped_samples) {
+    add(skipped_samples, dropped_samples);
+}
+
+void record_queued_latency(Stream stream, uint64_t queued_us) {
+    add(counters(stream).latency[latency_bucket(queued_us)], 1);
+}
+
+uint64_t record_call() {
+    const uint64_t now = now_ns();
+    const uint64_t last = last_call_ns.exchange(now, std::memory_order_relaxed);
+    if (last != 0) {
+        add(interval_ns_total, now - last);
+        raise(interval_ns_max, now - last);
+    }
+    add(calls, 1);
+    return now;
+}
+
+void record_conversion(uint64_t start_ns) {
+    const uint64_t elapsed = now_ns() - start_ns;
+    add(conversion_ns_total, elapsed);
+    raise(conversion_ns_max, elapsed);
+}
+
+void set_logging(bool enabled) {
+    logging.store(enabled, std::memory_order_relaxed);
+}
+
+bool logging_enabled() {
+    return logging.load(std::memory_order_relaxed);
+}
+
+void log_periodic() {
+    if (!logging_enabled()) {
+        return;
+    }
+    // The game and launcher paths both call this; whichever claims the interval prints it.
+    const uint64_t now = now_ns();
+    uint64_t last = last_log_ns.load(std::memory_order_relaxed);
+    if ((last != 0) && ((now - last) < log_interval_ns)) {
+        return;
+    }
+    if (!last_log_ns.compare_exchange_strong(last, now, std::memory_order_relaxed) || (last == 0)) {
+        return;
+    }
+
+    print_stream("game", static_cast<size_t>(Stream::Game));
+    print_stream("launcher", static_cast<size_t>(Stream::Launcher));
+
+    const uint64_t call_count = take(calls, last_totals.calls);
+    const uint64_t skipped = take(skipped_samples, last_totals.skipped_samples);
+    const uint64_t interval_total = take(interval_ns_total, last_totals.interval_ns_total);
+    const uint64_t conversion_total = take(conversion_ns_total, last_totals.conversion_ns_total);
+    const uint64_t interval_max = interval_ns_max.exchange(0, std::memory_order_relaxed);
+    const uint64_t conversion_max = conversion_ns_max.exchange(0, std::memory_order_relaxed);
+    const double per_call = call_count != 0 ? 1.0 / double(call_count) : 0.0;
+    std::printf("[AUDIO STATS] queue_samples: %" PRIu64 " calls, %" PRIu64 " samples skipped, interval avg %.2f ms max %.2f ms, conversion avg %.1f us max %.1f us\n",
+        call_count, skipped, interval_total * per_call / 1e6, interval_max / 1e6, conversion_total * per_call / 1e3, conversion_max / 1e3);
+    std::fflush(stdout);
+}
+
+} // namespace sssv::audio_stats
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Counters for the audio output path, so crackle reports come with data: underruns and
+// overruns per device, samples dropped by the queue skip, a histogram of the queued latency
+// seen at each push, the time between queue_samples calls and the time spent converting.
+//
+// Every probe is a relaxed atomic add (or a relaxed load/store for maxima, which have a
+// single writer), so the counters are always on. log_periodic() prints what changed since
+// its last line every few seconds while the "Audio Stats Log" debug option is set.
+namespace sssv::audio_stats {
+    enum class Stream {
+        Game,
+        Launcher,
+        Count
+    };
+
+    // Queued latency buckets in milliseconds: [0,5) [5,10) [10,20) [20,40) [40,80) [80,160) [160,inf).
+    constexpr size_t latency_buckets = 7;
+
+    // Device callback came up short after the stream had been fed (pull mode), or the game
+    // found the device queue empty (queue mode).
+    void record_underrun(Stream stream);
+    // Called whenever samples are pushed, so only the first short read after a push counts.
+    void record_fed(Stream stream);
+    // The stream is being let run dry on purpose; its next short read is not an underrun.
+    void record_stopped(Stream stream);
+    // Samples the ring had no room for.
+    void record_overrun(Stream stream, size_t dropped_samples);
+    void record_skipped(size_t dropped_samples);
+    void record_queued_latency(Stream stream, uint64_t queued_us);
+    // Marks a queue_samples call and returns the time it was made, for record_conversion().
+    uint64_t record_call();
+    void record_conversion(uint64_t start_ns);
+
+    void set_logging(bool enabled);
+    bool logging_enabled();
+    // Prints a summary line per stream if logging is on and the interval has elapsed.
+    void log_periodic();
+} // namespace sssv::audio_stats
@@ -0,0 +1,298 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "sssv_billboard_telemetry.h"
+
+namespace sssv::benchmark {
+
+namespace {
+
+struct InputFrame {
+    uint16_t buttons = 0;
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+struct Options {
+    bool active = false;
+    bool null_renderer = false;
+    uint32_t frames = 3600;
+    std::filesystem::path input_path;
+    std::filesystem::path record_path;
+    std::filesystem::path output_path = "benchmark.json";
+};
+
+Options options;
+std::vector<InputFrame> replay_input;
+
+std::atomic<uint32_t> vi_count{ 0 };
+// Display lists submitted so far (gfx thread).
+std::atomic<uint32_t> game_frames{ 0 };
+// Controller polls so far. Only the game thread touches it, and input is recorded and replayed
+// against it, so replay does not depend on how far the renderer has got.
+uint32_t input_polls = 0;
+
+// The poll get_input is answering.
+uint32_t input_frame() {
+    return input_polls != 0 ? input_polls - 1 : 0;
+}
+std::atomic<uint64_t> last_vi_ns{ 0 };
+std::atomic<bool> done{ false };
+uint64_t start_ns = 0;
+
+std::mutex mutex;
+std::vector<InputFrame> recorded_input;
+std::vector<uint64_t> frame_ns;
+std::vector<uint64_t> dl_interval_ns;
+std::vector<uint64_t> audio_task_ns;
+uint64_t last_display_list_ns = 0;
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// One line per controller poll: buttons in hex, then the stick. '#' starts a comment.
+bool load_input(const std::filesystem::path& path) {
+    std::ifstream stream(path);
+    if (!stream.good()) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(stream, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        InputFrame frame;
+        unsigned int buttons = 0;
+        if (std::sscanf(line.c_str(), "%x %f %f", &buttons, &frame.x, &frame.y) == 3) {
+            frame.buttons = static_cast<uint16_t>(buttons);
+            replay_input.push_back(frame);
+        }
+    }
+    return true;
+}
+
+void write_recording() {
+    if (options.record_path.empty() || recorded_input.empty()) {
+        return;
+    }
+    std::FILE* file = std::fopen(options.record_path.string().c_str(), "w");
+    if (file == nullptr) {
+        fprintf(stderr, "[BENCHMARK] failed to write %s\n", options.record_path.string().c_str());
+        return;
+    }
+    fprintf(file, "# SSSV benchmark input: controller 1 per controller poll (buttons, stick x, stick y)\n");
+    for (const InputFrame& frame : recorded_input) {
+        fprintf(file, "%04X %.4f %.4f\n", frame.buttons, frame.x, frame.y);
+    }
+    std::fclose(file);
+    printf("[BENCHMARK] recorded %zu frames of input to %s\n", recorded_input.size(), options.record_path.string().c_str());
+    fflush(stdout);
+}
+
+void write_distribution(std::FILE* file, const char* name, std::vector<uint64_t> values) {
+    std::sort(values.begin(), values.end());
+    uint64_t total = 0;
+    for (uint64_t value : values) {
+        total += value;
+    }
+    const auto percentile = [&](double p) {
+        return values.empty() ? 0.0 : values[std::min(values.size() - 1, size_t(p * values.size()))] / 1e6;
+    };
+    fprintf(file, "  \"%s\": { \"count\": %zu, \"total\": %.3f, \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n",
+        name, values.size(), total / 1e6, values.empty() ? 0.0 : total / 1e6 / values.size(),
+        percentile(0.50), percentile(0.90), percentile(0.99), values.empty() ? 0.0 : values.back() / 1e6);
+}
+
+void write_report() {
+    const bool telemetry = billboard::telemetry::enabled();
+    std::vector<billboard::telemetry::FrameRecord> records(billboard::telemetry::kRingFrames);
+    records.resize(telemetry ? billboard::telemetry::snapshot(records.data(), records.size()) : 0);
+    billboard::telemetry::HookCounters hooks[billboard::telemetry::kHookCount] = {};
+    for (const billboard::telemetry::FrameRecord& record : records) {
+        for (int h = 0; h < billboard::telemetry::kHookCount; h++) {
+            hooks[h].calls += record.hooks[h].calls;
+            hooks[h].emits += record.hooks[h].emits;
+            hooks[h].fails += record.hooks[h].fails;
+        }
+    }
+    static constexpr const char* hook_names[billboard::telemetry::kHookCount] = {
+        "stars_6c5e44", "energy_items_73f17c", "flowers_73f800", "collectibles_740094", "trees_740820",
+    };
+
+    std::lock_guard lock(mutex);
+    std::FILE* file = std::fopen(options.output_path.string().c_str(), "w");
+    if (file == nullptr) {
+        fprintf(stderr, "[BENCHMARK] failed to write %s\n", options.output_path.string().c_str());
+        return;
+    }
+    fprintf(file, "{\n");
+    fprintf(file, "  \"game_frames\": %" PRIu32 ",\n", game_frames.load());
+    fprintf(file, "  \"vi_frames\": %" PRIu32 ",\n", vi_count.load());
+    fprintf(file, "  \"seconds\": %.3f,\n", (now_ns() - start_ns) / 1e9);
+    fprintf(file, "  \"input\": \"%s\",\n", options.input_path.empty() ? "none" : options.input_path.filename().string().c_str());
+    fprintf(file, "  \"null_renderer\": %s,\n", options.null_renderer ? "true" : "false");
+    write_distribution(file, "frame_ms", frame_ns);
+    write_distribution(file, "dl_interval_ms", dl_interval_ns);
+    write_distribution(file, "audio_task_ms", audio_task_ns);
+    if (!telemetry) {
+        fprintf(file, "  \"billboards\": null\n}\n");
+        std::fclose(file);
+        printf("[BENCHMARK] %" PRIu32 " frames done, wrote %s\n", game_frames.load(), options.output_path.string().c_str());
+        fflush(stdout);
+        return;
+    }
+    // The telemetry ring only holds the most recent frames.
+    fprintf(file, "  \"billboards\": { \"frames\": %zu", records.size());
+    for (int h = 0; h < billboard::telemetry::kHookCount; h++) {
+        fprintf(file, ", \"%s\": { \"calls\": %" PRIu32 ", \"emits\": %" PRIu32 ", \"fails\": %" PRIu32 " }",
+            hook_names[h], hooks[h].calls, hooks[h].emits, hooks[h].fails);
+    }
+    fprintf(file, " }\n}\n");
+    std::fclose(file);
+
+    printf("[BENCHMARK] %" PRIu32 " frames done, wrote %s\n", game_frames.load(), options.output_path.string().c_str());
+    fflush(stdout);
+}
+
+} // namespace
+
+bool parse_args(int argc, char** argv) {
+    Options parsed;
+    bool requested = false;
+    for (int i = 1; i < argc; i++) {
+        const bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--benchmark") == 0) {
+            requested = true;
+        }
+        else if (strcmp(argv[i], "--benchmark-null-renderer") == 0) {
+            parsed.null_renderer = true;
+        }
+        else if (strcmp(argv[i], "--benchmark-frames") == 0 && has_value) {
+            parsed.frames = static_cast<uint32_t>(std::max(1, atoi(argv[++i])));
+        }
+        else if (strcmp(argv[i], "--benchmark-input") == 0 && has_value) {
+            parsed.input_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--benchmark-record") == 0 && has_value) {
+            parsed.record_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--benchmark-output") == 0 && has_value) {
+            parsed.output_path = argv[++i];
+        }
+    }
+    parsed.active = requested;
+    options = parsed;
+
+    if (options.active && !options.input_path.empty() && !load_input(options.input_path)) {
+        fprintf(stderr, "[BENCHMARK] could not read input file %s\n", options.input_path.string().c_str());
+        options = Options{};
+        return false;
+    }
+    if (options.active) {
+        start_ns = now_ns();
+        printf("[BENCHMARK] running %" PRIu32 " frames, %zu frames of recorded input\n", options.frames, replay_input.size());
+        if (options.input_path.empty()) {
+            printf("[BENCHMARK] no --benchmark-input: the game will sit on its title screen\n");
+        }
+        fflush(stdout);
+    }
+    return true;
+}
+
+bool active() {
+    return options.active;
+}
+
+bool null_renderer() {
+    return options.active && options.null_renderer;
+}
+
+bool recording() {
+    return !options.record_path.empty();
+}
+
+void on_input_poll() {
+    input_polls++;
+}
+
+bool get_input(int controller_num, uint16_t* buttons, float* x, float* y, InputFunc live) {
+    if (!options.active) {
+        const bool connected = live(controller_num, buttons, x, y);
+        if (recording() && controller_num == 0) {
+            std::lock_guard lock(mutex);
+            const uint32_t frame = input_frame();
+            if (recorded_input.size() <= frame) {
+                recorded_input.resize(frame + 1, recorded_input.empty() ? InputFrame{} : recorded_input.back());
+            }
+            recorded_input[frame] = connected ? InputFrame{ *buttons, *x, *y } : InputFrame{};
+        }
+        return connected;
+    }
+
+    // Only controller 1 is connected during a benchmark; past the recording it is left idle.
+    if (controller_num != 0) {
+        return false;
+    }
+    const uint32_t frame = input_frame();
+    const InputFrame input = frame < replay_input.size() ? replay_input[frame] : InputFrame{};
+    *buttons = input.buttons;
+    *x = input.x;
+    *y = input.y;
+    return true;
+}
+
+bool on_vi() {
+    vi_count.fetch_add(1, std::memory_order_relaxed);
+    last_vi_ns.store(now_ns(), std::memory_order_relaxed);
+    if (!options.active || game_frames.load(std::memory_order_relaxed) < options.frames || done.exchange(true)) {
+        return false;
+    }
+    write_report();
+    return true;
+}
+
+void on_display_list() {
+    if (!options.active && !recording()) {
+        return;
+    }
+    game_frames.fetch_add(1, std::memory_order_relaxed);
+    if (!options.active) {
+        return;
+    }
+    const uint64_t now = now_ns();
+    const uint64_t vi = last_vi_ns.load(std::memory_order_relaxed);
+    std::lock_guard lock(mutex);
+    if (vi != 0) {
+        frame_ns.push_back(now - vi);
+    }
+    if (last_display_list_ns != 0) {
+        dl_interval_ns.push_back(now - last_display_list_ns);
+    }
+    last_display_list_ns = now;
+}
+
+void record_audio_task(uint64_t elapsed_ns) {
+    std::lock_guard lock(mutex);
+    audio_task_ns.push_back(elapsed_ns);
+}
+
+void shutdown() {
+    std::lock_guard lock(mutex);
+    write_recording();
+}
+
+} // namespace sssv::benchmark
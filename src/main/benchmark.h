@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Benchmark mode (--benchmark): the game boots straight past the launcher, runs a fixed number
+// of game frames with controller 1 driven by a recorded input file, and then writes a JSON report
+// and quits, so runs on the same machine can be compared build to build. The report has:
+// - frame_ms: per game frame, the time from the latest VI to the display list submission. The
+//   game starts a frame on a VI, so this is its work for the frame, without the wait for the
+//   retrace, as long as the frame fits in one VI period.
+// - dl_interval_ms: the interval between display list submissions, which follows the VI pacing.
+// - audio_task_ms: the time spent in audio tasks.
+// - the billboard hook counts, when billboard telemetry is on (Debug tab). The benchmark does
+//   not turn it on itself, since it adds work to every hook call.
+//
+//   --benchmark                   enable benchmark mode
+//   --benchmark-frames N          game frames (display lists) to run (default 3600)
+//   --benchmark-input PATH        replay controller 1 from PATH, recorded with:
+//   --benchmark-record PATH       play normally and record controller 1 to PATH
+//   --benchmark-output PATH       report file (default benchmark.json in the working directory)
+//   --benchmark-null-renderer     skip rendering entirely, to measure the game and audio alone
+//
+// Input is recorded and replayed per controller poll, which the game makes once a frame on its
+// own thread, so a recording drives the same route on every run even when frames take
+// different numbers of VIs or the renderer runs behind.
+// There is no level option: a recording starts at boot, so it includes the menu inputs that
+// pick the level. Frame pacing still follows ultramodern's real-time VI clock.
+namespace sssv::benchmark {
+    using InputFunc = bool (*)(int controller_num, uint16_t* buttons, float* x, float* y);
+
+    // Returns false if the arguments were invalid; benchmark mode stays off then.
+    bool parse_args(int argc, char** argv);
+    bool active();
+    bool null_renderer();
+    // Playing normally while recording counts as neither.
+    bool recording();
+
+    // Called from the poll_input callback, on the game thread, before the game reads the
+    // controllers. Advances the frame input is recorded and replayed against.
+    void on_input_poll();
+
+    // Replaces the input callback: replayed input in benchmark mode, live input passed
+    // through (and recorded) otherwise.
+    bool get_input(int controller_num, uint16_t* buttons, float* x, float* y, InputFunc live);
+
+    // Called on every VI. Returns true once the run is over and the report has been written.
+    bool on_vi();
+    // Called for every display list, which marks the end of a game frame.
+    void on_display_list();
+    void record_audio_task(uint64_t elapsed_ns);
+    // Writes the input recording, if one was being made.
+    void shutdown();
+} // namespace sssv::benchmark
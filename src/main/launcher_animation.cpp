@@ -73,13 +73,20 @@ static float starfield_trail_dot_scale(int t) {
     return 1.0f - (1.0f - STARFIELD_TRAIL_DOT_SCALE_MIN) * (float)t / (float)(STARFIELD_TRAIL_DOTS - 1);
 }
 
-struct StarfieldStar {
-    float x = 0.0f;
-    float y = 0.0f;
-    float speed_dp = 0.0f;
-    float size_dp = 0.0f;
-    float depth = 0.0f;  // 0 = far (short trail), 1 = near (long trail)
-    recompui::Element* dots[STARFIELD_TRAIL_DOTS] = {};
+// Star state is kept as parallel arrays so the per-frame move is a plain loop over floats.
+// Each star's dots live in one trail element: their sizes and offsets only change when the
+// star respawns, so a frame costs one translate per star instead of four style changes per dot.
+struct StarfieldLayer {
+    recompui::Element* wrapper = nullptr;
+    std::vector<recompui::Element*> trails;
+    std::vector<std::array<recompui::Element*, STARFIELD_TRAIL_DOTS>> dots;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> speed_dp;
+    std::vector<float> size_dp;
+    std::vector<float> depth;  // 0 = far (short trail), 1 = near (long trail)
+    std::vector<float> trail_length_dp;
+    std::vector<uint32_t> respawn;
 };
 
 struct LauncherContext {
@@ -90,8 +97,7 @@ struct LauncherContext {
     AnimatedSvg jiggy_hole_svg;
     AnimatedSvg logo_svg;
     std::array<AnimatedSvg, 4> cloud_svgs;
-    recompui::Element* starfield_wrapper = nullptr;
-    std::vector<StarfieldStar> starfield_stars;
+    StarfieldLayer starfield;
     recompui::Element* wrapper = nullptr;
     float wrapper_phase = -1.0f;
     std::chrono::steady_clock::time_point last_update_time;
@@ -221,77 +227,94 @@ const float jiggy_shine_length = 0.8f;
 
 const float animation_skip_time = 10.0f;
 
-static void starfield_respawn(StarfieldStar& star, float bg_width, float bg_height, bool initial) {
+// Trail spacing scales with depth: far stars (depth 0) get shorter trails, near stars (depth 1) get full length.
+static float starfield_trail_spacing(float depth) {
+    return STARFIELD_TRAIL_SPACING_DP * (STARFIELD_TRAIL_LENGTH_FAR + depth * (1.0f - STARFIELD_TRAIL_LENGTH_FAR));
+}
+
+static void starfield_respawn(StarfieldLayer& layer, size_t i, float bg_width, float bg_height, bool initial) {
     float cx = bg_width * 0.5f;
     if (initial) {
-        star.x = (float)(std::rand() % (int)(bg_width + 1)) - cx;
+        layer.x[i] = (float)(std::rand() % (int)(bg_width + 1)) - cx;
     } else {
-        star.x = cx + (float)(std::rand() % (int)(bg_width * 0.4f + 1));
+        layer.x[i] = cx + (float)(std::rand() % (int)(bg_width * 0.4f + 1));
+    }
+    layer.y[i] = (float)(std::rand() % (int)(bg_height + 1)) - bg_height * 0.5f;
+    layer.depth[i] = (float)(std::rand() % 1000) / 1000.0f;
+    layer.speed_dp[i] = STARFIELD_BASE_SPEED_DP + layer.depth[i] * STARFIELD_SPEED_RANGE_DP;
+    layer.size_dp[i] = STARFIELD_SIZE_MIN_DP + layer.depth[i] * (STARFIELD_SIZE_MAX_DP - STARFIELD_SIZE_MIN_DP);
+    layer.trail_length_dp[i] = starfield_trail_spacing(layer.depth[i]) * (float)(STARFIELD_TRAIL_DOTS - 1);
+}
+
+// Lays out star i's dots relative to its trail element, whose origin is the star's center.
+static void starfield_style_trail(StarfieldLayer& layer, size_t i) {
+    float spacing = starfield_trail_spacing(layer.depth[i]);
+    for (int t = 0; t < STARFIELD_TRAIL_DOTS; t++) {
+        float size = layer.size_dp[i] * starfield_trail_dot_scale(t);
+        if (size < STARFIELD_DOT_SIZE_MIN_DP) size = STARFIELD_DOT_SIZE_MIN_DP;
+        recompui::Element* dot = layer.dots[i][t];
+        dot->set_width(size, recompui::Unit::Dp);
+        dot->set_height(size, recompui::Unit::Dp);
+        dot->set_border_radius(size * 0.5f, recompui::Unit::Dp);
+        dot->set_left((float)t * spacing - size * 0.5f, recompui::Unit::Dp);
+        dot->set_top(-size * 0.5f, recompui::Unit::Dp);
     }
-    star.y = (float)(std::rand() % (int)(bg_height + 1)) - bg_height * 0.5f;
-    star.depth = (float)(std::rand() % 1000) / 1000.0f;
-    star.speed_dp = STARFIELD_BASE_SPEED_DP + star.depth * STARFIELD_SPEED_RANGE_DP;
-    star.size_dp = STARFIELD_SIZE_MIN_DP + star.depth * (STARFIELD_SIZE_MAX_DP - STARFIELD_SIZE_MIN_DP);
 }
 
 static void starfield_create_layer(recompui::ContextId context, recompui::Element* background_container, float bg_width, float bg_height) {
-    launcher_context.starfield_wrapper = context.create_element<recompui::Element>(background_container, 0);
-    launcher_context.starfield_wrapper->set_position(recompui::Position::Absolute);
-    launcher_context.starfield_wrapper->set_width(100, recompui::Unit::Percent);
-    launcher_context.starfield_wrapper->set_height(100, recompui::Unit::Percent);
-    launcher_context.starfield_wrapper->set_left(0);
-    launcher_context.starfield_wrapper->set_top(0);
-
-    launcher_context.starfield_stars.resize(STARFIELD_NUM_STARS);
-    for (int i = 0; i < STARFIELD_NUM_STARS; i++) {
-        StarfieldStar& star = launcher_context.starfield_stars[i];
-        starfield_respawn(star, bg_width, bg_height, true);
+    StarfieldLayer& layer = launcher_context.starfield;
+    layer.wrapper = context.create_element<recompui::Element>(background_container, 0);
+    layer.wrapper->set_position(recompui::Position::Absolute);
+    layer.wrapper->set_width(100, recompui::Unit::Percent);
+    layer.wrapper->set_height(100, recompui::Unit::Percent);
+    layer.wrapper->set_left(0);
+    layer.wrapper->set_top(0);
+
+    layer.trails.resize(STARFIELD_NUM_STARS);
+    layer.dots.resize(STARFIELD_NUM_STARS);
+    for (std::vector<float>* values : { &layer.x, &layer.y, &layer.speed_dp, &layer.size_dp, &layer.depth, &layer.trail_length_dp }) {
+        values->resize(STARFIELD_NUM_STARS);
+    }
+    layer.respawn.resize(STARFIELD_NUM_STARS);
+    for (size_t i = 0; i < STARFIELD_NUM_STARS; i++) {
+        recompui::Element* trail = context.create_element<recompui::Element>(layer.wrapper, 0);
+        trail->set_position(recompui::Position::Absolute);
+        trail->set_left(0);
+        trail->set_top(0);
+        layer.trails[i] = trail;
         for (int t = 0; t < STARFIELD_TRAIL_DOTS; t++) {
-            recompui::Element* dot = context.create_element<recompui::Element>(launcher_context.starfield_wrapper, 0);
+            recompui::Element* dot = context.create_element<recompui::Element>(trail, 0);
             dot->set_position(recompui::Position::Absolute);
-            float trail_scale = starfield_trail_dot_scale(t);
-            float size = star.size_dp * trail_scale;
-            if (size < STARFIELD_DOT_SIZE_MIN_DP) size = STARFIELD_DOT_SIZE_MIN_DP;
-            dot->set_width(size, recompui::Unit::Dp);
-            dot->set_height(size, recompui::Unit::Dp);
-            dot->set_border_radius(size * 0.5f, recompui::Unit::Dp);
             dot->set_background_color(recompui::Color{ 255, 255, 255, (uint8_t)(255 * starfield_trail_opacity(t)) });
-            star.dots[t] = dot;
+            layer.dots[i][t] = dot;
         }
+        starfield_respawn(layer, i, bg_width, bg_height, true);
+        starfield_style_trail(layer, i);
     }
 }
 
-// Trail spacing scales with depth: far stars (depth 0) get shorter trails, near stars (depth 1) get full length.
-static float starfield_trail_spacing_for_star(const StarfieldStar& star) {
-    return STARFIELD_TRAIL_SPACING_DP * (STARFIELD_TRAIL_LENGTH_FAR + star.depth * (1.0f - STARFIELD_TRAIL_LENGTH_FAR));
-}
-
 static void starfield_update(float delta_time, float bg_width, float bg_height) {
-    if (!launcher_context.starfield_wrapper || launcher_context.starfield_stars.empty()) return;
+    StarfieldLayer& layer = launcher_context.starfield;
+    if (!layer.wrapper || layer.trails.empty()) return;
+    const size_t count = layer.trails.size();
     float cx = bg_width * 0.5f;
     float cy = bg_height * 0.5f;
 
-    for (StarfieldStar& star : launcher_context.starfield_stars) {
-        star.x -= star.speed_dp * delta_time;
-        float spacing = starfield_trail_spacing_for_star(star);
-        float trail_length_dp = spacing * (float)(STARFIELD_TRAIL_DOTS - 1);
-        float left_edge = -cx - trail_length_dp - 20.0f;
-        if (star.x < left_edge) {
-            starfield_respawn(star, bg_width, bg_height, false);
-            spacing = starfield_trail_spacing_for_star(star);
-        }
-        for (int t = 0; t < STARFIELD_TRAIL_DOTS; t++) {
-            float dx = star.x + (float)t * spacing;
-            float trail_scale = starfield_trail_dot_scale(t);
-            float dot_size = star.size_dp * trail_scale;
-            if (dot_size < STARFIELD_DOT_SIZE_MIN_DP) dot_size = STARFIELD_DOT_SIZE_MIN_DP;
-            float dot_x = cx + dx - dot_size * 0.5f;
-            float dot_y = cy + star.y - dot_size * 0.5f;
-            star.dots[t]->set_width(dot_size, recompui::Unit::Dp);
-            star.dots[t]->set_height(dot_size, recompui::Unit::Dp);
-            star.dots[t]->set_border_radius(dot_size * 0.5f, recompui::Unit::Dp);
-            star.dots[t]->set_translate_2D(dot_x, dot_y, recompui::Unit::Dp);
+    float* x = layer.x.data();
+    const float* speed_dp = layer.speed_dp.data();
+    const float* trail_length_dp = layer.trail_length_dp.data();
+    uint32_t* respawn = layer.respawn.data();
+    for (size_t i = 0; i < count; i++) {
+        x[i] -= speed_dp[i] * delta_time;
+        respawn[i] = x[i] < (-cx - trail_length_dp[i] - 20.0f);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (respawn[i]) {
+            starfield_respawn(layer, i, bg_width, bg_height, false);
+            starfield_style_trail(layer, i);
         }
+        layer.trails[i]->set_translate_2D(cx + layer.x[i], cy + layer.y[i], recompui::Unit::Dp);
     }
 }
 
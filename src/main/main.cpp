@@ -1,11 +1,14 @@
 #include <cstdio>
 #include <cassert>
+#include <cstring>
 #include <unordered_map>
 #include <vector>
 #include <array>
+#include <chrono>
 #include <algorithm>
 #include <filesystem>
 #include <numeric>
+#include <atomic>
 #include <stdexcept>
 #include <cinttypes>
 #include <string>
@@ -42,7 +45,17 @@
 #include "sssv_config.h"
 #include "sssv_game.h"
 #include "sssv_launcher.h"
+#include "sssv_billboard_controls.h"
+#include "sssv_audio_hle.h"
+#include "sssv_audio_worker.h"
 #include "theme.h"
+#include "audio_output.h"
+#include "audio_mixer.h"
+#include "audio_ring.h"
+#include "audio_stats.h"
+#include "benchmark.h"
+#include "texture_pack_warmer.h"
+#include "sssv_timeline.h"
 #include "librecomp/game.hpp"
 #include "librecomp/mods.hpp"
 #include "librecomp/helpers.hpp"
@@ -66,6 +79,23 @@
 #include "SDL_syswm.h"
 #endif
 
+#if defined(__linux__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+#include <thread>
+#endif
+#if defined(__linux__)
+#include <link.h>
+#endif
+#if defined(__APPLE__)
+#include <mach-o/dyld.h>
+#endif
+
 const std::string version_string = "0.1.2";
 
 template<typename... Ts>
@@ -149,85 +179,175 @@ void update_gfx(void*) {
     csdk::launcher_music::update(launcher_volume);
 }
 
-static SDL_AudioCVT audio_convert;
 static SDL_AudioDeviceID audio_device = 0;
-static SDL_AudioDeviceID launcher_audio_device = 0;
-static bool launcher_audio_failed = false;
-static uint32_t launcher_audio_sample_rate = 0;
-static uint32_t launcher_audio_channels = 0;
 
 static uint32_t sample_rate = 48000;
 static uint32_t output_sample_rate = 48000;
 constexpr uint32_t input_channels = 2;
 static uint32_t output_channels = 2;
 
-constexpr uint32_t duplicated_input_frames = 4;
-static uint32_t discarded_output_frames;
-
 constexpr uint32_t bytes_per_frame = input_channels * sizeof(float);
 
-void queue_samples(int16_t* audio_data, size_t sample_count) {
-    static std::vector<float> swap_buffer;
-    static std::array<float, duplicated_input_frames * input_channels> duplicated_sample_buffer;
+// Pull: SDL's audio thread mixes the game and launcher music rings in the device callback,
+// so neither side takes the device lock, the queue depth is exact and the launcher music can
+// fade out under the game on the one device. Queue: both push to the device with
+// SDL_QueueAudio, which appends rather than mixes, so whatever launcher music is still queued
+// is dropped when the launcher stops or the game queues its first samples, whichever comes
+// first. Selected with --audio-device-mode.
+enum class AudioDeviceMode {
+    Queue,
+    Pull,
+};
+static AudioDeviceMode audio_device_mode = AudioDeviceMode::Pull;
 
-    size_t resampled_sample_count = sample_count + duplicated_input_frames * input_channels;
-    size_t max_sample_count = std::max(resampled_sample_count, resampled_sample_count * audio_convert.len_mult);
-    if (max_sample_count > swap_buffer.size()) {
-        swap_buffer.resize(max_sample_count);
-    }
+// 2^17 samples: about 1.4 s of stereo at 48 kHz.
+static sssv::audio_output::SampleRing audio_ring{ 17 };
+static sssv::audio_output::SampleRing launcher_audio_ring{ 17 };
 
-    for (size_t i = 0; i < duplicated_input_frames * input_channels; i++) {
-        swap_buffer[i] = duplicated_sample_buffer[i];
+constexpr size_t game_source = 0;
+constexpr size_t launcher_source = 1;
+static sssv::audio_output::Mixer audio_mixer{ 2, { &audio_ring, &launcher_audio_ring } };
+
+static sssv::audio_stats::Stream stats_stream(const sssv::audio_output::SampleRing& ring) {
+    return &ring == &audio_ring ? sssv::audio_stats::Stream::Game : sssv::audio_stats::Stream::Launcher;
+}
+
+static void pull_audio_callback(void*, Uint8* stream, int len) {
+    float* out = reinterpret_cast<float*>(stream);
+    size_t count = static_cast<size_t>(len) / sizeof(float);
+    // Sources that run dry are padded with silence.
+    uint32_t short_sources = audio_mixer.mix(out, count);
+    if ((short_sources & (1u << game_source)) != 0) {
+        sssv::audio_stats::record_underrun(sssv::audio_stats::Stream::Game);
+    }
+    if ((short_sources & (1u << launcher_source)) != 0) {
+        sssv::audio_stats::record_underrun(sssv::audio_stats::Stream::Launcher);
     }
+}
 
-    float cur_main_volume = static_cast<float>(recompui::config::sound::get_main_volume()) / 100.0f;
-    for (size_t i = 0; i < sample_count; i += input_channels) {
-        swap_buffer[i + 0 + duplicated_input_frames * input_channels] = audio_data[i + 1] * (0.5f / 32768.0f) * cur_main_volume;
-        swap_buffer[i + 1 + duplicated_input_frames * input_channels] = audio_data[i + 0] * (0.5f / 32768.0f) * cur_main_volume;
+static SDL_AudioDeviceID open_audio_device(uint32_t freq) {
+    bool pull = audio_device_mode == AudioDeviceMode::Pull;
+    SDL_AudioSpec spec_desired{
+        .freq = (int)freq,
+        .format = AUDIO_F32,
+        .channels = (Uint8)output_channels,
+        .silence = 0,
+        .samples = 0x100,
+        .padding = 0,
+        .size = 0,
+        .callback = pull ? pull_audio_callback : nullptr,
+        .userdata = nullptr
+    };
+    audio_ring.reset();
+    launcher_audio_ring.reset();
+    return SDL_OpenAudioDevice(nullptr, false, &spec_desired, nullptr, 0);
+}
+
+static uint32_t get_queued_audio_bytes(const sssv::audio_output::SampleRing& ring) {
+    if (audio_device_mode == AudioDeviceMode::Pull) {
+        return static_cast<uint32_t>(ring.size() * sizeof(float));
+    }
+    uint32_t bytes = SDL_GetQueuedAudioSize(audio_device);
+    if (bytes == 0) {
+        sssv::audio_stats::record_underrun(stats_stream(ring));
     }
+    return bytes;
+}
 
-    assert(sample_count > duplicated_input_frames * input_channels);
+static void push_audio(sssv::audio_output::SampleRing& ring, const float* samples, uint32_t bytes) {
+    if (bytes != 0) {
+        sssv::audio_stats::record_fed(stats_stream(ring));
+    }
+    if (audio_device_mode == AudioDeviceMode::Pull) {
+        // A full ring drops the newest samples, as the queue skip would.
+        size_t count = bytes / sizeof(float);
+        size_t written = ring.write(samples, count, output_channels);
+        if (written < count) {
+            sssv::audio_stats::record_overrun(stats_stream(ring), count - written);
+        }
+        return;
+    }
+    SDL_QueueAudio(audio_device, samples, bytes);
+}
 
-    for (size_t i = 0; i < duplicated_input_frames * input_channels; i++) {
-        duplicated_sample_buffer[i] = swap_buffer[i + sample_count];
+static void clear_queued_audio(sssv::audio_output::SampleRing& ring) {
+    if (audio_device_mode == AudioDeviceMode::Pull) {
+        SDL_LockAudioDevice(audio_device);
+        ring.reset();
+        SDL_UnlockAudioDevice(audio_device);
+        return;
     }
+    SDL_ClearQueuedAudio(audio_device);
+}
 
-    audio_convert.buf = reinterpret_cast<Uint8*>(swap_buffer.data());
-    audio_convert.len = (sample_count + duplicated_input_frames * input_channels) * sizeof(swap_buffer[0]);
+// Queue mode only: set while launcher music sits in the device queue.
+static std::atomic<bool> launcher_audio_queued{ false };
 
-    int ret = SDL_ConvertAudio(&audio_convert);
+static void discard_launcher_audio() {
+    if (audio_device_mode == AudioDeviceMode::Queue && launcher_audio_queued.exchange(false)) {
+        SDL_ClearQueuedAudio(audio_device);
+    }
+}
 
-    if (ret < 0) {
-        printf("Error using SDL audio converter: %s\n", SDL_GetError());
-        throw std::runtime_error("Error using SDL audio converter");
+void queue_samples(int16_t* audio_data, size_t sample_count) {
+    sssv::timeline::Span span("queue_samples");
+    // The buffer may be the output of an audio task still running on the worker.
+    sssv::audio_worker::wait_idle();
+    if (sssv::benchmark::active()) {
+        return;
     }
+    discard_launcher_audio();
 
-    uint64_t cur_queued_microseconds = uint64_t(SDL_GetQueuedAudioSize(audio_device)) / bytes_per_frame * 1000000 / sample_rate;
-    uint32_t num_bytes_to_queue = audio_convert.len_cvt - output_channels * discarded_output_frames * sizeof(swap_buffer[0]);
-    float* samples_to_queue = swap_buffer.data() + output_channels * discarded_output_frames / 2;
+    uint32_t queued_bytes = get_queued_audio_bytes(audio_ring);
+    sssv::audio_output::update_rate_control(queued_bytes / (output_channels * sizeof(float)));
 
-    uint32_t skip_factor = cur_queued_microseconds / 100000;
+    float cur_main_volume = static_cast<float>(recompui::config::sound::get_main_volume()) / 100.0f;
+    float* samples_to_queue = nullptr;
+    uint64_t call_ns = sssv::audio_stats::record_call();
+    size_t frames_to_queue = sssv::audio_output::process(audio_data, sample_count, cur_main_volume, &samples_to_queue);
+    sssv::audio_stats::record_conversion(call_ns);
+
+    uint64_t cur_queued_microseconds = uint64_t(queued_bytes) / bytes_per_frame * 1000000 / sample_rate;
+    uint32_t num_bytes_to_queue = frames_to_queue * output_channels * sizeof(float);
+    sssv::audio_stats::record_queued_latency(sssv::audio_stats::Stream::Game,
+        uint64_t(queued_bytes) / (output_channels * sizeof(float)) * 1000000 / output_sample_rate);
+
+    // Rate control keeps the queue near its target; skipping only remains as the last resort
+    // for a backlog it cannot absorb (e.g. after a stall).
+    uint32_t skip_threshold_microseconds = sssv::audio_output::rate_control_enabled() ? 250000 : 100000;
+    uint32_t skip_factor = cur_queued_microseconds / skip_threshold_microseconds;
     if (skip_factor != 0) {
         uint32_t skip_ratio = 1 << skip_factor;
         num_bytes_to_queue /= skip_ratio;
-        for (size_t i = 0; i < num_bytes_to_queue / (output_channels * sizeof(swap_buffer[0])); i++) {
+        for (size_t i = 0; i < num_bytes_to_queue / (output_channels * sizeof(float)); i++) {
             samples_to_queue[2 * i + 0] = samples_to_queue[2 * skip_ratio * i + 0];
             samples_to_queue[2 * i + 1] = samples_to_queue[2 * skip_ratio * i + 1];
         }
+        sssv::audio_stats::record_skipped((frames_to_queue - num_bytes_to_queue / (output_channels * sizeof(float))) * output_channels);
     }
 
-    SDL_QueueAudio(audio_device, samples_to_queue, num_bytes_to_queue);
+    push_audio(audio_ring, samples_to_queue, num_bytes_to_queue);
+    sssv::audio_stats::log_periodic();
 }
 
 size_t get_frames_remaining() {
+    // Benchmarks have no audio sink; the game sees the steady state of a rate-controlled queue.
+    if (sssv::benchmark::active()) {
+        return 0;
+    }
     constexpr float buffer_offset_frames = 1.0f;
-    uint64_t buffered_byte_count = SDL_GetQueuedAudioSize(audio_device);
+    uint64_t buffered_byte_count = get_queued_audio_bytes(audio_ring);
 
     buffered_byte_count = buffered_byte_count * 2 * sample_rate / output_sample_rate / output_channels;
 
-    uint32_t frames_per_vi = (sample_rate / 60);
-    if (buffered_byte_count > (buffer_offset_frames * bytes_per_frame * frames_per_vi)) {
-        buffered_byte_count -= (buffer_offset_frames * bytes_per_frame * frames_per_vi);
+    // With rate control the target latency is the device's share of the queue, and the game
+    // only sees what is buffered beyond it.
+    uint64_t offset_byte_count = uint64_t(buffer_offset_frames * bytes_per_frame * (sample_rate / 60));
+    if (sssv::audio_output::rate_control_enabled()) {
+        offset_byte_count = uint64_t(bytes_per_frame) * sample_rate * sssv::audio_output::target_latency_ms() / 1000;
+    }
+    if (buffered_byte_count > offset_byte_count) {
+        buffered_byte_count -= offset_byte_count;
     }
     else {
         buffered_byte_count = 0;
@@ -236,14 +356,7 @@ size_t get_frames_remaining() {
 }
 
 void update_audio_converter() {
-    int ret = SDL_BuildAudioCVT(&audio_convert, AUDIO_F32, input_channels, sample_rate, AUDIO_F32, output_channels, output_sample_rate);
-
-    if (ret < 0) {
-        printf("Error creating SDL audio converter: %s\n", SDL_GetError());
-        throw std::runtime_error("Error creating SDL audio converter");
-    }
-
-    discarded_output_frames = duplicated_input_frames * output_sample_rate / sample_rate;
+    sssv::audio_output::configure(sample_rate, output_sample_rate);
 }
 
 void set_frequency(uint32_t freq) {
@@ -252,19 +365,7 @@ void set_frequency(uint32_t freq) {
 }
 
 bool reset_audio(uint32_t output_freq) {
-    SDL_AudioSpec spec_desired{
-        .freq = (int)output_freq,
-        .format = AUDIO_F32,
-        .channels = (Uint8)output_channels,
-        .silence = 0,
-        .samples = 0x100,
-        .padding = 0,
-        .size = 0,
-        .callback = nullptr,
-        .userdata = nullptr
-    };
-
-    audio_device = SDL_OpenAudioDevice(nullptr, false, &spec_desired, nullptr, 0);
+    audio_device = open_audio_device(output_freq);
     if (audio_device == 0) {
         std::string audio_error = std::string("No audio device could be found. Please make sure an audio device is available.\nError opening audio device: ") + std::string(SDL_GetError());
         recompui::message_box(audio_error.c_str());
@@ -280,78 +381,54 @@ bool reset_audio(uint32_t output_freq) {
 }
 
 namespace {
-bool ensure_launcher_audio_device() {
-    if (launcher_audio_device != 0) {
-        return true;
-    }
-    if (launcher_audio_failed) {
-        return false;
-    }
-
-    SDL_AudioSpec spec_desired{
-        .freq = (int)output_sample_rate,
-        .format = AUDIO_F32,
-        .channels = (Uint8)output_channels,
-        .silence = 0,
-        .samples = 0x100,
-        .padding = 0,
-        .size = 0,
-        .callback = nullptr,
-        .userdata = nullptr
-    };
-
-    launcher_audio_device = SDL_OpenAudioDevice(nullptr, false, &spec_desired, nullptr, 0);
-    if (launcher_audio_device == 0) {
-        printf("Launcher BGM: failed to open audio device: %s\n", SDL_GetError());
-        launcher_audio_failed = true;
-        return false;
-    }
-
-    SDL_PauseAudioDevice(launcher_audio_device, 1);
-    launcher_audio_sample_rate = output_sample_rate;
-    launcher_audio_channels = output_channels;
-    return true;
-}
+// Launcher music left in the ring when the game starts fades out under the game audio (pull
+// mode; queue mode drops it).
+constexpr uint32_t launcher_fade_ms = 250;
 
 bool launcher_start_playback() {
-    if (!ensure_launcher_audio_device()) {
+    if (audio_device == 0) {
         return false;
     }
-    SDL_ClearQueuedAudio(launcher_audio_device);
-    SDL_PauseAudioDevice(launcher_audio_device, 0);
+    clear_queued_audio(launcher_audio_ring);
+    audio_mixer.set_gain(launcher_source, 1.0f, 0);
     return true;
 }
 
 void launcher_stop_playback() {
-    if (launcher_audio_device == 0) {
+    if (audio_device == 0) {
         return;
     }
-    SDL_ClearQueuedAudio(launcher_audio_device);
-    SDL_PauseAudioDevice(launcher_audio_device, 1);
+    sssv::audio_stats::record_stopped(sssv::audio_stats::Stream::Launcher);
+    audio_mixer.set_gain(launcher_source, 0.0f, output_sample_rate * launcher_fade_ms / 1000);
+    discard_launcher_audio();
 }
 
 uint32_t launcher_get_queued_ms() {
-    if (!ensure_launcher_audio_device() || launcher_audio_sample_rate == 0 || launcher_audio_channels == 0) {
-        return 0;
-    }
-    const uint32_t frame_bytes = launcher_audio_channels * sizeof(float);
-    if (frame_bytes == 0) {
+    if (audio_device == 0) {
         return 0;
     }
-    uint32_t queued_bytes = SDL_GetQueuedAudioSize(launcher_audio_device);
-    uint32_t queued_frames = queued_bytes / frame_bytes;
-    return (queued_frames * 1000) / launcher_audio_sample_rate;
+    const uint32_t frame_bytes = output_channels * sizeof(float);
+    uint32_t queued_frames = get_queued_audio_bytes(launcher_audio_ring) / frame_bytes;
+    return (queued_frames * 1000) / output_sample_rate;
 }
 
 bool launcher_queue_audio(const float* samples, size_t frames) {
-    if (!ensure_launcher_audio_device()) {
+    if (audio_device == 0) {
         return false;
     }
     if (frames == 0) {
         return true;
     }
-    const uint32_t bytes = static_cast<uint32_t>(frames * launcher_audio_channels * sizeof(float));
-    SDL_QueueAudio(launcher_audio_device, samples, bytes);
+    const uint32_t frame_bytes = output_channels * sizeof(float);
+    const uint32_t queued_frames = get_queued_audio_bytes(launcher_audio_ring) / frame_bytes;
+    sssv::audio_stats::record_queued_latency(sssv::audio_stats::Stream::Launcher,
+        uint64_t(queued_frames) * 1000000 / output_sample_rate);
+    const uint32_t bytes = static_cast<uint32_t>(frames * frame_bytes);
+    push_audio(launcher_audio_ring, samples, bytes);
+    if (audio_device_mode == AudioDeviceMode::Queue) {
+        launcher_audio_queued = true;
+    }
+    sssv::audio_stats::log_periodic();
     return true;
 }
 
@@ -364,14 +441,6 @@ bool launcher_game_started() {
     return ultramodern::is_game_started();
 }
 
-void shutdown_launcher_audio_device() {
-    if (launcher_audio_device != 0) {
-        SDL_CloseAudioDevice(launcher_audio_device);
-        launcher_audio_device = 0;
-    }
-    launcher_audio_failed = false;
-}
-
 enum class UnknownGBIFallback {
     None,
     F3DEX,
@@ -473,10 +542,49 @@ void apply_unknown_gbi_fallback(RT64::Application* app, UnknownGBIFallback fallb
     }
 }
 
+// Benchmark renderer (--benchmark-null-renderer): display lists are dropped, so a run measures
+// the game, the billboard rewrite and audio without the GPU or the window's present.
+class NullRendererContext final : public ultramodern::renderer::RendererContext {
+public:
+    bool valid() override {
+        return true;
+    }
+
+    ultramodern::renderer::SetupResult get_setup_result() const override {
+        return ultramodern::renderer::SetupResult::Success;
+    }
+
+    ultramodern::renderer::GraphicsApi get_chosen_api() const override {
+        return ultramodern::renderer::GraphicsApi::Auto;
+    }
+
+    bool update_config(const ultramodern::renderer::GraphicsConfig&, const ultramodern::renderer::GraphicsConfig&) override {
+        return true;
+    }
+
+    void enable_instant_present() override {}
+    void send_dl(const OSTask*) override {}
+    void send_dummy_workload(uint32_t) override {}
+    void update_screen() override {}
+    void shutdown() override {}
+
+    uint32_t get_display_framerate() const override {
+        return 60;
+    }
+
+    float get_resolution_scale() const override {
+        return 1.0f;
+    }
+};
+
 class RT64CompatContext final : public ultramodern::renderer::RendererContext {
 public:
     RT64CompatContext(std::unique_ptr<ultramodern::renderer::RendererContext> inner_context, uint8_t* rdram)
-        : inner(std::move(inner_context)), rdram(rdram) {}
+        : inner(std::move(inner_context)), rdram(rdram),
+          rt64_context(dynamic_cast<recompui::renderer::RT64Context*>(inner.get())) {
+        // ultramodern creates the context on the thread that then submits to it.
+        sssv::timeline::name_current_thread("Render");
+    }
 
     bool valid() override {
         return inner != nullptr && inner->valid();
@@ -499,6 +607,11 @@ public:
     }
 
     void send_dl(const OSTask* task) override {
+        sssv::timeline::Span span("send_dl");
+        // Deferred billboards still have placeholder quads in this display list, and
+        // texture-sorted ones are not in it yet.
+        sssv::billboard::on_display_list_submit(rdram, static_cast<uint32_t>(task->t.data_ptr));
+        sssv::benchmark::on_display_list();
         maybe_apply_unknown_ucode_fallback(task);
         inner->send_dl(task);
     }
@@ -508,6 +621,7 @@ public:
     }
 
     void update_screen() override {
+        sssv::timeline::Span span("update_screen");
         inner->update_screen();
     }
 
@@ -524,27 +638,76 @@ public:
     }
 
 private:
+    // A game only uses a handful of graphics ucodes, so the classification of each is cached
+    // by its text and data addresses. The checksum over the start of the data segment catches
+    // a different ucode loaded at the same address.
+    struct UcodeClass {
+        uint32_t ucode = 0;
+        uint32_t ucode_data = 0;
+        uint32_t checksum = 0;
+        UnknownGBIFallback fallback = UnknownGBIFallback::None;
+        std::string name;
+    };
+    static constexpr size_t ucode_cache_size = 8;
+    static constexpr uint32_t checksum_words = 16;
+
     std::unique_ptr<ultramodern::renderer::RendererContext> inner;
     uint8_t* rdram = nullptr;
+    recompui::renderer::RT64Context* rt64_context = nullptr;
     UnknownGBIFallback active_fallback = UnknownGBIFallback::None;
+    std::array<UcodeClass, ucode_cache_size> ucode_cache{};
+    size_t ucode_cache_count = 0;
+    size_t ucode_cache_next = 0;
+
+    uint32_t ucode_data_checksum(uint32_t data_address) const {
+        uint32_t hash = 2166136261u;
+        for (uint32_t i = 0; i < checksum_words; i++) {
+            uint32_t word;
+            std::memcpy(&word, rdram + ((data_address + i * 4) & 0x7FFFFC), sizeof(word));
+            hash = (hash ^ word) * 16777619u;
+        }
+        return hash;
+    }
+
+    const UcodeClass& classify_ucode(const OSTask* task) {
+        const uint32_t ucode = static_cast<uint32_t>(task->t.ucode);
+        const uint32_t ucode_data = static_cast<uint32_t>(task->t.ucode_data);
+        const uint32_t checksum = ucode_data_checksum(ucode_data & 0x3FFFFFF);
+        for (size_t i = 0; i < ucode_cache_count; i++) {
+            const UcodeClass& entry = ucode_cache[i];
+            if (entry.ucode == ucode && entry.ucode_data == ucode_data && entry.checksum == checksum) {
+                return entry;
+            }
+        }
+
+        // Miss: read the name and classify it, replacing the oldest entry once the cache is full.
+        UcodeClass& entry = ucode_cache[ucode_cache_next];
+        ucode_cache_next = (ucode_cache_next + 1) % ucode_cache_size;
+        if (ucode_cache_count < ucode_cache_size) {
+            ucode_cache_count++;
+        }
+        entry.ucode = ucode;
+        entry.ucode_data = ucode_data;
+        entry.checksum = checksum;
+        entry.fallback = get_unknown_gbi_fallback(rdram, task, &entry.name);
+        // Match the lib_modified behavior: default Unknown ucode path to F3DEX for SSSV.
+        if (entry.fallback == UnknownGBIFallback::None) {
+            entry.fallback = UnknownGBIFallback::F3DEX;
+        }
+        return entry;
+    }
 
     void maybe_apply_unknown_ucode_fallback(const OSTask* task) {
         if (task == nullptr || task->t.type != M_GFXTASK) {
             return;
         }
 
-        auto* rt64_context = dynamic_cast<recompui::renderer::RT64Context*>(inner.get());
-        if (rt64_context == nullptr || rt64_context->app == nullptr) {
+        if (rt64_context == nullptr || rt64_context->app == nullptr || rdram == nullptr) {
             return;
         }
 
-        std::string ucode_name;
-        UnknownGBIFallback fallback = get_unknown_gbi_fallback(rdram, task, &ucode_name);
-        // Match the lib_modified behavior: default Unknown ucode path to F3DEX for SSSV.
-        if (fallback == UnknownGBIFallback::None) {
-            fallback = UnknownGBIFallback::F3DEX;
-        }
-
+        const UcodeClass& ucode_class = classify_ucode(task);
+        const UnknownGBIFallback fallback = ucode_class.fallback;
         if (fallback == active_fallback) {
             return;
         }
@@ -553,11 +716,11 @@ private:
         active_fallback = fallback;
 
         const char* fallback_name = (fallback == UnknownGBIFallback::F3DEX) ? "F3DEX" : "S2DEX";
-        if (ucode_name.empty()) {
+        if (ucode_class.name.empty()) {
             fprintf(stderr, "[SSSV] RT64 unknown ucode fallback -> %s (default)\n", fallback_name);
         }
         else {
-            fprintf(stderr, "[SSSV] RT64 unknown ucode fallback -> %s for \"%s\"\n", fallback_name, ucode_name.c_str());
+            fprintf(stderr, "[SSSV] RT64 unknown ucode fallback -> %s for \"%s\"\n", fallback_name, ucode_class.name.c_str());
         }
     }
 };
@@ -566,10 +729,29 @@ private:
 // RSP microcode - SSSV uses audio RSP
 extern RspUcodeFunc aspMain;
 
+// Benchmarks run audio tasks on the game thread so their time is measured directly.
+RspExitReason timed_audio_task(uint8_t* rdram, uint32_t ucode_addr) {
+    const auto start = std::chrono::steady_clock::now();
+    const RspExitReason reason = sssv::audio_hle::run_task(rdram, ucode_addr);
+    sssv::benchmark::record_audio_task(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+    return reason;
+}
+
 RspUcodeFunc* get_rsp_microcode(const OSTask* task) {
     switch (task->t.type) {
     case M_AUDTASK:
-        return aspMain;
+        // A previous audio task still running on the worker owns DMEM, which librecomp is
+        // about to load this task into.
+        sssv::audio_worker::wait_idle();
+        if (sssv::benchmark::active()) {
+            return timed_audio_task;
+        }
+        if (sssv::audio_worker::enabled()) {
+            return sssv::audio_worker::submit_task;
+        }
+        // Runs aspMain itself unless the audio HLE is enabled.
+        return sssv::audio_hle::run_task;
 
     default:
         fprintf(stderr, "Unknown task: %" PRIu32 "\n", task->t.type);
@@ -682,6 +864,9 @@ bool preload_executable(PreloadContext& context) {
     return true;
 }
 
+// The whole view is already locked.
+void lock_preloaded_code(PreloadContext& context) {}
+
 void release_preload(PreloadContext& context) {
     VirtualUnlock(context.view, context.size);
     CloseHandle(context.mapping_handle);
@@ -719,15 +904,179 @@ static LONG WINAPI top_level_exception_filter(EXCEPTION_POINTERS* info) {
     return EXCEPTION_EXECUTE_HANDLER;
 }
 
-#elif defined(__linux__) || defined(APPLE)
+#elif defined(__linux__) || defined(__APPLE__)
 
-struct PreloadContext {};
+// The executable is mapped and read ahead so the recompiled code's pages are in the page
+// cache before the game first runs them; faults on the real text mapping are then minor.
+// Once the app folder is known, lock_preloaded_code locks the functions listed in the
+// profiler's hot_funcs.txt there, synchronously, since they run right away and are only a few
+// pages. Locking the whole image takes a while and RLIMIT_MEMLOCK is often too small for it
+// (e.g. unprivileged on the Steam Deck), so it runs on a background thread only when the limit
+// allows and is skipped otherwise.
+struct PreloadContext {
+    int fd = -1;
+    void* view = nullptr;
+    size_t size = 0;
+    size_t lock_limit = SIZE_MAX;
+    std::vector<sssv::HostCodeRange> locked_code;
+    // Joined before the view is unmapped, or on any early exit from main.
+    std::jthread lock_thread;
+};
+
+static std::filesystem::path get_executable_path() {
+#if defined(__APPLE__)
+    uint32_t path_size = 0;
+    _NSGetExecutablePath(nullptr, &path_size);
+    std::string path(path_size, '\0');
+    if (_NSGetExecutablePath(path.data(), &path_size) != 0) {
+        return {};
+    }
+    return std::filesystem::path(path.c_str());
+#else
+    std::error_code ec;
+    std::filesystem::path path = std::filesystem::read_symlink("/proc/self/exe", ec);
+    return ec ? std::filesystem::path{} : path;
+#endif
+}
+
+// One function ROM address per line in hex ("%08X # name..."), '#' starts a comment. Older
+// lists held vram addresses instead; those match no ROM address and lock nothing.
+static std::vector<uint32_t> read_hot_function_list(const std::filesystem::path& path) {
+    std::vector<uint32_t> roms;
+    std::ifstream stream(path);
+    std::string line;
+    while (std::getline(stream, line)) {
+        const char* text = line.c_str();
+        char* end = nullptr;
+        unsigned long rom = strtoul(text, &end, 16);
+        if (end != text) {
+            roms.push_back(static_cast<uint32_t>(rom));
+        }
+    }
+    std::sort(roms.begin(), roms.end());
+    return roms;
+}
+
+// Returns the number of bytes locked.
+static size_t lock_hot_functions(PreloadContext& context, size_t lock_budget) {
+    // Written by the sampling profiler (Debug tab) on this machine.
+    std::vector<uint32_t> roms = read_hot_function_list(recompui::file::get_app_folder_path() / "hot_funcs.txt");
+    if (roms.empty()) {
+        return 0;
+    }
+
+    const uintptr_t page_mask = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE)) - 1;
+    size_t locked_bytes = 0;
+    const std::vector<sssv::HostCodeRange> ranges = sssv::find_function_host_code(roms);
+    for (const sssv::HostCodeRange& range : ranges) {
+        const uintptr_t begin = reinterpret_cast<uintptr_t>(range.begin) & ~page_mask;
+        const uintptr_t end = (reinterpret_cast<uintptr_t>(range.begin) + range.size + page_mask) & ~page_mask;
+        void* pages = reinterpret_cast<void*>(begin);
+        if ((locked_bytes + (end - begin) <= lock_budget) && (mlock(pages, end - begin) == 0)) {
+            context.locked_code.push_back({ pages, end - begin });
+            locked_bytes += end - begin;
+        }
+        else {
+            // Out of lockable memory: still fault the pages in now.
+            madvise(pages, end - begin, MADV_WILLNEED);
+            for (uintptr_t page = begin; page < end; page += page_mask + 1) {
+                (void)*reinterpret_cast<const volatile uint8_t*>(page);
+            }
+        }
+    }
+    printf("[SSSV] Prefaulted %zu of %zu hot functions (%zu KB locked)\n", ranges.size(), roms.size(), locked_bytes / 1024);
+    return locked_bytes;
+}
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+// Asks for transparent huge pages on the executable's text. Only takes effect on kernels
+// that can back read-only file mappings with huge pages; failure is harmless.
+static void advise_text_huge_pages() {
+    dl_iterate_phdr([](struct dl_phdr_info* info, size_t, void*) -> int {
+        // The first object is the executable itself.
+        for (ElfW(Half) i = 0; i < info->dlpi_phnum; i++) {
+            const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+            if (phdr.p_type != PT_LOAD || (phdr.p_flags & PF_X) == 0) {
+                continue;
+            }
+            constexpr uintptr_t huge_page = 2 * 1024 * 1024;
+            const uintptr_t begin = (info->dlpi_addr + phdr.p_vaddr + huge_page - 1) & ~(huge_page - 1);
+            const uintptr_t end = (info->dlpi_addr + phdr.p_vaddr + phdr.p_memsz) & ~(huge_page - 1);
+            if (end > begin) {
+                madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE);
+            }
+        }
+        return 1;
+    }, nullptr);
+}
+#else
+static void advise_text_huge_pages() {}
+#endif
 
 bool preload_executable(PreloadContext& context) {
+    std::filesystem::path executable = get_executable_path();
+    context.fd = open(executable.c_str(), O_RDONLY);
+    if (context.fd < 0) {
+        fprintf(stderr, "Failed to load executable into memory!");
+        context = {};
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(context.fd, &st) != 0 || st.st_size <= 0) {
+        fprintf(stderr, "Failed to get size of executable!");
+        close(context.fd);
+        context = {};
+        return false;
+    }
+    context.size = static_cast<size_t>(st.st_size);
+
+    context.view = mmap(nullptr, context.size, PROT_READ, MAP_SHARED, context.fd, 0);
+    if (context.view == MAP_FAILED) {
+        fprintf(stderr, "Failed to map view of executable!");
+        close(context.fd);
+        context = {};
+        return false;
+    }
+
+    struct rlimit limit{};
+    if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+        context.lock_limit = static_cast<size_t>(limit.rlim_cur);
+    }
+
+    advise_text_huge_pages();
+    madvise(context.view, context.size, MADV_WILLNEED);
     return true;
 }
 
-void release_preload(PreloadContext& context) {}
+// Needs the program id to be set, for the app folder.
+void lock_preloaded_code(PreloadContext& context) {
+    size_t hot_locked = lock_hot_functions(context, context.lock_limit);
+
+    if (context.lock_limit >= context.size + hot_locked) {
+        context.lock_thread = std::jthread([view = context.view, size = context.size]() {
+            if (mlock(view, size) != 0) {
+                fprintf(stderr, "Failed to lock view of executable! (errno %d)\n", errno);
+            }
+        });
+    }
+    else {
+        printf("[SSSV] RLIMIT_MEMLOCK (%zu KB) is too small to lock the executable; reading it ahead only\n", context.lock_limit / 1024);
+    }
+}
+
+void release_preload(PreloadContext& context) {
+    if (context.lock_thread.joinable()) {
+        context.lock_thread.join();
+    }
+    for (const sssv::HostCodeRange& range : context.locked_code) {
+        munlock(range.begin, range.size);
+    }
+    munlock(context.view, context.size);
+    munmap(context.view, context.size);
+    close(context.fd);
+    context = {};
+}
 
 #else
 
@@ -737,15 +1086,20 @@ bool preload_executable(PreloadContext& context) {
     return false;
 }
 
+void lock_preloaded_code(PreloadContext& context) {}
+
 void release_preload(PreloadContext& context) {}
 
 #endif
 
 void enable_texture_pack(recomp::mods::ModContext& context, const recomp::mods::ModHandle& mod) {
+    // RT64 indexes the pack in here; the read-ahead starts after, for the level streaming.
     recompui::renderer::enable_texture_pack(context, mod);
+    sssv::texture_pack_warmer::warm(mod.manifest.mod_root_path);
 }
 
 void disable_texture_pack(recomp::mods::ModContext&, const recomp::mods::ModHandle& mod) {
+    sssv::texture_pack_warmer::cancel(mod.manifest.mod_root_path);
     recompui::renderer::disable_texture_pack(mod);
 }
 
@@ -754,6 +1108,11 @@ void reorder_texture_pack(recomp::mods::ModContext&) {
 }
 
 void on_launcher_init(recompui::LauncherMenu* menu) {
+    if (sssv::benchmark::active()) {
+        recomp::start_game(supported_games[0].game_id);
+        return;
+    }
+
     auto game_options_menu = menu->init_game_options_menu(
         supported_games[0].game_id,
         supported_games[0].mod_game_id,
@@ -798,8 +1157,6 @@ void on_launcher_init(recompui::LauncherMenu* menu) {
 }
 
 int main(int argc, char** argv) {
-    (void)argc;
-    (void)argv;
 
     recomp::Version project_version{};
     if (!recomp::Version::from_string(version_string, project_version)) {
@@ -839,6 +1196,28 @@ int main(int argc, char** argv) {
     SDL_setenv("SDL_AUDIODRIVER", "wasapi", true);
 #endif
 
+    if (!sssv::benchmark::parse_args(argc, argv)) {
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--audio-latency-ms") == 0 && i + 1 < argc) {
+            sssv::audio_output::set_target_latency_ms(static_cast<uint32_t>(std::max(1, atoi(argv[++i]))));
+        }
+        else if (strcmp(argv[i], "--audio-device-mode") == 0 && i + 1 < argc) {
+            const char* mode = argv[++i];
+            if (strcmp(mode, "pull") == 0) {
+                audio_device_mode = AudioDeviceMode::Pull;
+            }
+            else if (strcmp(mode, "queue") == 0) {
+                audio_device_mode = AudioDeviceMode::Queue;
+            }
+            else {
+                fprintf(stderr, "Unknown --audio-device-mode %s (expected queue or pull)\n", mode);
+            }
+        }
+    }
+
 #if defined(__linux__) && defined(RECOMP_FLATPAK)
     std::error_code ec;
     std::filesystem::current_path("/var/data", ec);
@@ -849,6 +1228,10 @@ int main(int argc, char** argv) {
     recompui::programconfig::set_program_name(sssv::program_name);
     recompui::programconfig::set_program_id(sssv::program_id);
 
+    if (preloaded) {
+        lock_preloaded_code(preload_context);
+    }
+
     SDL_InitSubSystem(SDL_INIT_AUDIO);
     if (!reset_audio(48000)) {
         return EXIT_FAILURE;
@@ -880,7 +1263,7 @@ int main(int argc, char** argv) {
 
     // Initialize launcher music with Cellenseres SDK
     csdk::launcher_music::init(launcher_music_config, launcher_music_callbacks);
-    csdk::launcher_music::set_enabled(true);
+    csdk::launcher_music::set_enabled(!sssv::benchmark::active());
 
     recomp::register_config_path(recompui::file::get_app_folder_path());
 
@@ -889,17 +1272,22 @@ int main(int argc, char** argv) {
     }
 
     recompui::register_ui_exports();
+    sssv::register_mod_exports();
 
     recomptheme::set_custom_theme();
 
     sssv::register_overlays();
+    sssv::register_trophy_collision_patch();
+    sssv::billboard::refresh_hooks();
 
     recompinput::players::set_single_player_mode(true);
 
     sssv::init_config();
 
     recompui::register_launcher_init_callback(on_launcher_init);
-    recompui::register_launcher_update_callback(sssv::launcher_animation_update);
+    if (!sssv::benchmark::active()) {
+        recompui::register_launcher_update_callback(sssv::launcher_animation_update);
+    }
 
     recomp::rsp::callbacks_t rsp_callbacks{
         .get_rsp_microcode = get_rsp_microcode,
@@ -908,6 +1296,9 @@ int main(int argc, char** argv) {
     ultramodern::renderer::callbacks_t renderer_callbacks{
         .create_render_context = [](uint8_t* rdram, ultramodern::renderer::WindowHandle window_handle, bool developer_mode) -> std::unique_ptr<ultramodern::renderer::RendererContext> {
             auto presentation_mode = ultramodern::renderer::PresentationMode::PresentEarly;
+            if (sssv::benchmark::null_renderer()) {
+                return std::make_unique<RT64CompatContext>(std::make_unique<NullRendererContext>(), rdram);
+            }
             auto inner_context = recompui::renderer::create_render_context(rdram, window_handle, presentation_mode, developer_mode);
             return std::make_unique<RT64CompatContext>(std::move(inner_context), rdram);
         },
@@ -926,14 +1317,25 @@ int main(int argc, char** argv) {
     };
 
     ultramodern::input::callbacks_t input_callbacks{
-        .poll_input = recompinput::poll_inputs,
-        .get_input = recompinput::profiles::get_n64_input,
+        .poll_input = [] {
+            sssv::benchmark::on_input_poll();
+            recompinput::poll_inputs();
+        },
+        .get_input = [](int controller_num, uint16_t* buttons, float* x, float* y) {
+            return sssv::benchmark::get_input(controller_num, buttons, x, y, recompinput::profiles::get_n64_input);
+        },
         .set_rumble = recompinput::set_rumble,
         .get_connected_device_info = get_connected_device_info,
     };
 
     ultramodern::events::callbacks_t thread_callbacks{
-        .vi_callback = recompinput::update_rumble,
+        .vi_callback = [] {
+            sssv::timeline::Span span("vi");
+            recompinput::update_rumble();
+            if (sssv::benchmark::on_vi()) {
+                ultramodern::quit();
+            }
+        },
         .gfx_init_callback = nullptr,
     };
 
@@ -969,8 +1371,11 @@ int main(int argc, char** argv) {
         threads_callbacks
     );
 
+    sssv::audio_worker::shutdown();
+    sssv::texture_pack_warmer::shutdown();
+    sssv::shutdown_code_prefetch();
+    sssv::benchmark::shutdown();
     csdk::launcher_music::shutdown();
-    shutdown_launcher_audio_device();
 
     NFD_Quit();
 
@@ -1,3 +1,17 @@
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include "sssv_game.h"
 #include "librecomp/overlays.hpp"
 
@@ -6,6 +20,172 @@
 
 namespace sssv {
 
+namespace {
+
+// Every recompiled function's host address, sorted. A function's host code ends where the
+// next one starts.
+const std::vector<uintptr_t>& host_code_starts() {
+    static const std::vector<uintptr_t> starts = [] {
+        std::vector<uintptr_t> out;
+        for (const SectionTableEntry& section : section_table) {
+            for (size_t i = 0; i < section.num_funcs; i++) {
+                out.push_back(reinterpret_cast<uintptr_t>(section.funcs[i].func));
+            }
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return out;
+    }();
+    return starts;
+}
+
+// Only for the function placed last, which has no next start: recompiled C is several times
+// the size of the MIPS it came from.
+constexpr size_t host_bytes_per_rom_byte = 8;
+
+HostCodeRange host_code(const FuncEntry& func) {
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(func.func);
+    const std::vector<uintptr_t>& starts = host_code_starts();
+    const auto next = std::upper_bound(starts.begin(), starts.end(), begin);
+    const size_t size = next != starts.end() ? size_t(*next - begin) : size_t(func.rom_size) * host_bytes_per_rom_byte;
+    return { reinterpret_cast<const void*>(begin), size };
+}
+
+// Every game DMA goes through the dma_read hook, and nearly all of them are asset data. The
+// code sections' ROM ranges are indexed once so those are turned away with two lookups in a
+// per-page prefix count, and only DMAs that touch code reach librecomp's load_overlays.
+constexpr uint32_t rom_page_shift = 12;
+
+struct CodeSection {
+    uint32_t rom_begin;
+    uint32_t rom_end;
+    HostCodeRange host; // from the first function's host code to the end of the last one's
+};
+
+std::vector<CodeSection> code_sections;      // sorted by rom_begin
+std::vector<uint32_t> code_pages_before;     // code pages in [0, page), one entry per ROM page + 1
+
+void build_code_index() {
+    code_sections.clear();
+    uint32_t rom_end = 0;
+    for (const SectionTableEntry& section : section_table) {
+        uintptr_t host_begin = UINTPTR_MAX;
+        uintptr_t host_end = 0;
+        for (size_t i = 0; i < section.num_funcs; i++) {
+            const HostCodeRange func = host_code(section.funcs[i]);
+            host_begin = std::min(host_begin, reinterpret_cast<uintptr_t>(func.begin));
+            host_end = std::max(host_end, reinterpret_cast<uintptr_t>(func.begin) + func.size);
+        }
+        const HostCodeRange host = host_end > host_begin
+            ? HostCodeRange{ reinterpret_cast<const void*>(host_begin), size_t(host_end - host_begin) }
+            : HostCodeRange{ nullptr, 0 };
+        code_sections.push_back({ section.rom_addr, section.rom_addr + section.size, host });
+        rom_end = std::max(rom_end, section.rom_addr + std::max<uint32_t>(section.size, 1));
+    }
+    std::sort(code_sections.begin(), code_sections.end(),
+        [](const CodeSection& a, const CodeSection& b) { return a.rom_begin < b.rom_begin; });
+
+    const size_t page_count = (size_t(rom_end) >> rom_page_shift) + 1;
+    std::vector<uint8_t> is_code(page_count, 0);
+    for (const CodeSection& section : code_sections) {
+        // load_overlays matches sections by their start, so even an empty one marks its page.
+        const uint32_t last_byte = std::max(section.rom_end, section.rom_begin + 1) - 1;
+        for (uint32_t page = section.rom_begin >> rom_page_shift; page <= (last_byte >> rom_page_shift); page++) {
+            is_code[page] = 1;
+        }
+    }
+    code_pages_before.assign(page_count + 1, 0);
+    for (size_t page = 0; page < page_count; page++) {
+        code_pages_before[page + 1] = code_pages_before[page] + is_code[page];
+    }
+}
+
+bool touches_code(uint32_t rom, uint32_t size) {
+    if (size == 0 || code_pages_before.empty()) {
+        return false;
+    }
+    const size_t page_count = code_pages_before.size() - 1;
+    const size_t first = std::min<size_t>(rom >> rom_page_shift, page_count);
+    const size_t last = std::min<size_t>(((uint64_t(rom) + size - 1) >> rom_page_shift) + 1, page_count);
+    return code_pages_before[last] > code_pages_before[first];
+}
+
+// Reads the host code of the sections a DMA just loaded into memory ahead, so the game's first
+// calls into them take soft faults instead of waiting on the disk. Level overlays are loaded
+// behind the transition screen, so this overlaps with it. A section's functions are compiled
+// next to each other, so each section is one span and takes one call; the calls are made on
+// a helper thread so the dma_read hook only queues the spans.
+struct Prefetcher {
+    std::mutex mutex;
+    std::condition_variable queue_ready;
+    std::thread thread;
+    std::vector<HostCodeRange> queue;
+    bool stopping = false;
+};
+
+Prefetcher prefetcher;
+
+void prefetch(const std::vector<HostCodeRange>& spans) {
+#if defined(_WIN32)
+    std::vector<WIN32_MEMORY_RANGE_ENTRY> ranges;
+    for (const HostCodeRange& span : spans) {
+        ranges.push_back({ const_cast<void*>(span.begin), span.size });
+    }
+    PrefetchVirtualMemory(GetCurrentProcess(), ranges.size(), ranges.data(), 0);
+#else
+    const uintptr_t page_mask = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE)) - 1;
+    for (const HostCodeRange& span : spans) {
+        const uintptr_t begin = reinterpret_cast<uintptr_t>(span.begin) & ~page_mask;
+        const uintptr_t end = (reinterpret_cast<uintptr_t>(span.begin) + span.size + page_mask) & ~page_mask;
+        madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+    }
+#endif
+}
+
+void prefetch_main() {
+    std::vector<HostCodeRange> spans;
+    std::unique_lock lock(prefetcher.mutex);
+    while (true) {
+        prefetcher.queue_ready.wait(lock, [] { return !prefetcher.queue.empty() || prefetcher.stopping; });
+        if (prefetcher.stopping) {
+            return;
+        }
+        spans.swap(prefetcher.queue);
+        lock.unlock();
+        prefetch(spans);
+        spans.clear();
+        lock.lock();
+    }
+}
+
+void prefetch_section_code(uint32_t rom, uint32_t size) {
+    const uint32_t rom_end = rom + size;
+    auto it = std::upper_bound(code_sections.begin(), code_sections.end(), rom,
+        [](uint32_t addr, const CodeSection& section) { return addr < section.rom_begin; });
+    if (it != code_sections.begin()) {
+        --it;
+    }
+    std::lock_guard lock(prefetcher.mutex);
+    if (prefetcher.stopping) {
+        return;
+    }
+    const size_t queued = prefetcher.queue.size();
+    for (; it != code_sections.end() && it->rom_begin < rom_end; ++it) {
+        if (it->rom_end > rom && it->host.size != 0) {
+            prefetcher.queue.push_back(it->host);
+        }
+    }
+    if (prefetcher.queue.size() == queued) {
+        return;
+    }
+    if (!prefetcher.thread.joinable()) {
+        prefetcher.thread = std::thread(prefetch_main);
+    }
+    prefetcher.queue_ready.notify_one();
+}
+
+} // namespace
+
 void register_overlays() {
     recomp::overlays::overlay_section_table_data_t sections{
         .code_sections = section_table,
@@ -18,7 +198,58 @@ void register_overlays() {
         .len = ARRLEN(overlay_sections_by_index),
     };
 
+    build_code_index();
     recomp::overlays::register_overlays(sections, overlays);
 }
 
+std::vector<HostCodeRange> find_function_host_code(std::span<const uint32_t> sorted_roms) {
+    std::vector<HostCodeRange> ranges;
+    for (const SectionTableEntry& section : section_table) {
+        for (size_t i = 0; i < section.num_funcs; i++) {
+            const FuncEntry& func = section.funcs[i];
+            const uint32_t rom = section.rom_addr + func.offset;
+            if (std::binary_search(sorted_roms.begin(), sorted_roms.end(), rom)) {
+                ranges.push_back(host_code(func));
+            }
+        }
+    }
+    return ranges;
+}
+
+void shutdown_code_prefetch() {
+    {
+        std::lock_guard lock(prefetcher.mutex);
+        prefetcher.stopping = true;
+        prefetcher.queue_ready.notify_one();
+    }
+    if (prefetcher.thread.joinable()) {
+        prefetcher.thread.join();
+    }
+}
+
+std::vector<RecompiledFunction> get_recompiled_functions() {
+    std::vector<RecompiledFunction> functions;
+    for (const SectionTableEntry& section : section_table) {
+        for (size_t i = 0; i < section.num_funcs; i++) {
+            const FuncEntry& func = section.funcs[i];
+            functions.push_back({
+                reinterpret_cast<const void*>(func.func),
+                section.ram_addr + func.offset,
+                section.rom_addr + func.offset,
+                section.rom_addr
+            });
+        }
+    }
+    return functions;
+}
+
 } // namespace sssv
+
+// dma_read hook (sssv.us.toml).
+extern "C" void sssv_load_overlays(uint32_t rom, int32_t ram_addr, uint32_t size) {
+    if (!sssv::touches_code(rom, size)) {
+        return;
+    }
+    load_overlays(rom, ram_addr, size);
+    sssv::prefetch_section_code(rom, size);
+}
@@ -0,0 +1,210 @@
+#include "texture_pack_warmer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace sssv::texture_pack_warmer {
+
+namespace {
+
+constexpr size_t chunk_bytes = 4 * 1024 * 1024;
+// Zip central directories of even very large packs fit in this.
+constexpr uint64_t tail_bytes = 64ull * 1024 * 1024;
+constexpr uint64_t max_budget_bytes = 4ull * 1024 * 1024 * 1024;
+
+struct Worker {
+    std::mutex mutex;
+    std::condition_variable queue_ready;
+    std::thread thread;
+    std::deque<std::filesystem::path> queue;
+    std::filesystem::path current;
+    bool cancel_current = false;
+    bool stopping = false;
+    uint64_t budget_left = 0;
+    // Budget held by each enabled pack that has been read: what was read of it, or everything
+    // it may still read while in progress. Given back when the pack is disabled.
+    std::unordered_map<std::filesystem::path::string_type, uint64_t> charged;
+};
+
+Worker worker;
+
+uint64_t default_budget() {
+#if defined(_WIN32)
+    MEMORYSTATUSEX status{};
+    status.dwLength = sizeof(status);
+    const uint64_t physical = GlobalMemoryStatusEx(&status) ? status.ullTotalPhys : 0;
+#else
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    const long page_size = sysconf(_SC_PAGESIZE);
+    const uint64_t physical = (pages > 0 && page_size > 0) ? uint64_t(pages) * uint64_t(page_size) : 0;
+#endif
+    return std::min(physical / 4, max_budget_bytes);
+}
+
+bool cancelled() {
+    std::lock_guard lock(worker.mutex);
+    return worker.cancel_current || worker.stopping;
+}
+
+// Reads [begin, end) in chunks, adding what it read to read_bytes. Returns false if the pack
+// was cancelled or the read failed.
+bool read_range(std::FILE* file, std::vector<char>& buffer, uint64_t begin, uint64_t end, uint64_t& read_bytes) {
+    if (begin >= end) {
+        return true;
+    }
+#if defined(_WIN32)
+    if (_fseeki64(file, static_cast<int64_t>(begin), SEEK_SET) != 0) {
+#else
+    if (fseeko(file, static_cast<off_t>(begin), SEEK_SET) != 0) {
+#endif
+        return false;
+    }
+    for (uint64_t offset = begin; offset < end; offset += chunk_bytes) {
+        if (cancelled()) {
+            return false;
+        }
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(chunk_bytes, end - offset));
+        if (std::fread(buffer.data(), 1, count, file) != count) {
+            return false;
+        }
+        read_bytes += count;
+    }
+    return true;
+}
+
+void warm_pack(const std::filesystem::path& path, std::vector<char>& buffer) {
+    std::error_code ec;
+    const uint64_t size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        return;
+    }
+
+    uint64_t budget;
+    {
+        std::lock_guard lock(worker.mutex);
+        budget = std::min(size, worker.budget_left);
+        worker.budget_left -= budget;
+        worker.charged[path.native()] = budget;
+    }
+    if (budget == 0) {
+        printf("[TEXTURE PACK] read-ahead budget used up, not warming %s\n", path.filename().string().c_str());
+        fflush(stdout);
+        return;
+    }
+
+    uint64_t read_bytes = 0;
+    // Keeps only what was read charged, unless cancel() has already given it all back.
+    const auto settle = [&] {
+        std::lock_guard lock(worker.mutex);
+        auto it = worker.charged.find(path.native());
+        if (it != worker.charged.end()) {
+            worker.budget_left += it->second - read_bytes;
+            it->second = read_bytes;
+        }
+    };
+
+    std::FILE* file = std::fopen(path.string().c_str(), "rb");
+    if (file == nullptr) {
+        settle();
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    // End first for the central directory, then from the start as far as the budget goes.
+    const uint64_t tail_begin = size - std::min({ size, tail_bytes, budget });
+    const uint64_t head_end = std::min(tail_begin, budget - (size - tail_begin));
+    const bool completed = read_range(file, buffer, tail_begin, size, read_bytes)
+        && read_range(file, buffer, 0, head_end, read_bytes);
+    std::fclose(file);
+    settle();
+
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    printf("[TEXTURE PACK] %s %s: %" PRIu64 " of %" PRIu64 " MiB in %lld ms\n", completed ? "warmed" : "stopped warming",
+        path.filename().string().c_str(), read_bytes >> 20, size >> 20, static_cast<long long>(ms));
+    fflush(stdout);
+}
+
+void worker_main() {
+#if defined(_WIN32)
+    // Also lowers the thread's I/O priority, so the game's own reads go first.
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#endif
+    std::vector<char> buffer(chunk_bytes);
+    std::unique_lock lock(worker.mutex);
+    while (true) {
+        worker.queue_ready.wait(lock, [] { return !worker.queue.empty() || worker.stopping; });
+        if (worker.stopping) {
+            return;
+        }
+        worker.current = std::move(worker.queue.front());
+        worker.queue.pop_front();
+        worker.cancel_current = false;
+        const std::filesystem::path path = worker.current;
+        lock.unlock();
+
+        warm_pack(path, buffer);
+
+        lock.lock();
+        worker.current.clear();
+    }
+}
+
+} // namespace
+
+void warm(const std::filesystem::path& path) {
+    std::lock_guard lock(worker.mutex);
+    if (!worker.thread.joinable()) {
+        worker.budget_left = default_budget();
+        worker.stopping = false;
+        worker.thread = std::thread(worker_main);
+    }
+    // Already read, being read or queued.
+    const bool in_progress = (worker.current == path) && !worker.cancel_current;
+    if (in_progress || worker.charged.count(path.native()) != 0
+        || std::find(worker.queue.begin(), worker.queue.end(), path) != worker.queue.end()) {
+        return;
+    }
+    worker.queue.push_back(path);
+    worker.queue_ready.notify_one();
+}
+
+void cancel(const std::filesystem::path& path) {
+    std::lock_guard lock(worker.mutex);
+    worker.queue.erase(std::remove(worker.queue.begin(), worker.queue.end(), path), worker.queue.end());
+    if (worker.current == path) {
+        worker.cancel_current = true;
+    }
+    auto it = worker.charged.find(path.native());
+    if (it != worker.charged.end()) {
+        worker.budget_left += it->second;
+        worker.charged.erase(it);
+    }
+}
+
+void shutdown() {
+    {
+        std::lock_guard lock(worker.mutex);
+        worker.stopping = true;
+        worker.queue.clear();
+        worker.queue_ready.notify_one();
+    }
+    if (worker.thread.joinable()) {
+        worker.thread.join();
+    }
+}
+
+} // namespace sssv::texture_pack_warmer
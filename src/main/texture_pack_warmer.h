@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+// Reads enabled .rtz texture packs into the OS file cache on a background thread, so RT64's
+// texture streaming finds them in memory instead of waiting on the disk when a level first asks
+// for its textures. Each pack's end is read first, since the zip central directory is there.
+//
+// This does not make enabling a pack any faster: RT64 still opens and indexes the pack inside
+// the enable call, on the caller's thread. The read-ahead is queued once that call returns,
+// so it does not compete with it for the disk.
+//
+// The cache belongs to the OS, which evicts the least recently used pages under pressure, so
+// the only limit kept here is a budget on how much is read ahead: a quarter of physical memory,
+// at most 4 GiB, held by the enabled packs in the order they were enabled. Disabling a pack
+// gives its share back.
+namespace sssv::texture_pack_warmer {
+    // Any thread; returns at once. Does nothing for a pack already read, being read or queued.
+    void warm(const std::filesystem::path& path);
+    // For a disabled pack: stops reading it and returns its budget.
+    void cancel(const std::filesystem::path& path);
+    void shutdown();
+} // namespace sssv::texture_pack_warmer
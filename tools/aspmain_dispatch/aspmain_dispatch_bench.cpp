@@ -0,0 +1,208 @@
+// Runs synthetic audio tasks through the recompiled aspMain twice, once with the direct-threaded
+// command dispatch and once with every indirect jump going through the generated switch, and
+// reports ns per task and per command for each. Both builds must leave identical DMEM and RDRAM.
+//
+// The "noop" list is nothing but A_SPNOOP, so it measures the dispatch alone. The "audio" list
+// is a few voices of the usual ADPCM -> RESAMPLE -> ENVMIXER chain followed by a mix, an
+// interleave and a save. DMEM only holds the jump table, not the ucode's real constants, so
+// the samples it produces are meaningless; the control flow is the same.
+//
+// Usage: AspMainDispatchBench [--list noop|audio] [--tasks N] [--iterations N]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "librecomp/rsp.hpp"
+#include "sssv_aspmain.h"
+
+RspExitReason aspMain(uint8_t* rdram, uint32_t ucode_addr);
+RspExitReason aspMain_switch(uint8_t* rdram, uint32_t ucode_addr);
+
+namespace {
+
+// The ucode masks DMA addresses to 24 bits.
+constexpr size_t kRdramBytes = 16 * 1024 * 1024;
+constexpr uint32_t kDmemBytes = 0x1000;
+constexpr uint32_t kCommandListAddr = 0x100000;
+constexpr uint32_t kSampleAddr = 0x200000;
+constexpr uint32_t kStateAddr = 0x300000;
+constexpr uint32_t kOutputAddr = 0x400000;
+
+enum Opcode : uint32_t {
+	A_SPNOOP = 0,
+	A_ADPCM = 1,
+	A_CLEARBUFF = 2,
+	A_ENVMIXER = 3,
+	A_LOADBUFF = 4,
+	A_RESAMPLE = 5,
+	A_SAVEBUFF = 6,
+	A_SEGMENT = 7,
+	A_SETBUFF = 8,
+	A_SETVOL = 9,
+	A_LOADADPCM = 11,
+	A_MIXER = 12,
+	A_INTERLEAVE = 13,
+};
+
+struct Command {
+	uint32_t w1;
+	uint32_t w2;
+};
+
+constexpr uint32_t op(uint32_t opcode, uint32_t flags, uint32_t low) {
+	return (opcode << 24) | ((flags & 0xFF) << 16) | (low & 0xFFFF);
+}
+
+constexpr uint32_t pair(uint32_t hi, uint32_t lo) {
+	return ((hi & 0xFFFF) << 16) | (lo & 0xFFFF);
+}
+
+// Buffer offsets are relative to DMEM 0x5C0. Every vector buffer stays 16-byte aligned.
+std::vector<Command> audio_list(int voices) {
+	std::vector<Command> list;
+	list.push_back({ op(A_SEGMENT, 0, 0), 0x00000000 });
+	list.push_back({ op(A_LOADADPCM, 0, 0x20), kSampleAddr });
+	list.push_back({ op(A_CLEARBUFF, 0, 0x400), 0x500 });
+	for (int v = 0; v < voices; v++) {
+		const uint32_t state = kStateAddr + static_cast<uint32_t>(v) * 0x100;
+		// Compressed frames in, 0x100 bytes of PCM out.
+		list.push_back({ op(A_SETBUFF, 0, 0x000), pair(0x170, 0x90) });
+		list.push_back({ op(A_LOADBUFF, 0, 0), kSampleAddr + 0x1000 + static_cast<uint32_t>(v) * 0x100 });
+		list.push_back({ op(A_SETBUFF, 0, 0x000), pair(0x170, 0x100) });
+		list.push_back({ op(A_ADPCM, 0x01, 0), state });
+		// Resample at 0.75 into 0x140 bytes.
+		list.push_back({ op(A_SETBUFF, 0, 0x190), pair(0x2B0, 0x140) });
+		list.push_back({ op(A_RESAMPLE, 0x01, 0xC000), state + 0x20 });
+		// Envelope into dry and wet left/right.
+		list.push_back({ op(A_SETVOL, 0x06, 0x4000), 0 });
+		list.push_back({ op(A_SETVOL, 0x04, 0x3000), 0 });
+		list.push_back({ op(A_SETVOL, 0x02, 0x7000), pair(0x0001, 0x0200) });
+		list.push_back({ op(A_SETVOL, 0x00, 0x6000), pair(0x0000, 0xF000) });
+		list.push_back({ op(A_SETVOL, 0x08, 0x7000), 0x2000 });
+		list.push_back({ op(A_SETBUFF, 0, 0x2B0), pair(0x400, 0x140) });
+		list.push_back({ op(A_SETBUFF, 0x08, 0x540), pair(0x680, 0x7C0) });
+		list.push_back({ op(A_ENVMIXER, 0x09, 0), state + 0x40 });
+	}
+	list.push_back({ op(A_MIXER, 0, 0x4000), pair(0x680, 0x400) });
+	list.push_back({ op(A_MIXER, 0, 0x4000), pair(0x7C0, 0x540) });
+	list.push_back({ op(A_SETBUFF, 0, 0x000), pair(0x000, 0x140) });
+	list.push_back({ op(A_INTERLEAVE, 0, 0), pair(0x400, 0x540) });
+	list.push_back({ op(A_SETBUFF, 0, 0x000), pair(0x000, 0x280) });
+	list.push_back({ op(A_SAVEBUFF, 0, 0), kOutputAddr });
+	return list;
+}
+
+std::vector<Command> noop_list(int count) {
+	return std::vector<Command>(static_cast<size_t>(count), Command{ op(A_SPNOOP, 0, 0), 0 });
+}
+
+// RDRAM and DMEM hold big-endian memory word-swapped, so the host's words are the N64's words.
+void write_dmem_u16(uint8_t* mem, uint32_t addr, uint16_t value) {
+	std::memcpy(mem + ((addr ^ 2) & (kDmemBytes - 1)), &value, sizeof(value));
+}
+
+void write_dmem_u32(uint8_t* mem, uint32_t addr, uint32_t value) {
+	std::memcpy(mem + (addr & (kDmemBytes - 1)), &value, sizeof(value));
+}
+
+struct Fixture {
+	std::vector<uint8_t> rdram;
+	std::vector<uint8_t> dmem_image;
+};
+
+Fixture make_fixture(const std::vector<Command>& list) {
+	Fixture f;
+	f.rdram.assign(kRdramBytes, 0);
+	uint32_t seed = 0x12345678;
+	for (uint32_t i = 0; i < 0x10000; i++) {
+		seed = seed * 1664525u + 1013904223u;
+		f.rdram[kSampleAddr + i] = static_cast<uint8_t>(seed >> 24);
+	}
+	for (size_t i = 0; i < list.size(); i++) {
+		std::memcpy(f.rdram.data() + kCommandListAddr + i * 8, &list[i].w1, 4);
+		std::memcpy(f.rdram.data() + kCommandListAddr + i * 8 + 4, &list[i].w2, 4);
+	}
+
+	// Ucode data (jump table only) and the OSTask's data_ptr/data_size at DMEM 0xFC0.
+	f.dmem_image.assign(kDmemBytes, 0);
+	for (size_t i = 0; i < sssv::aspmain::kCommandCount; i++) {
+		write_dmem_u16(f.dmem_image.data(), sssv::aspmain::kJumpTableAddr + static_cast<uint32_t>(i) * 2,
+			static_cast<uint16_t>(sssv::aspmain::command_targets[i] & 0xFFF));
+	}
+	write_dmem_u32(f.dmem_image.data(), 0xFC0 + 0x30, kCommandListAddr);
+	write_dmem_u32(f.dmem_image.data(), 0xFC0 + 0x34, static_cast<uint32_t>(list.size() * 8));
+	return f;
+}
+
+struct RunResult {
+	uint64_t best_ns = UINT64_MAX;
+	bool ok = true;
+	std::vector<uint8_t> dmem_after;
+	std::vector<uint8_t> rdram_after;
+};
+
+RunResult run(RspUcodeFunc* ucode, const Fixture& fixture, int tasks, int iterations) {
+	RunResult result;
+	std::vector<uint8_t> rdram = fixture.rdram;
+	for (int it = 0; it < iterations; it++) {
+		const auto start = std::chrono::steady_clock::now();
+		for (int t = 0; t < tasks; t++) {
+			std::memcpy(dmem, fixture.dmem_image.data(), kDmemBytes);
+			if (ucode(rdram.data(), 0) != RspExitReason::Broke) {
+				result.ok = false;
+			}
+		}
+		const uint64_t elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - start).count());
+		result.best_ns = std::min(result.best_ns, elapsed);
+	}
+	result.dmem_after.assign(dmem, dmem + kDmemBytes);
+	result.rdram_after = std::move(rdram);
+	return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	bool audio = true;
+	int tasks = 2000;
+	int iterations = 5;
+	for (int i = 1; i < argc; i++) {
+		if ((std::strcmp(argv[i], "--list") == 0) && ((i + 1) < argc)) {
+			audio = std::strcmp(argv[++i], "noop") != 0;
+		} else if ((std::strcmp(argv[i], "--tasks") == 0) && ((i + 1) < argc)) {
+			tasks = std::max(1, std::atoi(argv[++i]));
+		} else if ((std::strcmp(argv[i], "--iterations") == 0) && ((i + 1) < argc)) {
+			iterations = std::max(1, std::atoi(argv[++i]));
+		} else {
+			std::fprintf(stderr, "Usage: %s [--list noop|audio] [--tasks N] [--iterations N]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	const std::vector<Command> list = audio ? audio_list(4) : noop_list(1024);
+	const Fixture fixture = make_fixture(list);
+	const double commands = static_cast<double>(tasks) * static_cast<double>(list.size());
+
+	std::printf("list: %s (%zu commands), %d tasks x %d iterations\n", audio ? "audio" : "noop", list.size(), tasks, iterations);
+	const RunResult threaded = run(aspMain, fixture, tasks, iterations);
+	const RunResult switched = run(aspMain_switch, fixture, tasks, iterations);
+	const auto report = [&](const char* name, const RunResult& r) {
+		std::printf("  %-8s %10.1f ns/task %8.2f ns/command%s\n", name,
+			static_cast<double>(r.best_ns) / tasks, static_cast<double>(r.best_ns) / commands,
+			r.ok ? "" : " (ucode did not finish with break)");
+	};
+	report("threaded", threaded);
+	report("switch", switched);
+	std::printf("speedup: %.3fx\n", static_cast<double>(switched.best_ns) / static_cast<double>(threaded.best_ns));
+
+	if ((threaded.dmem_after != switched.dmem_after) || (threaded.rdram_after != switched.rdram_after)) {
+		std::fprintf(stderr, "threaded and switch dispatch produced different DMEM/RDRAM\n");
+		return 2;
+	}
+	return (threaded.ok && switched.ok) ? 0 : 2;
+}
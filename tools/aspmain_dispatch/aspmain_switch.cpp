@@ -0,0 +1,8 @@
+// The recompiled aspMain with every indirect jump going through the generated switch, for
+// comparison against the direct-threaded build in the same benchmark binary. Includes the
+// build-time patched copy (cmake/PatchAspMain.cmake); the source tree's rsp/aspMain.cpp has
+// neither dispatch mode's edits.
+
+#define ASPMAIN_SWITCH_DISPATCH
+#define aspMain aspMain_switch
+#include "aspMain.patched.cpp"
@@ -0,0 +1,149 @@
+// Replays an audio capture (Debug tab > Audio Capture) through the recompiled aspMain and the
+// audio HLE, and reports ns per task, audio frames (tasks) per second and a hash over every
+// task's output ranges for each. A task whose output does not hash to the value recorded in
+// the game is counted as a mismatch, so this doubles as the conformance check for changes to
+// either path.
+//
+// Every task starts from its captured DMEM image and RDRAM inputs, so tasks are independent
+// and their order only matters for cache behaviour.
+//
+// Usage: AudioReplayBench <capture.bin> [--iterations N] [--variant lle|hle|all]
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "librecomp/rsp.hpp"
+#include "sssv_audio_capture.h"
+#include "sssv_audio_hle.h"
+
+RspExitReason aspMain(uint8_t* rdram, uint32_t ucode_addr);
+
+namespace capture = sssv::audio_hle::capture;
+
+namespace {
+
+// The ucode masks DMA addresses to 24 bits.
+constexpr size_t kRdramBytes = 16 * 1024 * 1024;
+
+struct Variant {
+	const char* name;
+	RspUcodeFunc* run;
+};
+
+RspExitReason run_hle(uint8_t* rdram, uint32_t ucode_addr) {
+	return sssv::audio_hle::run_task(rdram, ucode_addr);
+}
+
+constexpr Variant kVariants[] = {
+	{ "lle", aspMain },
+	{ "hle", run_hle },
+};
+
+struct RunResult {
+	uint64_t best_ns = UINT64_MAX;
+	uint64_t hash = 0;
+	size_t mismatched = 0;
+	size_t first_mismatch = 0;
+};
+
+RunResult run(const Variant& variant, const std::vector<capture::TaskRecord>& tasks, std::vector<uint8_t>& rdram, int iterations) {
+	RunResult result;
+	for (int it = 0; it < iterations; it++) {
+		uint64_t elapsed = 0;
+		uint64_t hash = 0xCBF29CE484222325ull;
+		size_t mismatched = 0;
+		for (size_t t = 0; t < tasks.size(); t++) {
+			const capture::TaskRecord& task = tasks[t];
+			capture::apply_task(rdram.data(), dmem, task);
+			const auto start = std::chrono::steady_clock::now();
+			variant.run(rdram.data(), 0);
+			elapsed += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - start).count());
+
+			const uint64_t task_hash = capture::hash_outputs(rdram.data(), task.outputs);
+			if (task_hash != task.output_hash) {
+				if (mismatched++ == 0) {
+					result.first_mismatch = t;
+				}
+			}
+			hash = (hash ^ task_hash) * 0x100000001B3ull;
+		}
+		result.best_ns = std::min(result.best_ns, elapsed);
+		result.hash = hash;
+		result.mismatched = mismatched;
+	}
+	return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::fprintf(stderr, "Usage: %s <capture.bin> [--iterations N] [--variant lle|hle|all]\n", argv[0]);
+		return 1;
+	}
+
+	const char* path = argv[1];
+	int iterations = 5;
+	const char* only = nullptr;
+	for (int i = 2; i < argc; i++) {
+		if ((std::strcmp(argv[i], "--iterations") == 0) && ((i + 1) < argc)) {
+			iterations = std::max(1, std::atoi(argv[++i]));
+		} else if ((std::strcmp(argv[i], "--variant") == 0) && ((i + 1) < argc)) {
+			only = argv[++i];
+			if (std::strcmp(only, "all") == 0) {
+				only = nullptr;
+			}
+		} else {
+			std::fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	std::vector<capture::TaskRecord> tasks;
+	if (!capture::load(path, tasks)) {
+		std::fprintf(stderr, "Failed to load capture %s\n", path);
+		return 1;
+	}
+	if (tasks.empty()) {
+		std::fprintf(stderr, "Capture %s contains no audio tasks\n", path);
+		return 1;
+	}
+
+	size_t input_bytes = 0;
+	for (const capture::TaskRecord& task : tasks) {
+		input_bytes += task.input_bytes.size();
+	}
+	std::printf("capture: %s (%zu tasks, %.1f KB RDRAM input per task)\n", path, tasks.size(),
+		static_cast<double>(input_bytes) / 1024.0 / static_cast<double>(tasks.size()));
+
+	sssv::audio_hle::set_enabled(true);
+	std::vector<uint8_t> rdram(kRdramBytes, 0);
+	bool ok = true;
+	bool ran = false;
+	for (const Variant& variant : kVariants) {
+		if ((only != nullptr) && (std::strcmp(only, variant.name) != 0)) {
+			continue;
+		}
+		ran = true;
+		const RunResult r = run(variant, tasks, rdram, iterations);
+		const double ns_per_task = static_cast<double>(r.best_ns) / static_cast<double>(tasks.size());
+		std::printf("  %-4s %10.1f ns/task %12.0f frames/s  hash %016" PRIx64, variant.name, ns_per_task, 1e9 / ns_per_task, r.hash);
+		if (r.mismatched != 0) {
+			std::printf("  %zu tasks mismatched, first %zu\n", r.mismatched, r.first_mismatch);
+			ok = false;
+		} else {
+			std::printf("  ok\n");
+		}
+	}
+	if (!ran) {
+		std::fprintf(stderr, "Unknown variant: %s\n", only);
+		return 1;
+	}
+	return ok ? 0 : 2;
+}
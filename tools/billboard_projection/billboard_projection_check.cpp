@@ -0,0 +1,184 @@
+// Checks that project_billboards_x4 (include/sssv_billboard_projection.h) returns the same
+// bits as project_billboard_scalar, lane by lane, on edge inputs: zero and extreme 16.16
+// coordinates, cam_z at, near and across zero, signed zeros, denormals, infinities and NaNs
+// in the matrix, plus a run of random matrices and positions. NaN results only need to
+// match as NaNs.
+//
+// Usage: BillboardProjectionCheck [--random N]
+// Exits non-zero on the first mismatch.
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "sssv_billboard_projection.h"
+
+using namespace sssv::billboard;
+
+namespace {
+
+struct Position {
+	int32_t x;
+	int32_t y;
+	int32_t z;
+};
+
+struct Matrix {
+	float m[16];
+};
+
+uint64_t s_checked = 0;
+
+bool check_batch(const Matrix& mtx, const BillboardProjectInputX4& in) {
+	BillboardProjectionX4 simd;
+	project_billboards_x4(mtx.m, in, simd);
+	for (int i = 0; i < kProjectLanes; i++) {
+		const BillboardProjection ref = project_billboard_scalar(
+			mtx.m, in.world_x[i], in.world_y[i], in.world_z[i], in.screen_off_x[i], in.screen_off_y[i]);
+		s_checked++;
+		if (same_float_bits(ref.cam_z, simd.cam_z[i]) && same_float_bits(ref.clip_w, simd.clip_w[i])
+			&& same_float_bits(ref.center_x, simd.center_x[i]) && same_float_bits(ref.center_y, simd.center_y[i])) {
+			continue;
+		}
+		std::printf("MISMATCH lane %d xyz=(%d,%d,%d) screen_off=(%a,%a)\n", i,
+			in.world_x[i], in.world_y[i], in.world_z[i], in.screen_off_x[i], in.screen_off_y[i]);
+		std::printf("  matrix:");
+		for (float v : mtx.m) {
+			std::printf(" %a", v);
+		}
+		std::printf("\n  scalar: cam_z=%a clip_w=%a center=(%a,%a)\n", ref.cam_z, ref.clip_w, ref.center_x, ref.center_y);
+		std::printf("  simd:   cam_z=%a clip_w=%a center=(%a,%a)\n", simd.cam_z[i], simd.clip_w[i], simd.center_x[i], simd.center_y[i]);
+		return false;
+	}
+	return true;
+}
+
+// Every position in every lane, rotated so each value lands in each lane.
+bool check_positions(const Matrix& mtx, const std::vector<Position>& positions) {
+	for (size_t base = 0; base < positions.size(); base++) {
+		BillboardProjectInputX4 in;
+		for (int i = 0; i < kProjectLanes; i++) {
+			const Position& p = positions[(base + i) % positions.size()];
+			in.world_x[i] = p.x;
+			in.world_y[i] = p.y;
+			in.world_z[i] = p.z;
+			in.screen_off_x[i] = 640.0f + static_cast<float>(i);
+			in.screen_off_y[i] = 480.0f - static_cast<float>(i);
+		}
+		if (!check_batch(mtx, in)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// A typical perspective view-projection in the layout the rewrite reads (row 2 gives
+// camera-space Z, row 3 the projection scale and depth terms).
+Matrix game_like_matrix() {
+	Matrix mtx = { {
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, -100.0f,
+		-320.0f, 240.0f, -1.0f, -20.0f,
+	} };
+	return mtx;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	int random_batches = 100000;
+	for (int i = 1; i < argc; i++) {
+		if ((std::strcmp(argv[i], "--random") == 0) && ((i + 1) < argc)) {
+			random_batches = std::max(0, std::atoi(argv[++i]));
+		} else {
+			std::fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	constexpr float kInf = std::numeric_limits<float>::infinity();
+	constexpr float kNan = std::numeric_limits<float>::quiet_NaN();
+	constexpr float kDenorm = std::numeric_limits<float>::denorm_min();
+	constexpr int32_t kMin = std::numeric_limits<int32_t>::min();
+	constexpr int32_t kMax = std::numeric_limits<int32_t>::max();
+
+	const std::vector<Position> positions = {
+		{ 0, 0, 0 },
+		{ 1, -1, 1 },
+		{ 65536, 65536, 65536 },
+		{ 100 << 16, 0, 0 },          // cam_z exactly zero with the game-like matrix
+		{ 0, 0, (100 << 16) + 1 },    // just across zero
+		{ 0, 0, (100 << 16) - 1 },
+		{ 0, 0, (97 << 16) },         // at the behind-camera threshold
+		{ kMin, kMin, kMin },
+		{ kMax, kMax, kMax },
+		{ kMin, kMax, 0 },
+		{ 0x7FFF0000, -0x7FFF0000, 0x00008000 },
+		{ 12345678, -87654321, 23456789 },
+	};
+
+	std::vector<Matrix> matrices = { game_like_matrix() };
+	{
+		Matrix zero = {};
+		matrices.push_back(zero);
+		Matrix neg_zero = game_like_matrix();
+		neg_zero.m[11] = -0.0f;
+		neg_zero.m[10] = -0.0f;
+		matrices.push_back(neg_zero);
+		Matrix denorm = game_like_matrix();
+		denorm.m[8] = kDenorm;
+		denorm.m[9] = -kDenorm;
+		denorm.m[12] = kDenorm;
+		matrices.push_back(denorm);
+		Matrix inf = game_like_matrix();
+		inf.m[3] = kInf;
+		inf.m[14] = -kInf;
+		matrices.push_back(inf);
+		Matrix nan = game_like_matrix();
+		nan.m[7] = kNan;
+		nan.m[15] = kNan;
+		matrices.push_back(nan);
+		Matrix huge = game_like_matrix();
+		for (float& v : huge.m) {
+			v *= 1e30f;
+		}
+		matrices.push_back(huge);
+	}
+
+	for (const Matrix& mtx : matrices) {
+		if (!check_positions(mtx, positions)) {
+			return 1;
+		}
+	}
+
+	std::mt19937 rng(0x5353u);
+	std::uniform_real_distribution<float> element(-4.0f, 4.0f);
+	std::uniform_int_distribution<int32_t> coord(-(4096 << 16), 4096 << 16);
+	for (int b = 0; b < random_batches; b++) {
+		Matrix mtx;
+		for (float& v : mtx.m) {
+			v = element(rng);
+		}
+		mtx.m[11] *= 100.0f;
+		BillboardProjectInputX4 in;
+		for (int i = 0; i < kProjectLanes; i++) {
+			in.world_x[i] = coord(rng);
+			in.world_y[i] = coord(rng);
+			in.world_z[i] = coord(rng);
+			in.screen_off_x[i] = 640.0f;
+			in.screen_off_y[i] = 480.0f;
+		}
+		if (!check_batch(mtx, in)) {
+			return 1;
+		}
+	}
+
+	std::printf("OK: %" PRIu64 " projections bit-identical\n", s_checked);
+	return 0;
+}